@@ -0,0 +1,104 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <config.h>
+
+#include "batchrunner.h"
+#include "document.h"
+#include "collections/collectioninitializer.h"
+#include "images/imagefactory.h"
+
+#include <KAboutData>
+#include <KLocalizedString>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QTextStream>
+
+#include <cstdio>
+
+int main(int argc, char* argv[]) {
+  // nothing is ever shown, so don't require a display
+  if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  QApplication app(argc, argv);
+  KLocalizedString::setApplicationDomain("tellico");
+  app.setApplicationVersion(QStringLiteral(TELLICO_VERSION));
+
+  // use the same component name as the main application, for the config and data files
+  KAboutData aboutData(QStringLiteral("tellico"), i18n("Tellico Batch"),
+                       QStringLiteral(TELLICO_VERSION), i18n("Convert, merge, filter, and export Tellico collections"),
+                       KAboutLicense::GPL_V2,
+                       i18n("(c) 2001-2019, Robby Stephenson"),
+                       QString(),
+                       QStringLiteral("https://tellico-project.org"));
+  aboutData.addAuthor(QStringLiteral("Robby Stephenson"), QString(), QStringLiteral("robby@periapsis.org"));
+  aboutData.addLicense(KAboutLicense::GPL_V3);
+  KAboutData::setApplicationData(aboutData);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(aboutData.shortDescription() + QLatin1Char('\n') +
+    i18n("Commands are run in order:\n"
+         "  open FILE\n"
+         "  import|append|merge FORMAT FILE\n"
+         "  filter FIELD FUNCTION TEXT\n"
+         "  save FILE\n"
+         "  export FORMAT FILE\n"
+         "Import formats: %1\n"
+         "Export formats: %2\n"
+         "Filter functions: contains, notcontains, equals, notequals, regexp, notregexp, "
+         "before, after, less, greater. A field of * matches any field.",
+         Tellico::BatchRunner::importFormats().join(QLatin1String(", ")),
+         Tellico::BatchRunner::exportFormats().join(QLatin1String(", "))));
+  parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("script"),
+                                      i18n("Read the commands from <file>, or - for standard input"),
+                                      QStringLiteral("file")));
+  parser.addPositionalArgument(QStringLiteral("commands"), i18n("Commands to run"),
+                               QStringLiteral("[command [arguments]...]"));
+  aboutData.setupCommandLine(&parser);
+  parser.process(app);
+  aboutData.processCommandLine(&parser);
+
+  Tellico::BatchRunner runner;
+  const bool ok = parser.isSet(QStringLiteral("script"))
+                ? runner.readScript(parser.value(QStringLiteral("script")))
+                : runner.setCommands(parser.positionalArguments());
+  if(!ok) {
+    QTextStream(stderr) << runner.errorString() << endl;
+    return 2;
+  }
+
+  Tellico::CollectionInitializer initCollections;
+  Tellico::ImageFactory::init();
+
+  const bool success = runner.run();
+  if(!success) {
+    QTextStream(stderr) << runner.errorString() << endl;
+  }
+
+  Tellico::ImageFactory::clean(true);
+  return success ? 0 : 1;
+}
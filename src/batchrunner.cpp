@@ -0,0 +1,388 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "batchrunner.h"
+#include "document.h"
+#include "collection.h"
+#include "collectionfactory.h"
+#include "filter.h"
+#include "translators/tellicoimporter.h"
+#include "translators/bibteximporter.h"
+#include "translators/bibtexmlimporter.h"
+#include "translators/xsltimporter.h"
+#include "translators/risimporter.h"
+#include "translators/gcstarimporter.h"
+#include "translators/tellicoxmlexporter.h"
+#include "translators/tellicozipexporter.h"
+#include "translators/bibtexexporter.h"
+#include "translators/bibtexmlexporter.h"
+#include "translators/csvexporter.h"
+#include "translators/htmlexporter.h"
+#include "translators/onixexporter.h"
+#include "translators/gcstarexporter.h"
+#include "utils/datafileregistry.h"
+#include "core/tellico_strings.h"
+#include "tellico_debug.h"
+
+#include <KLocalizedString>
+#include <KSharedConfig>
+#include <KConfigGroup>
+#include <KShell>
+
+#include <QFile>
+#include <QTextStream>
+#include <QDir>
+#include <QScopedPointer>
+
+#include <cstdio>
+
+using Tellico::BatchRunner;
+
+BatchRunner::BatchRunner() {
+}
+
+bool BatchRunner::setCommands(const QStringList& args_) {
+  m_commands.clear();
+  for(int i = 0; i < args_.count(); ) {
+    Command command;
+    command.name = args_.at(i).toLower();
+    const int count = argumentCount(command.name);
+    if(count < 0) {
+      m_errorString = i18n("Unknown command - %1", args_.at(i));
+      return false;
+    }
+    if(i + count >= args_.count()) {
+      m_errorString = i18n("The %1 command needs %2 arguments.", command.name, count);
+      return false;
+    }
+    command.args = args_.mid(i + 1, count);
+    m_commands << command;
+    i += count + 1;
+  }
+  return true;
+}
+
+bool BatchRunner::readScript(const QString& fileName_) {
+  QFile file(fileName_);
+  // a dash reads the script from standard input
+  const bool opened = fileName_ == QLatin1String("-") ? file.open(stdin, QIODevice::ReadOnly | QIODevice::Text)
+                                                      : file.open(QIODevice::ReadOnly | QIODevice::Text);
+  if(!opened) {
+    m_errorString = i18n(errorOpen, fileName_);
+    return false;
+  }
+  QStringList args;
+  QTextStream ts(&file);
+  ts.setCodec("UTF-8");
+  while(!ts.atEnd()) {
+    const QString line = ts.readLine().trimmed();
+    if(line.isEmpty() || line.startsWith(QLatin1Char('#'))) {
+      continue;
+    }
+    KShell::Errors err;
+    const QStringList lineArgs = KShell::splitArgs(line, KShell::NoOptions, &err);
+    if(err != KShell::NoError) {
+      m_errorString = i18n("Unable to parse the script line - %1", line);
+      return false;
+    }
+    args += lineArgs;
+  }
+  return setCommands(args);
+}
+
+bool BatchRunner::run() {
+  foreach(const Command& command, m_commands) {
+    if(!runCommand(command)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BatchRunner::runCommand(const Command& command_) {
+  const QString& name = command_.name;
+  const QStringList& args = command_.args;
+  if(name == QLatin1String("open")) {
+    return openFile(args.at(0));
+  } else if(name == QLatin1String("import")) {
+    return importFile(Import::Replace, args.at(0), args.at(1));
+  } else if(name == QLatin1String("append")) {
+    return importFile(Import::Append, args.at(0), args.at(1));
+  } else if(name == QLatin1String("merge")) {
+    return importFile(Import::Merge, args.at(0), args.at(1));
+  } else if(name == QLatin1String("filter")) {
+    return filterEntries(args.at(0), args.at(1), args.at(2));
+  } else if(name == QLatin1String("save")) {
+    return saveFile(args.at(0));
+  } else if(name == QLatin1String("export")) {
+    return exportFile(args.at(0), args.at(1));
+  }
+  return false;
+}
+
+bool BatchRunner::openFile(const QString& fileName_) {
+  const QUrl url = fileUrl(fileName_);
+  if(!Data::Document::self()->openDocument(url)) {
+    m_errorString = i18n(errorLoad, url.fileName());
+    return false;
+  }
+  return true;
+}
+
+bool BatchRunner::importFile(Import::Action action_, const QString& format_, const QString& fileName_) {
+  const QUrl url = fileUrl(fileName_);
+  QScopedPointer<Import::Importer> imp(importer(format_, url));
+  if(!imp) {
+    m_errorString = i18n("Unknown import format - %1", format_);
+    return false;
+  }
+  Data::CollPtr current = Data::Document::self()->collection();
+  imp->setCurrentCollection(current);
+  // nothing is shown, and image errors are reported in the status message
+  imp->setOptions(0);
+  Data::CollPtr coll = imp->collection();
+  if(!coll) {
+    m_errorString = imp->statusMessage();
+    if(m_errorString.isEmpty()) {
+      m_errorString = i18n(errorLoad, url.fileName());
+    }
+    return false;
+  }
+
+  if(action_ == Import::Replace) {
+    Data::Document::self()->replaceCollection(coll);
+    return true;
+  }
+  // only append or merge if the types match, but special case importing books into bibliographies
+  if(current->type() != coll->type() &&
+     !(current->type() == Data::Collection::Bibtex && coll->type() == Data::Collection::Book)) {
+    m_errorString = i18n(action_ == Import::Append ? errorAppendType : errorMergeType);
+    return false;
+  }
+  if(action_ == Import::Append) {
+    Data::Document::self()->appendCollection(coll);
+  } else {
+    Data::Document::self()->mergeCollection(coll);
+  }
+  return true;
+}
+
+bool BatchRunner::filterEntries(const QString& fieldName_, const QString& function_, const QString& text_) {
+  Data::CollPtr coll = Data::Document::self()->collection();
+  // an asterisk matches any field, just as an empty field name does in the filter dialog
+  QString fieldName;
+  if(fieldName_ != QLatin1String("*")) {
+    Data::FieldPtr field = coll->fieldByName(fieldName_);
+    if(!field) {
+      field = coll->fieldByTitle(fieldName_);
+    }
+    if(!field) {
+      m_errorString = i18n("Unknown field - %1", fieldName_);
+      return false;
+    }
+    fieldName = field->name();
+  }
+
+  static const char* functions[] = { "contains", "notcontains", "equals", "notequals",
+                                     "regexp", "notregexp", "before", "after", "less", "greater" };
+  int function = -1;
+  for(uint i = 0; i < sizeof(functions)/sizeof(functions[0]); ++i) {
+    if(function_.compare(QLatin1String(functions[i]), Qt::CaseInsensitive) == 0) {
+      function = i;
+      break;
+    }
+  }
+  if(function == -1) {
+    m_errorString = i18n("Unknown filter function - %1", function_);
+    return false;
+  }
+
+  // FilterPtr owns the rule
+  FilterPtr filter(new Filter(Filter::MatchAll));
+  filter->append(new FilterRule(fieldName, text_, static_cast<FilterRule::Function>(function)));
+
+  Data::EntryList nonMatches;
+  foreach(Data::EntryPtr entry, coll->entries()) {
+    if(!filter->matches(entry)) {
+      nonMatches << entry;
+    }
+  }
+  // the remaining commands only see the matching entries
+  coll->removeEntries(nonMatches);
+  return true;
+}
+
+bool BatchRunner::saveFile(const QString& fileName_) {
+  const QUrl url = fileUrl(fileName_);
+  if(!Data::Document::self()->saveDocument(url, true /* force */)) {
+    m_errorString = i18n(errorWrite, url.fileName());
+    return false;
+  }
+  return true;
+}
+
+bool BatchRunner::exportFile(const QString& format_, const QString& fileName_) {
+  Data::CollPtr coll = Data::Document::self()->collection();
+  QScopedPointer<Export::Exporter> exp(exporter(format_, coll));
+  if(!exp) {
+    m_errorString = i18n("Unknown export format - %1", format_);
+    return false;
+  }
+  const QUrl url = fileUrl(fileName_);
+  exp->setURL(url);
+  exp->setEntries(coll->entries());
+  exp->setFields(coll->fields());
+
+  // use the same options as the last export from the export dialog
+  KConfigGroup config(KSharedConfig::openConfig(), "ExportOptions");
+  long options = Export::ExportImages | Export::ExportComplete | Export::ExportForce;
+  if(config.readEntry("FormatFields", false)) {
+    options |= Export::ExportFormatted;
+  }
+  if(config.readEntry("EncodeUTF8", true)) {
+    options |= Export::ExportUTF8;
+  }
+  exp->setOptions(options);
+
+  // a dash streams the export to standard output, for text formats only
+  if(fileName_ == QLatin1String("-")) {
+    QFile out;
+    if(!out.open(stdout, QIODevice::WriteOnly)) {
+      m_errorString = i18n(errorWrite, fileName_);
+      return false;
+    }
+    QTextStream ts(&out);
+    if(options & Export::ExportUTF8) {
+      ts.setCodec("UTF-8");
+    }
+    if(!exp->writeText(ts)) {
+      m_errorString = i18n("The %1 format can not be written to standard output.", format_);
+      return false;
+    }
+    return true;
+  }
+
+  if(!exp->exec()) {
+    m_errorString = i18n(errorWrite, url.fileName());
+    return false;
+  }
+  return true;
+}
+
+// returns -1 for an unknown command
+int BatchRunner::argumentCount(const QString& command_) {
+  if(command_ == QLatin1String("open") || command_ == QLatin1String("save")) {
+    return 1;
+  } else if(command_ == QLatin1String("import") || command_ == QLatin1String("append") ||
+            command_ == QLatin1String("merge") || command_ == QLatin1String("export")) {
+    return 2;
+  } else if(command_ == QLatin1String("filter")) {
+    return 3;
+  }
+  return -1;
+}
+
+QUrl BatchRunner::fileUrl(const QString& fileName_) {
+  return QUrl::fromUserInput(fileName_, QDir::currentPath(), QUrl::AssumeLocalFile);
+}
+
+QStringList BatchRunner::importFormats() {
+  return QStringList() << QStringLiteral("tellico") << QStringLiteral("bibtex") << QStringLiteral("bibtexml")
+                       << QStringLiteral("mods") << QStringLiteral("ris") << QStringLiteral("gcstar");
+}
+
+QStringList BatchRunner::exportFormats() {
+  return QStringList() << QStringLiteral("tellico") << QStringLiteral("xml") << QStringLiteral("bibtex")
+                       << QStringLiteral("bibtexml") << QStringLiteral("csv") << QStringLiteral("html")
+                       << QStringLiteral("onix") << QStringLiteral("gcstar");
+}
+
+Tellico::Import::Importer* BatchRunner::importer(const QString& format_, const QUrl& url_) {
+  const QString format = format_.toLower();
+  if(format == QLatin1String("tellico")) {
+    return new Import::TellicoImporter(url_);
+  } else if(format == QLatin1String("bibtex")) {
+    return new Import::BibtexImporter(QList<QUrl>() << url_);
+  } else if(format == QLatin1String("bibtexml")) {
+    return new Import::BibtexmlImporter(url_);
+  } else if(format == QLatin1String("mods")) {
+    const QString xsltFile = DataFileRegistry::self()->locate(QStringLiteral("mods2tellico.xsl"));
+    if(xsltFile.isEmpty()) {
+      myWarning() << "unable to find mods2tellico.xsl!";
+      return nullptr;
+    }
+    Import::XSLTImporter* imp = new Import::XSLTImporter(url_);
+    imp->setXSLTURL(QUrl::fromLocalFile(xsltFile));
+    return imp;
+  } else if(format == QLatin1String("ris")) {
+    return new Import::RISImporter(QList<QUrl>() << url_);
+  } else if(format == QLatin1String("gcstar")) {
+    return new Import::GCstarImporter(url_);
+  }
+  return nullptr;
+}
+
+Tellico::Export::Exporter* BatchRunner::exporter(const QString& format_, Data::CollPtr coll_) {
+  const QString format = format_.toLower();
+  Export::Exporter* exp = nullptr;
+  if(format == QLatin1String("tellico")) {
+    exp = new Export::TellicoZipExporter(coll_);
+  } else if(format == QLatin1String("xml")) {
+    exp = new Export::TellicoXMLExporter(coll_);
+  } else if(format == QLatin1String("bibtex")) {
+    exp = new Export::BibtexExporter(coll_);
+  } else if(format == QLatin1String("bibtexml")) {
+    exp = new Export::BibtexmlExporter(coll_);
+  } else if(format == QLatin1String("csv")) {
+    exp = new Export::CSVExporter(coll_);
+  } else if(format == QLatin1String("html")) {
+    Export::HTMLExporter* htmlExp = new Export::HTMLExporter(coll_);
+    // there are no views, so use the columns which were last visible in the main window
+    const QString configGroup = QStringLiteral("Options - %1").arg(CollectionFactory::typeName(coll_));
+    KConfigGroup config(KSharedConfig::openConfig(), configGroup);
+    const QStringList columnNames = config.readEntry("ColumnNames", QStringList());
+    const QList<int> columnWidths = config.readEntry("ColumnWidths", QList<int>());
+    QStringList columns;
+    for(int i = 0; i < columnNames.count(); ++i) {
+      // a column width of 0 means hidden
+      if(i < columnWidths.count() && columnWidths.at(i) > 0 && coll_->hasField(columnNames.at(i))) {
+        columns << coll_->fieldTitleByName(columnNames.at(i));
+      }
+    }
+    if(columns.isEmpty()) {
+      columns << coll_->fieldTitleByName(QStringLiteral("title"));
+    }
+    htmlExp->setColumns(columns);
+    htmlExp->setGroupBy(QStringList() << coll_->defaultGroupField());
+    exp = htmlExp;
+  } else if(format == QLatin1String("onix")) {
+    exp = new Export::ONIXExporter(coll_);
+  } else if(format == QLatin1String("gcstar")) {
+    exp = new Export::GCstarExporter(coll_);
+  }
+  if(exp) {
+    exp->readOptions(KSharedConfig::openConfig());
+  }
+  return exp;
+}
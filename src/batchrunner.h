@@ -0,0 +1,105 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_BATCHRUNNER_H
+#define TELLICO_BATCHRUNNER_H
+
+#include "datavectors.h"
+#include "translators/translators.h"
+
+#include <QStringList>
+#include <QUrl>
+
+namespace Tellico {
+  namespace Import {
+    class Importer;
+  }
+  namespace Export {
+    class Exporter;
+  }
+
+/**
+ * The BatchRunner class runs a pipeline of commands on the document, such as opening
+ * a file, merging an import, filtering the entries, and exporting, without any of the
+ * main window, views, or data sources. It is used by the tellico-batch tool.
+ *
+ * Each command is a name followed by a fixed number of arguments:
+ * @li open FILE
+ * @li import|append|merge FORMAT FILE
+ * @li filter FIELD FUNCTION TEXT
+ * @li save FILE
+ * @li export FORMAT FILE
+ *
+ * @author Robby Stephenson
+ */
+class BatchRunner {
+
+public:
+  BatchRunner();
+
+  /**
+   * Parses the command list. The arguments are the command names and their
+   * arguments, all in order.
+   *
+   * @return false if a command is unknown or is missing arguments
+   */
+  bool setCommands(const QStringList& args);
+  /**
+   * Reads the commands from a script file, one command per line. Empty lines and lines
+   * starting with '#' are skipped, and arguments may be quoted as in a shell.
+   */
+  bool readScript(const QString& fileName);
+  /**
+   * Runs every command in turn, stopping at the first one which fails.
+   */
+  bool run();
+  QString errorString() const { return m_errorString; }
+
+  static QStringList importFormats();
+  static QStringList exportFormats();
+
+private:
+  struct Command {
+    QString name;
+    QStringList args;
+  };
+
+  bool runCommand(const Command& command);
+  bool openFile(const QString& fileName);
+  bool importFile(Import::Action action, const QString& format, const QString& fileName);
+  bool filterEntries(const QString& fieldName, const QString& function, const QString& text);
+  bool saveFile(const QString& fileName);
+  bool exportFile(const QString& format, const QString& fileName);
+
+  static int argumentCount(const QString& command);
+  static QUrl fileUrl(const QString& fileName);
+  static Import::Importer* importer(const QString& format, const QUrl& url);
+  static Export::Exporter* exporter(const QString& format, Data::CollPtr coll);
+
+  QList<Command> m_commands;
+  QString m_errorString;
+};
+
+} // end namespace
+#endif
@@ -31,11 +31,19 @@
 #include "utils/string_utils.h"
 #include "utils/stringset.h"
 #include "entrycomparison.h"
+#include "utils/tracer.h"
 #include "tellico_debug.h"
 
 #include <KLocalizedString>
 
 #include <QRegExp>
+#include <QTimer>
+#include <QThread>
+
+namespace {
+  // the number of entries grouped each time through the event loop
+  static const int GROUP_CHUNK_SIZE = 500;
+}
 
 using namespace Tellico;
 using Tellico::Data::Collection;
@@ -43,12 +51,14 @@ using Tellico::Data::Collection;
 const QString Collection::s_peopleGroupName = QStringLiteral("_people");
 
 Collection::Collection(const QString& title_)
-    : QObject(), QSharedData(), m_nextEntryId(1), m_title(title_), m_trackGroups(false) {
+    : QObject(), QSharedData(), m_nextEntryId(1), m_title(title_)
+    , m_valuesRevision(0), m_pendingGroupPos(0), m_groupChunkScheduled(false), m_trackGroups(false) {
   m_id = getID();
 }
 
 Collection::Collection(bool addDefaultFields_, const QString& title_)
-    : QObject(), QSharedData(), m_nextEntryId(1), m_title(title_), m_trackGroups(false) {
+    : QObject(), QSharedData(), m_nextEntryId(1), m_title(title_)
+    , m_valuesRevision(0), m_pendingGroupPos(0), m_groupChunkScheduled(false), m_trackGroups(false) {
   if(m_title.isEmpty()) {
     m_title = i18n("My Collection");
   }
@@ -244,6 +254,11 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
 
   // update name dict
   m_fieldByName.insert(fieldName, newField_.data());
+  // the field might have become derived, the index is rebuilt when needed
+  if(m_valueIndex.remove(fieldName) > 0) {
+    ++m_valuesRevision;
+  }
+  resetSnapshot();
 
   // update titles
   const QString oldTitle = oldField->title();
@@ -285,12 +300,8 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
   // keep track of if the entry groups will need to be reset
   bool resetGroups = false;
 
-  // if format is different, go ahead and invalidate all formatted entry values
+  // if format is different, the formatted entry values get invalidated along with the groups
   if(oldField->formatType() != newField_->formatType()) {
-    // invalidate cached format strings of all entry attributes of this name
-    foreach(EntryPtr entry, m_entries) {
-      entry->invalidateFormattedFieldValue(fieldName);
-    }
     resetGroups = true;
   }
 
@@ -320,11 +331,13 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
 
   bool wasGrouped = oldField->hasFlag(Field::AllowGrouped);
   bool isGrouped = newField_->hasFlag(Field::AllowGrouped);
+  // the entries still point to the groups in a removed dict, so delete it after invalidating
+  EntryGroupDict* oldDict = nullptr;
   if(wasGrouped) {
     if(!isGrouped) {
       // in order to keep list in the same order, don't remove unless new field is not groupable
       m_entryGroups.removeAll(fieldName);
-      delete m_entryGroupDicts.take(fieldName); // no auto-delete here
+      oldDict = m_entryGroupDicts.take(fieldName); // no auto-delete here
       myDebug() << "no longer grouped: " << fieldName;
       resetGroups = true;
     } else {
@@ -350,7 +363,16 @@ bool Collection::modifyField(Tellico::Data::FieldPtr newField_) {
 
   if(resetGroups) {
 //    myLog() << "invalidating groups";
-    invalidateGroups();
+    // only the groups for this field, and the people pseudo-group if it's involved, need to be reset
+    QStringList groupFields = QStringList() << fieldName;
+    if(wasPeople || isPeople) {
+      groupFields << s_peopleGroupName;
+    }
+    invalidateGroups(groupFields);
+  }
+  if(oldDict) {
+    qDeleteAll(*oldDict);
+    delete oldDict;
   }
 
   // now to update all entries if the field is a derived value and the template changed
@@ -396,13 +418,25 @@ bool Collection::removeField(Tellico::Data::FieldPtr field_, bool force_/*=false
   }
   m_fieldByName.remove(field_->name());
   m_fieldByTitle.remove(field_->title());
+  if(m_valueIndex.remove(field_->name()) > 0) {
+    ++m_valuesRevision;
+  }
+  resetSnapshot();
 
   if(fieldsByCategory(field_->category()).count() == 1) {
     m_fieldCategories.removeAll(field_->category());
   }
 
   if(field_->hasFlag(Field::AllowGrouped)) {
+    // the entries must not keep pointers to the deleted groups
+    foreach(EntryPtr entry, m_entries) {
+      entry->clearGroups(QStringList() << field_->name());
+    }
+    m_pendingGroupFields.removeAll(field_->name());
     EntryGroupDict* dict = m_entryGroupDicts.take(field_->name());
+    foreach(EntryGroup* group, *dict) {
+      m_groupsToDelete.removeOne(group);
+    }
     qDeleteAll(*dict);
     m_entryGroups.removeAll(field_->name());
     if(field_->name() == m_defaultGroupField && !m_entryGroups.isEmpty()) {
@@ -469,6 +503,7 @@ void Collection::addEntries(const Tellico::Data::EntryList& entries_) {
       ++m_nextEntryId;
     }
     m_entryById.insert(entry->id(), entry.data());
+    indexEntryValues(entry.data(), 1);
 
     if(hasField(QStringLiteral("cdate")) && entry->field(QStringLiteral("cdate")).isEmpty()) {
       entry->setField(QStringLiteral("cdate"), QDate::currentDate().toString(Qt::ISODate));
@@ -531,9 +566,14 @@ bool Collection::removeEntries(const Tellico::Data::EntryList& vec_) {
   removeEntriesFromDicts(vec_, fieldNames());
   bool success = true;
   foreach(EntryPtr entry, vec_) {
+    if(isIndexedEntry(entry.data())) {
+      indexEntryValues(entry.data(), -1);
+    }
     m_entryById.remove(entry->id());
     m_entries.removeAll(entry);
   }
+  // the snapshot rows would have holes, so it is taken again from scratch
+  resetSnapshot();
   cleanGroups();
   return success;
 }
@@ -594,12 +634,177 @@ QStringList Collection::valuesByFieldName(const QString& name_) const {
     return QStringList();
   }
 
-  StringSet values;
+  const ValueIndex* index = valueIndex(name_);
+  if(!index) {
+    // derived values are not stored in the entries, so they can't be indexed
+    StringSet values;
+    foreach(EntryPtr entry, m_entries) {
+      values.add(FieldFormat::splitValue(entry->field(name_)));
+    } // end entry loop
+    return values.toList();
+  }
+
+  QStringList values;
+  values.reserve(index->size());
+  for(ValueIndex::ConstIterator it = index->constBegin(); it != index->constEnd(); ++it) {
+    values << it.key().value;
+  }
+  return values;
+}
+
+QStringList Collection::valuesByPrefix(const QString& name_, const QString& prefix_) const {
+  if(name_.isEmpty()) {
+    return QStringList();
+  }
+
+  QStringList values;
+  const ValueIndex* index = valueIndex(name_);
+  if(!index) {
+    foreach(const QString& value, valuesByFieldName(name_)) {
+      if(value.startsWith(prefix_, Qt::CaseInsensitive)) {
+        values << value;
+      }
+    }
+    return values;
+  }
+
+  ValueIndex::ConstIterator it = index->lowerBound(ValueKey(prefix_));
+  // a value which only differs from the prefix in case might sort before it
+  while(it != index->constBegin() && (it - 1).key().value.startsWith(prefix_, Qt::CaseInsensitive)) {
+    --it;
+  }
+  for( ; it != index->constEnd() && it.key().value.startsWith(prefix_, Qt::CaseInsensitive); ++it) {
+    values << it.key().value;
+  }
+  return values;
+}
+
+bool Collection::ValueKey::operator<(const ValueKey& other_) const {
+  const int cmp = QString::compare(value, other_.value, Qt::CaseInsensitive);
+  return cmp < 0 || (cmp == 0 && value < other_.value);
+}
+
+Tellico::Data::Collection::ValueIndex* Collection::valueIndex(const QString& name_) const {
+  QHash<QString, ValueIndex>::Iterator it = m_valueIndex.find(name_);
+  if(it != m_valueIndex.end()) {
+    return &it.value();
+  }
+  FieldPtr field = fieldByName(name_);
+  if(!field || field->hasFlag(Field::Derived)) {
+    return nullptr;
+  }
+  ValueIndex& index = m_valueIndex[name_];
   foreach(EntryPtr entry, m_entries) {
-    values.add(FieldFormat::splitValue(entry->field(name_)));
-  } // end entry loop
+    updateValueIndex(index, entry->field(field), 1);
+  }
+  return &index;
+}
+
+// entry copies share the collection pointer and the id, so check the pointer itself
+bool Collection::isIndexedEntry(const Entry* entry_) const {
+  return m_entryById.value(entry_->id()) == entry_;
+}
+
+void Collection::indexEntryValues(const Entry* entry_, int delta_) {
+  if(m_snapshot && entry_->id() != -1) {
+    m_snapshotModified.insert(entry_->id());
+  }
+  if(m_valueIndex.isEmpty()) {
+    return;
+  }
+  for(QHash<QString, ValueIndex>::Iterator it = m_valueIndex.begin(); it != m_valueIndex.end(); ++it) {
+    updateValueIndex(it.value(), entry_->field(it.key()), delta_);
+  }
+  ++m_valuesRevision;
+}
 
-  return values.toList();
+void Collection::entryValueChanged(const Entry* entry_, const QString& name_, const QString& oldValue_, const QString& newValue_) {
+  if(oldValue_ == newValue_ || (!m_snapshot && m_valueIndex.isEmpty()) || !isIndexedEntry(entry_)) {
+    return;
+  }
+  // the whole row is read again, since derived values might depend on the field
+  if(m_snapshot) {
+    m_snapshotModified.insert(entry_->id());
+  }
+  QHash<QString, ValueIndex>::Iterator it = m_valueIndex.find(name_);
+  if(it == m_valueIndex.end()) {
+    return;
+  }
+  updateValueIndex(it.value(), oldValue_, -1);
+  updateValueIndex(it.value(), newValue_, 1);
+  ++m_valuesRevision;
+}
+
+void Collection::updateValueIndex(ValueIndex& index_, const QString& value_, int delta_) {
+  foreach(const QString& value, FieldFormat::splitValue(value_)) {
+    ValueIndex::Iterator it = index_.find(ValueKey(value));
+    if(it == index_.end()) {
+      if(delta_ > 0) {
+        index_.insert(ValueKey(value), delta_);
+      }
+      continue;
+    }
+    it.value() += delta_;
+    if(it.value() <= 0) {
+      index_.erase(it);
+    }
+  }
+}
+
+Tellico::Data::CollectionSnapshot::Ptr Collection::snapshot(const QStringList& fieldNames_) const {
+  // the entries are read while the snapshot is taken
+  Q_ASSERT(thread() == QThread::currentThread());
+  if(m_snapshot && m_snapshotModified.isEmpty()) {
+    bool complete = true;
+    foreach(const QString& name, fieldNames_) {
+      if(!m_snapshot->hasColumn(name) && hasField(name)) {
+        complete = false;
+        break;
+      }
+    }
+    if(complete) {
+      return m_snapshot;
+    }
+  }
+
+  FieldList fields;
+  if(m_snapshot) {
+    foreach(const QString& name, m_snapshot->fieldNames()) {
+      FieldPtr field = fieldByName(name);
+      if(field) {
+        fields << field;
+      }
+    }
+  }
+  foreach(const QString& name, fieldNames_) {
+    FieldPtr field = fieldByName(name);
+    if(field && !fields.contains(field)) {
+      fields << field;
+    }
+  }
+
+  if(m_snapshot) {
+    // removing entries resets the snapshot, so any new entries are at the end of the list
+    const EntryList newEntries = m_entries.mid(m_snapshot->count());
+    EntryList modifiedEntries;
+    foreach(ID id, m_snapshotModified) {
+      Entry* entry = m_entryById.value(id);
+      if(entry && m_snapshot->row(id) > -1) {
+        modifiedEntries << EntryPtr(entry);
+      }
+    }
+    m_snapshot = CollectionSnapshot::Ptr(CollectionSnapshot::update(m_snapshot.data(), newEntries, modifiedEntries, fields));
+  } else {
+    const CollectionSnapshot empty;
+    m_snapshot = CollectionSnapshot::Ptr(CollectionSnapshot::update(&empty, m_entries, EntryList(), fields));
+  }
+  m_snapshotModified.clear();
+  return m_snapshot;
+}
+
+void Collection::resetSnapshot() {
+  m_snapshot.clear();
+  m_snapshotModified.clear();
 }
 
 Tellico::Data::FieldPtr Collection::fieldByName(const QString& name_) const {
@@ -638,7 +843,10 @@ Tellico::Data::EntryGroupDict* Collection::entryGroupDictByName(const QString& n
     return nullptr;
   }
   EntryGroupDict* dict = m_entryGroupDicts.value(name_);
-  if(dict && dict->isEmpty()) {
+  if(m_pendingGroupFields.contains(name_)) {
+    // the dict may be partially populated already, so finish it off
+    finishPendingDict(name_);
+  } else if(dict && dict->isEmpty()) {
     const bool b = signalsBlocked();
     // block signals so all the group created/modified signals don't fire
     blockSignals(true);
@@ -648,9 +856,120 @@ Tellico::Data::EntryGroupDict* Collection::entryGroupDictByName(const QString& n
   return dict;
 }
 
+bool Collection::isEntryGroupDictPopulated(const QString& name_) const {
+  const EntryGroupDict* dict = m_entryGroupDicts.value(name_);
+  return dict && !dict->isEmpty() && !m_pendingGroupFields.contains(name_);
+}
+
+void Collection::requestEntryGroupDict(const QString& name_) {
+  m_lastGroupField = name_; // keep track, even if it's invalid
+  EntryGroupDict* dict = m_entryGroupDicts.value(name_);
+  if(!dict || m_entries.isEmpty() || isEntryGroupDictPopulated(name_)) {
+    return;
+  }
+  if(m_pendingGroupFields.indexOf(name_) != 0) {
+    // any dict which was in progress is started over later, its entries that
+    // were already grouped get skipped by Entry::addToGroup()
+    m_pendingGroupFields.removeAll(name_);
+    m_pendingGroupFields.prepend(name_);
+    m_pendingGroupEntries = m_entries;
+    m_pendingGroupPos = 0;
+    scheduleGroupChunk();
+  }
+  // announce whatever has been grouped so far
+  if(!dict->isEmpty()) {
+    emit signalGroupsModified(CollPtr(this), dict->values());
+  }
+}
+
+void Collection::precomputeEntryGroupDicts(const QStringList& names_) {
+  foreach(const QString& name, names_) {
+    if(!m_entryGroupDicts.contains(name) || m_pendingGroupFields.contains(name)) {
+      continue;
+    }
+    if(m_entryGroupDicts.value(name)->isEmpty()) {
+      if(m_pendingGroupFields.isEmpty()) {
+        m_pendingGroupEntries = m_entries;
+        m_pendingGroupPos = 0;
+      }
+      m_pendingGroupFields << name;
+    }
+  }
+  scheduleGroupChunk();
+}
+
+void Collection::scheduleGroupChunk() {
+  if(m_groupChunkScheduled || m_pendingGroupFields.isEmpty()) {
+    return;
+  }
+  m_groupChunkScheduled = true;
+  QTimer::singleShot(0, this, &Collection::slotPopulateGroupChunk);
+}
+
+void Collection::slotPopulateGroupChunk() {
+  m_groupChunkScheduled = false;
+  if(m_pendingGroupFields.isEmpty()) {
+    return;
+  }
+  const QString fieldName = m_pendingGroupFields.first();
+  EntryGroupDict* dict = m_entryGroupDicts.value(fieldName);
+  if(dict) {
+    // the snapshot of the entry list might include some which have since been removed
+    EntryList chunk;
+    const int end = qMin(m_pendingGroupPos + GROUP_CHUNK_SIZE, m_pendingGroupEntries.count());
+    for(int i = m_pendingGroupPos; i < end; ++i) {
+      EntryPtr entry = m_pendingGroupEntries.at(i);
+      if(m_entryById.value(entry->id()) == entry.data()) {
+        chunk << entry;
+      }
+    }
+    m_pendingGroupPos = end;
+    populateDict(dict, fieldName, chunk);
+  }
+  if(!dict || m_pendingGroupPos >= m_pendingGroupEntries.count()) {
+    m_pendingGroupFields.removeFirst();
+    m_pendingGroupEntries = m_pendingGroupFields.isEmpty() ? EntryList() : m_entries;
+    m_pendingGroupPos = 0;
+  }
+  scheduleGroupChunk();
+}
+
+void Collection::finishPendingDict(const QString& name_) {
+  const int pos = m_pendingGroupFields.indexOf(name_);
+  if(pos < 0) {
+    return;
+  }
+  EntryGroupDict* dict = m_entryGroupDicts.value(name_);
+  if(dict) {
+    EntryList entries;
+    if(pos == 0) {
+      // entries added since the dict was started have already been grouped by populateCurrentDicts()
+      for(int i = m_pendingGroupPos; i < m_pendingGroupEntries.count(); ++i) {
+        EntryPtr entry = m_pendingGroupEntries.at(i);
+        if(m_entryById.value(entry->id()) == entry.data()) {
+          entries << entry;
+        }
+      }
+    } else {
+      entries = m_entries;
+    }
+    const bool b = signalsBlocked();
+    blockSignals(true);
+    populateDict(dict, name_, entries);
+    blockSignals(b);
+  }
+  m_pendingGroupFields.removeAt(pos);
+  if(pos == 0) {
+    m_pendingGroupEntries = m_pendingGroupFields.isEmpty() ? EntryList() : m_entries;
+    m_pendingGroupPos = 0;
+  }
+}
+
 void Collection::populateDict(Tellico::Data::EntryGroupDict* dict_, const QString& fieldName_, const Tellico::Data::EntryList& entries_) {
 //  myDebug() << fieldName_;
   Q_ASSERT(dict_);
+  TRACE_SCOPE("group", "populateDict");
+  Tracer::count("group", "populateDictEntries", entries_.count());
   const bool isBool = hasField(fieldName_) && fieldByName(fieldName_)->type() == Field::Bool;
 
   QSet<EntryGroup*> modifiedGroups;
@@ -702,8 +1021,8 @@ void Collection::populateCurrentDicts(const Tellico::Data::EntryList& entries_,
       continue;
     }
     // only populate if it's not empty, since they are
-    // populated on demand
-    if(!dictIt.value()->isEmpty()) {
+    // populated on demand, unless it's waiting to be populated in chunks
+    if(!dictIt.value()->isEmpty() || m_pendingGroupFields.contains(dictIt.key())) {
       populateDict(dictIt.value(), dictIt.key(), entries_);
       allEmpty = false;
     }
@@ -720,45 +1039,69 @@ void Collection::populateCurrentDicts(const Tellico::Data::EntryList& entries_,
 }
 
 // return a string list for all the groups that the entry belongs to
-// for a given field. Normally, this would just be splitting the entry's value
-// for the field, but if the field name is the people pseudo-group, then it gets
-// a bit more complicated
+// for a given field. The entry handles the people pseudo-group, too, and
+// caches the names so that the group can be rebuilt quickly
 QStringList Collection::entryGroupNamesByField(Tellico::Data::EntryPtr entry_, const QString& fieldName_) {
-  if(fieldName_ != s_peopleGroupName) {
-    return entry_->groupNamesByFieldName(fieldName_);
+  return entry_->groupNamesByFieldName(fieldName_);
+}
+
+void Collection::invalidateGroups(const QStringList& fieldNames_) {
+  QStringList groupFields;
+  if(fieldNames_.isEmpty()) {
+    groupFields = m_entryGroupDicts.keys();
+  } else {
+    groupFields = fieldNames_;
+    // derived values might depend on any of the other fields
+    QHash<QString, EntryGroupDict*>::const_iterator dictIt = m_entryGroupDicts.constBegin();
+    for( ; dictIt != m_entryGroupDicts.constEnd(); ++dictIt) {
+      FieldPtr field = fieldByName(dictIt.key());
+      if(field && field->hasFlag(Field::Derived) && !groupFields.contains(dictIt.key())) {
+        groupFields << dictIt.key();
+      }
+    }
   }
 
-  // the empty group is only returned if the entry has an empty list for every people field
-  bool allEmpty = true;
-  StringSet values;
-  foreach(FieldPtr field, m_peopleFields) {
-    const QStringList groups = entry_->groupNamesByFieldName(field->name());
-    if(allEmpty && (groups.count() != 1 || !groups.at(0).isEmpty())) {
-      allEmpty = false;
+  // the formatted values change, and the snapshot holds copies of them
+  resetSnapshot();
+
+  // the entries have to drop the groups before they get deleted
+  // populateDicts() will make signals that the group view is connected to, block those
+  blockSignals(true);
+  foreach(EntryPtr entry, m_entries) {
+    if(fieldNames_.isEmpty()) {
+      entry->invalidateFormattedFieldValue();
+      entry->clearGroups();
+    } else {
+      foreach(const QString& fieldName, groupFields) {
+        entry->invalidateFormattedFieldValue(fieldName);
+      }
+      entry->clearGroups(groupFields);
     }
-    values.add(groups);
   }
-  if(!allEmpty) {
-    // we don't want the empty string
-    values.remove(QString());
+  blockSignals(false);
+
+  QMutableListIterator<EntryGroup*> groupIt(m_groupsToDelete);
+  while(groupIt.hasNext()) {
+    if(groupFields.contains(groupIt.next()->fieldName())) {
+      groupIt.remove();
+    }
   }
-  return values.toList();
-}
 
-void Collection::invalidateGroups() {
-  foreach(EntryGroupDict* dict, m_entryGroupDicts) {
+  foreach(const QString& fieldName, groupFields) {
+    EntryGroupDict* dict = m_entryGroupDicts.value(fieldName);
+    if(!dict) {
+      continue;
+    }
     qDeleteAll(*dict);
     dict->clear();
     // don't delete the dict, just clear it
   }
 
-  // populateDicts() will make signals that the group view is connected to, block those
-  blockSignals(true);
-  foreach(EntryPtr entry, m_entries) {
-    entry->invalidateFormattedFieldValue();
-    entry->clearGroups();
+  // a dict being populated in chunks has to start over
+  if(!m_pendingGroupFields.isEmpty() && groupFields.contains(m_pendingGroupFields.first())) {
+    m_pendingGroupEntries = m_entries;
+    m_pendingGroupPos = 0;
   }
-  blockSignals(false);
 }
 
 Tellico::Data::EntryPtr Collection::entryById(Data::ID id_) {
@@ -824,6 +1167,9 @@ void Collection::clear() {
 
   m_entries.clear();
   m_entryById.clear();
+  m_valueIndex.clear();
+  ++m_valuesRevision;
+  resetSnapshot();
   foreach(EntryGroupDict* dict, m_entryGroupDicts) {
     qDeleteAll(*dict);
   }
@@ -831,13 +1177,17 @@ void Collection::clear() {
   m_entryGroupDicts.clear();
   m_entryGroups.clear();
   m_groupsToDelete.clear();
+  m_pendingGroupFields.clear();
+  m_pendingGroupEntries.clear();
+  m_pendingGroupPos = 0;
   m_filters.clear();
   m_borrowers.clear();
 }
 
 void Collection::cleanGroups() {
   foreach(EntryGroup* group, m_groupsToDelete) {
-    EntryGroupDict* dict = entryGroupDictByName(group->fieldName());
+    // don't use entryGroupDictByName(), the dict doesn't need to be populated
+    EntryGroupDict* dict = m_entryGroupDicts.value(group->fieldName());
     if(!dict) {
       continue;
     }
@@ -29,10 +29,13 @@
 #include "entry.h"
 #include "filter.h"
 #include "borrower.h"
+#include "collectionsnapshot.h"
 #include "datavectors.h"
 
 #include <QStringList>
 #include <QHash>
+#include <QMap>
+#include <QSet>
 #include <QObject>
 
 namespace Tellico {
@@ -48,6 +51,11 @@ namespace Tellico {
  * It has a list of attributes which apply for the whole collection. A unique id value
  * identifies each collection object.
  *
+ * The collection and its entries are only changed on the thread which owns the collection.
+ * The const methods of an entry may be called from several threads at once, as long as
+ * nothing changes the entry at the same time. A background job which has to keep running
+ * while the collection is edited reads a @ref CollectionSnapshot instead, which never changes.
+ *
  * @see Entry
  * @see Field
  *
@@ -252,13 +260,29 @@ public:
   /**
    * Returns a list of the values of a given field for every entry
    * in the collection. The values in the list are not repeated. Attribute
-   * values which contain ";" are split into separate values. Since this method
-   * iterates over all the entries, for large collections, it is expensive.
+   * values which contain ";" are split into separate values. The values
+   * come from an index which is built the first time a field is requested and
+   * then kept current as entries are added, removed, or modified. Derived
+   * fields are not indexed and iterate over all the entries.
    *
    * @param name The name of the field
-   * @return The list of values
+   * @return The list of values, sorted without regard to case
    */
   QStringList valuesByFieldName(const QString& name) const;
+  /**
+   * Returns the values of a given field which start with a prefix,
+   * ignoring case. Only the matching range of the value index is read.
+   *
+   * @param name The name of the field
+   * @param prefix The start of the values
+   * @return The list of values, sorted without regard to case
+   */
+  QStringList valuesByPrefix(const QString& name, const QString& prefix) const;
+  /**
+   * Returns a number which changes every time the value index is modified.
+   * Completion objects use it to know when their items are stale.
+   */
+  uint valuesRevision() const { return m_valuesRevision; }
   /**
    * Returns a list of all the fields in a given category.
    *
@@ -302,9 +326,43 @@ public:
    */
   EntryGroupDict* entryGroupDictByName(const QString& name);
   /**
-   * Invalidates all group names in the collection.
+   * Returns true if the dict for a group field has been completely populated, so
+   * that @ref entryGroupDictByName will not need to group any entries.
+   *
+   * @param name The name of the field by which the entries are grouped
    */
-  void invalidateGroups();
+  bool isEntryGroupDictPopulated(const QString& name) const;
+  /**
+   * Starts populating the dict for a group field from the event loop, a chunk of entries
+   * at a time. The groups are announced with @ref signalGroupsModified as they are filled in,
+   * including any which already exist from a previous partial population.
+   *
+   * @param name The name of the field by which the entries are grouped
+   */
+  void requestEntryGroupDict(const QString& name);
+  /**
+   * Queues group dicts to be populated in the background, after any requested dict.
+   *
+   * @param names The names of the fields by which the entries are grouped
+   */
+  void precomputeEntryGroupDicts(const QStringList& names);
+  /**
+   * Invalidates group names in the collection. Dicts for derived fields are
+   * always invalidated, since their values may depend on the other fields.
+   *
+   * @param fieldNames The names of the group fields to invalidate, an empty list means all groups
+   */
+  void invalidateGroups(const QStringList& fieldNames = QStringList());
+  /**
+   * Returns a snapshot of the formatted values of the fields for every entry. The snapshot
+   * is kept until the collection changes, and the next one re-reads only the entries which
+   * were modified in between. Columns already in the snapshot are kept along with the
+   * requested ones. The snapshot has to be taken on the thread which owns the collection,
+   * but it can be read from any thread.
+   *
+   * @param fieldNames The names of the fields to include
+   */
+  CollectionSnapshot::Ptr snapshot(const QStringList& fieldNames) const;
   /**
    * Returns true if the collection contains at least one Image field.
    *
@@ -319,7 +377,7 @@ public:
   /**
    * Clears all vectors which contain shared ptrs
    */
-  void clear();
+  virtual void clear();
 
   void addFilter(FilterPtr filter);
   bool removeFilter(FilterPtr filter);
@@ -331,6 +389,11 @@ public:
    * Useful only for BibtexCollection to strip bibtex strings
    */
   virtual QString prepareText(const QString& text) const;
+  /**
+   * Whether prepareText() changes the text at all. If so, entries cache the prepared
+   * values, otherwise prepareText() is never called for unformatted fields.
+   */
+  virtual bool preparesText() const { return false; }
 
   /**
    * The string used for the people pseudo-group. This forces consistency.
@@ -345,12 +408,44 @@ Q_SIGNALS:
 protected:
   Collection(const QString& title);
 
+  // whether the entry itself, rather than a copy of it, belongs to the collection
+  bool isIndexedEntry(const Entry* entry) const;
+  /**
+   * Adds (delta = 1) or removes (delta = -1) the values of an entry in the collection
+   * to the indexes. Subclasses with an index of their own should call the base class.
+   */
+  virtual void indexEntryValues(const Entry* entry, int delta);
+  /**
+   * Called by Entry whenever a field value changes. The entry might not be in the
+   * collection. Subclasses with an index of their own should call the base class.
+   */
+  virtual void entryValueChanged(const Entry* entry, const QString& name, const QString& oldValue, const QString& newValue);
+
+private Q_SLOTS:
+  void slotPopulateGroupChunk();
+
 private:
   QStringList entryGroupNamesByField(EntryPtr entry, const QString& fieldName);
   void removeEntriesFromDicts(const EntryList& entries, const QStringList& fields);
   void populateDict(EntryGroupDict* dict, const QString& fieldName, const EntryList& entries);
   void populateCurrentDicts(const EntryList& entries, const QStringList& fields);
   void cleanGroups();
+  void scheduleGroupChunk();
+  void finishPendingDict(const QString& name);
+  void resetSnapshot();
+
+  // sorts values without regard to case, so all the values with the same
+  // case-insensitive prefix are a single range of the index
+  struct ValueKey {
+    ValueKey(const QString& v = QString()) : value(v) {}
+    bool operator<(const ValueKey& other) const;
+    QString value;
+  };
+  // every distinct value of a field, with the number of times it is used
+  typedef QMap<ValueKey, int> ValueIndex;
+
+  ValueIndex* valueIndex(const QString& name) const;
+  static void updateValueIndex(ValueIndex& index, const QString& value, int delta);
 
   /*
    * Gets the preferred ID of the collection. Currently, it just gets incremented as
@@ -359,6 +454,7 @@ private:
   static int getID();
 
   Q_DISABLE_COPY(Collection)
+  friend class Entry;
 
   ID m_id;
   ID m_nextEntryId;
@@ -375,10 +471,21 @@ private:
 
   EntryList m_entries;
   QHash<int, Entry*> m_entryById;
+  // value index by field name, a field is only indexed once its values are requested
+  mutable QHash<QString, ValueIndex> m_valueIndex;
+  uint m_valuesRevision;
+  // the last snapshot, along with the entries modified since it was taken
+  mutable CollectionSnapshot::Ptr m_snapshot;
+  mutable QSet<ID> m_snapshotModified;
 
   QHash<QString, EntryGroupDict*> m_entryGroupDicts;
   QStringList m_entryGroups;
   QList<EntryGroup*> m_groupsToDelete;
+  // group dicts waiting to be populated in chunks, the first one is in progress
+  QStringList m_pendingGroupFields;
+  EntryList m_pendingGroupEntries;
+  int m_pendingGroupPos;
+  bool m_groupChunkScheduled;
 
   FilterList m_filters;
   BorrowerList m_borrowers;
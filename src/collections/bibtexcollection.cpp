@@ -38,6 +38,7 @@ namespace {
   static const char* bibtex_general = I18N_NOOP("General");
   static const char* bibtex_publishing = I18N_NOOP("Publishing");
   static const char* bibtex_misc = I18N_NOOP("Miscellaneous");
+  static const char* bibtex_key = "bibtex-key";
 }
 
 BibtexCollection::BibtexCollection(bool addDefaultFields_, const QString& title_)
@@ -322,15 +323,56 @@ Tellico::Data::FieldPtr BibtexCollection::fieldByBibtexName(const QString& bibte
 }
 
 Tellico::Data::EntryPtr BibtexCollection::entryByBibtexKey(const QString& key_) const {
-  EntryPtr entry;
-  // we do assume unique keys
-  foreach(EntryPtr e, entries()) {
-    if(e->field(QStringLiteral("bibtex-key")) == key_) {
-      entry = e;
-      break;
+  // with duplicate keys, the oldest entry is the one to use, regardless of the hash order
+  Entry* found = nullptr;
+  QMultiHash<QString, Entry*>::ConstIterator it = m_entriesByKey.constFind(key_);
+  for( ; it != m_entriesByKey.constEnd() && it.key() == key_; ++it) {
+    if(!found || it.value()->id() < found->id()) {
+      found = it.value();
     }
   }
-  return entry;
+  return EntryPtr(found);
+}
+
+void BibtexCollection::clear() {
+  Collection::clear();
+  m_entriesByKey.clear();
+  m_duplicateKeys.clear();
+}
+
+void BibtexCollection::indexEntryValues(const Tellico::Data::Entry* entry_, int delta_) {
+  Collection::indexEntryValues(entry_, delta_);
+  Entry* entry = const_cast<Entry*>(entry_);
+  if(delta_ > 0) {
+    addKeyEntry(entry_->field(QLatin1String(bibtex_key)), entry);
+  } else {
+    removeKeyEntry(entry_->field(QLatin1String(bibtex_key)), entry);
+  }
+}
+
+void BibtexCollection::entryValueChanged(const Tellico::Data::Entry* entry_, const QString& name_,
+                                         const QString& oldValue_, const QString& newValue_) {
+  Collection::entryValueChanged(entry_, name_, oldValue_, newValue_);
+  if(name_ != QLatin1String(bibtex_key) || oldValue_ == newValue_ || !isIndexedEntry(entry_)) {
+    return;
+  }
+  Entry* entry = const_cast<Entry*>(entry_);
+  removeKeyEntry(oldValue_, entry);
+  addKeyEntry(newValue_, entry);
+}
+
+void BibtexCollection::addKeyEntry(const QString& key_, Tellico::Data::Entry* entry_) {
+  m_entriesByKey.insert(key_, entry_);
+  if(m_entriesByKey.count(key_) > 1) {
+    m_duplicateKeys.insert(key_);
+  }
+}
+
+void BibtexCollection::removeKeyEntry(const QString& key_, Tellico::Data::Entry* entry_) {
+  m_entriesByKey.remove(key_, entry_);
+  if(m_entriesByKey.count(key_) < 2) {
+    m_duplicateKeys.remove(key_);
+  }
 }
 
 QString BibtexCollection::prepareText(const QString& text_) const {
@@ -509,18 +551,11 @@ bool BibtexCollection::setFieldValue(Data::EntryPtr entry_, const QString& bibte
 }
 
 Tellico::Data::EntryList BibtexCollection::duplicateBibtexKeys() const {
-  QSet<EntryPtr> dupes;
-  QHash<QString, EntryPtr> keyHash;
-
-  const QString keyField = QStringLiteral("bibtex-key");
-  QString keyValue;
-  foreach(EntryPtr entry, entries()) {
-    keyValue = entry->field(keyField);
-    if(keyHash.contains(keyValue)) {
-      dupes << keyHash.value(keyValue) << entry;
-     } else {
-       keyHash.insert(keyValue, entry);
-     }
+  EntryList dupes;
+  foreach(const QString& key, m_duplicateKeys) {
+    foreach(Entry* entry, m_entriesByKey.values(key)) {
+      dupes << EntryPtr(entry);
+    }
   }
-  return dupes.toList();
+  return dupes;
 }
@@ -28,6 +28,7 @@
 #include "../collection.h"
 
 #include <QHash>
+#include <QSet>
 
 namespace Tellico {
   namespace Data {
@@ -56,6 +57,7 @@ public:
   virtual bool modifyField(FieldPtr field) Q_DECL_OVERRIDE;
   virtual bool removeField(FieldPtr field, bool force=false) Q_DECL_OVERRIDE;
   virtual bool removeField(const QString& name, bool force=false) Q_DECL_OVERRIDE;
+  virtual void clear() Q_DECL_OVERRIDE;
 
   FieldPtr fieldByBibtexName(const QString& name) const;
   EntryPtr entryByBibtexKey(const QString& key) const;
@@ -66,16 +68,32 @@ public:
   void addMacro(const QString& key, const QString& value) { m_macros.insert(key, value); }
 
   virtual QString prepareText(const QString& text) const Q_DECL_OVERRIDE;
+  virtual bool preparesText() const Q_DECL_OVERRIDE { return true; }
   virtual int sameEntry(Data::EntryPtr entry1, Data::EntryPtr entry2) const Q_DECL_OVERRIDE;
 
+  /**
+   * Returns every entry which shares its bibtex key with another
+   */
   EntryList duplicateBibtexKeys() const;
 
   static FieldList defaultFields();
   static CollPtr convertBookCollection(CollPtr coll);
   static bool setFieldValue(EntryPtr entry, const QString& bibtexField, const QString& value, CollPtr existingCollection);
 
+protected:
+  virtual void indexEntryValues(const Entry* entry, int delta) Q_DECL_OVERRIDE;
+  virtual void entryValueChanged(const Entry* entry, const QString& name,
+                                 const QString& oldValue, const QString& newValue) Q_DECL_OVERRIDE;
+
 private:
+  void addKeyEntry(const QString& key, Entry* entry);
+  void removeKeyEntry(const QString& key, Entry* entry);
+
   QHash<QString, Data::Field*> m_bibtexFieldDict;
+  // every entry in the collection by its bibtex key, kept current as entries change
+  QMultiHash<QString, Entry*> m_entriesByKey;
+  // the keys used by more than one entry
+  QSet<QString> m_duplicateKeys;
   QString m_preamble;
   StringMap m_macros;
 };
@@ -0,0 +1,110 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "collectionsnapshot.h"
+#include "entry.h"
+#include "field.h"
+
+using Tellico::Data::CollectionSnapshot;
+
+namespace {
+  // small columns are never compacted, rebuilding them would cost more than the unused values
+  static const int COMPACT_MIN_VALUES = 32;
+}
+
+void CollectionSnapshot::Column::append(const QString& value_) {
+  m_valueIds.append(valueId(value_));
+}
+
+void CollectionSnapshot::Column::replace(int row_, const QString& value_) {
+  m_valueIds[row_] = valueId(value_);
+}
+
+int CollectionSnapshot::Column::valueId(const QString& value_) {
+  QHash<QString, int>::ConstIterator it = m_valueIdByValue.constFind(value_);
+  if(it != m_valueIdByValue.constEnd()) {
+    return it.value();
+  }
+  const int id = m_values.count();
+  m_values.append(value_);
+  m_valueIdByValue.insert(value_, id);
+  return id;
+}
+
+// a row uses at most one value, so with more than twice as many values as rows,
+// the unused values outnumber the rows
+bool CollectionSnapshot::Column::needsCompacting() const {
+  return m_values.count() > COMPACT_MIN_VALUES && m_values.count() > 2 * m_valueIds.count();
+}
+
+CollectionSnapshot* CollectionSnapshot::update(const CollectionSnapshot* previous_, const EntryList& newEntries_,
+                                               const EntryList& modifiedEntries_, const FieldList& fields_) {
+  Q_ASSERT(previous_);
+  CollectionSnapshot* snapshot = new CollectionSnapshot();
+  snapshot->m_entries = previous_->m_entries;
+  snapshot->m_rowById = previous_->m_rowById;
+  const int oldCount = snapshot->m_entries.count();
+  foreach(EntryPtr entry, newEntries_) {
+    snapshot->m_rowById.insert(entry->id(), snapshot->m_entries.count());
+    snapshot->m_entries.append(entry);
+  }
+
+  foreach(FieldPtr field, fields_) {
+    ColumnPtr oldColumn = previous_->m_columns.value(field->name());
+    if(!oldColumn) {
+      snapshot->m_columns.insert(field->name(), ColumnPtr(createColumn(snapshot->m_entries, field)));
+      continue;
+    }
+    if(newEntries_.isEmpty() && modifiedEntries_.isEmpty()) {
+      // nothing changed, so the column is shared
+      snapshot->m_columns.insert(field->name(), oldColumn);
+      continue;
+    }
+    Column* column = new Column(*oldColumn);
+    foreach(EntryPtr entry, modifiedEntries_) {
+      const int row = snapshot->m_rowById.value(entry->id(), -1);
+      if(row > -1 && row < oldCount) {
+        column->replace(row, entry->formattedField(field));
+      }
+    }
+    for(int row = oldCount; row < snapshot->m_entries.count(); ++row) {
+      column->append(snapshot->m_entries.at(row)->formattedField(field));
+    }
+    if(column->needsCompacting()) {
+      delete column;
+      column = createColumn(snapshot->m_entries, field);
+    }
+    snapshot->m_columns.insert(field->name(), ColumnPtr(column));
+  }
+  return snapshot;
+}
+
+CollectionSnapshot::Column* CollectionSnapshot::createColumn(const EntryList& entries_, FieldPtr field_) {
+  Column* column = new Column();
+  column->m_valueIds.reserve(entries_.count());
+  foreach(EntryPtr entry, entries_) {
+    column->append(entry->formattedField(field_));
+  }
+  return column;
+}
@@ -0,0 +1,112 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_COLLECTIONSNAPSHOT_H
+#define TELLICO_COLLECTIONSNAPSHOT_H
+
+#include "datavectors.h"
+
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QSharedPointer>
+
+namespace Tellico {
+  namespace Data {
+
+/**
+ * A CollectionSnapshot is a read-only, column-oriented copy of the formatted values
+ * of a collection. Each field is a column holding one value id for every entry, and the
+ * ids point into the list of distinct values, so equal values are stored once and can be
+ * compared as integers.
+ *
+ * A snapshot never changes once it is taken, so it may be scanned from any thread. Use
+ * @ref Collection::snapshot to get one; when entries change, the collection takes a new
+ * snapshot which shares the columns that were not touched and re-reads only the modified rows.
+ */
+class CollectionSnapshot {
+public:
+  class Column {
+  public:
+    int count() const { return m_valueIds.count(); }
+    int valueId(int row) const { return m_valueIds.at(row); }
+    QString value(int row) const { return m_values.at(m_valueIds.at(row)); }
+    /**
+     * Returns every distinct value in the column, indexed by value id. Values which are
+     * no longer used by any row may remain in the list until the column is compacted.
+     */
+    const QStringList& values() const { return m_values; }
+
+  private:
+    friend class CollectionSnapshot;
+    void append(const QString& value);
+    void replace(int row, const QString& value);
+    int valueId(const QString& value);
+    bool needsCompacting() const;
+
+    QVector<int> m_valueIds;
+    QStringList m_values;
+    QHash<QString, int> m_valueIdByValue;
+  };
+  typedef QSharedPointer<const Column> ColumnPtr;
+  typedef QSharedPointer<const CollectionSnapshot> Ptr;
+
+  int count() const { return m_entries.count(); }
+  /**
+   * Returns the row of an entry, or -1 if the entry was not in the collection
+   * when the snapshot was taken.
+   */
+  int row(ID id) const { return m_rowById.value(id, -1); }
+  EntryPtr entry(int row) const { return m_entries.at(row); }
+  const EntryList& entries() const { return m_entries; }
+  /**
+   * Returns the column for a field, or a null pointer if the field was not part of the snapshot.
+   */
+  ColumnPtr column(const QString& fieldName) const { return m_columns.value(fieldName); }
+  bool hasColumn(const QString& fieldName) const { return m_columns.contains(fieldName); }
+  QStringList fieldNames() const { return m_columns.keys(); }
+
+private:
+  friend class Collection;
+  CollectionSnapshot() {}
+
+  /**
+   * Creates a new snapshot from a previous one. The modified entries are read again,
+   * and the new entries are added as rows at the end. Columns are created for fields
+   * which are not in the previous snapshot, and the columns of the fields that are not
+   * in the list are dropped.
+   */
+  static CollectionSnapshot* update(const CollectionSnapshot* previous, const EntryList& newEntries,
+                                    const EntryList& modifiedEntries, const FieldList& fields);
+  static Column* createColumn(const EntryList& entries, FieldPtr field);
+
+  EntryList m_entries;
+  QHash<ID, int> m_rowById;
+  QHash<QString, ColumnPtr> m_columns;
+};
+
+  } // end namespace
+} // end namespace
+
+#endif
@@ -26,6 +26,7 @@
 #include "modifyentries.h"
 #include "../collection.h"
 #include "../controller.h"
+#include "../document.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -96,6 +97,7 @@ void ModifyEntries::redo() {
     }
   }
   m_coll->updateDicts(m_entries, m_modifiedFields);
+  Data::Document::self()->setEntriesModified(m_entries);
   Controller::self()->modifiedEntries(m_entries);
 }
 
@@ -106,6 +108,7 @@ void ModifyEntries::undo() {
   swapValues();
   m_needToSwap = true;
   m_coll->updateDicts(m_entries, m_modifiedFields);
+  Data::Document::self()->setEntriesModified(m_entries);
   Controller::self()->modifiedEntries(m_entries);
   //TODO: need to tell edit dialog that it's not modified
 }
@@ -38,6 +38,9 @@ namespace Tellico {
 class ModifyEntries : public QUndoCommand {
 
 public:
+  // lets the document recognize commands which only change entry values
+  enum { CommandId = 1001 };
+
   ModifyEntries(Data::CollPtr coll, const Data::EntryList& oldEntries,
                 const Data::EntryList& newEntries, const QStringList& modifiedFields);
   ModifyEntries(QUndoCommand* parent, Data::CollPtr coll, const Data::EntryList& oldEntries,
@@ -45,6 +48,7 @@ public:
 
   virtual void redo() Q_DECL_OVERRIDE;
   virtual void undo() Q_DECL_OVERRIDE;
+  virtual int id() const Q_DECL_OVERRIDE { return CommandId; }
 
 private:
   void swapValues();
@@ -25,6 +25,10 @@
 #include "tellico_config.h"
 #include "../collection.h"
 
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutex>
+
 #define COLL Data::Collection::
 #define CLASS Config::
 #define P1 (
@@ -73,16 +77,29 @@ QStringList Config::m_nameSuffixList;
 QStringList Config::m_surnamePrefixList;
 QStringList Config::m_surnamePrefixTokens;
 
+namespace {
+  // the config strings belong to the main thread, the same as the rest of the settings. The word lists
+  // are also read by background formatting, which gets the lists as of the last time the main thread
+  // looked at the strings. The lock guards the cached lists, not the strings
+  static QMutex listMutex;
+
+  bool isConfigThread() {
+    return !QCoreApplication::instance() || QThread::currentThread() == QCoreApplication::instance()->thread();
+  }
+}
+
+// the list mutex must be locked, since copying a QRegExp updates the original
 QRegExp Config::commaSplit() {
   static const QRegExp rx(QLatin1String("\\s*,\\s*"));
   return rx;
 }
 
+// the list mutex must be locked
 void Config::checkArticleList() {
   // I don't know of a way to update the list when the string changes
   // so just keep a cached copy
   static QString cacheValue;
-  if(cacheValue != Config::articlesString()) {
+  if(isConfigThread() && cacheValue != Config::articlesString()) {
     cacheValue = Config::articlesString();
     m_articleList = cacheValue.split(commaSplit());
     m_articleAposList.clear();
@@ -95,8 +112,9 @@ void Config::checkArticleList() {
 }
 
 QStringList Config::noCapitalizationList() {
+  QMutexLocker lock(&listMutex);
   static QString cacheValue;
-  if(cacheValue != Config::noCapitalizationString()) {
+  if(isConfigThread() && cacheValue != Config::noCapitalizationString()) {
     cacheValue = Config::noCapitalizationString();
     m_noCapitalizationList = cacheValue.split(commaSplit());
   }
@@ -104,19 +122,22 @@ QStringList Config::noCapitalizationList() {
 }
 
 QStringList Config::articleList() {
+  QMutexLocker lock(&listMutex);
   // articles should all be in lower-case
   checkArticleList();
   return m_articleList;
 }
 
 QStringList Config::articleAposList() {
+  QMutexLocker lock(&listMutex);
   checkArticleList();
   return m_articleAposList;
 }
 
 QStringList Config::nameSuffixList() {
+  QMutexLocker lock(&listMutex);
   static QString cacheValue;
-  if(cacheValue != Config::nameSuffixesString()) {
+  if(isConfigThread() && cacheValue != Config::nameSuffixesString()) {
     cacheValue = Config::nameSuffixesString();
     m_nameSuffixList = cacheValue.split(commaSplit());
   }
@@ -124,8 +145,9 @@ QStringList Config::nameSuffixList() {
 }
 
 QStringList Config::surnamePrefixList() {
+  QMutexLocker lock(&listMutex);
   static QString cacheValue;
-  if(cacheValue != Config::surnamePrefixesString()) {
+  if(isConfigThread() && cacheValue != Config::surnamePrefixesString()) {
     cacheValue = Config::surnamePrefixesString();
     m_surnamePrefixList = cacheValue.split(commaSplit());
   }
@@ -136,8 +158,9 @@ QStringList Config::surnamePrefixList() {
 // because QStringList::contains did substring matching, but now need to add a function for tokenizing
 // the list with whitespace as well as comma
 QStringList Config::surnamePrefixTokens() {
+  QMutexLocker lock(&listMutex);
   static QString cacheValue;
-  if(cacheValue != Config::surnamePrefixesString()) {
+  if(isConfigThread() && cacheValue != Config::surnamePrefixesString()) {
     cacheValue = Config::surnamePrefixesString();
     const QRegExp commaSpaceSplit = QRegExp(QLatin1String("\\s*[, ]\\s*"));
     m_surnamePrefixTokens = cacheValue.split(commaSpaceSplit);
@@ -216,6 +216,13 @@ void ConfigDialog::initGeneralPage(QFrame* frame) {
   l->addWidget(m_cbOpenLastFile);
   connect(m_cbOpenLastFile, &QAbstractButton::clicked, this, &ConfigDialog::slotModified);
 
+  m_cbCacheFiles = new QCheckBox(i18n("&Keep a cache of each file for faster loading"), frame);
+  m_cbCacheFiles->setWhatsThis(i18n("If checked, a compact copy of the collection is saved "
+                                    "next to the data file, so that it opens more quickly "
+                                    "the next time, as long as the file has not changed."));
+  l->addWidget(m_cbCacheFiles);
+  connect(m_cbCacheFiles, &QAbstractButton::clicked, this, &ConfigDialog::slotModified);
+
   m_cbShowTipDay = new QCheckBox(i18n("&Show \"Tip of the Day\" at startup"), frame);
   m_cbShowTipDay->setWhatsThis(i18n("If checked, the \"Tip of the Day\" will be "
                                     "shown at program start-up."));
@@ -682,6 +689,7 @@ void ConfigDialog::readGeneralConfig() {
 
   m_cbShowTipDay->setChecked(Config::showTipOfDay());
   m_cbOpenLastFile->setChecked(Config::reopenLastFile());
+  m_cbCacheFiles->setChecked(Config::cacheFiles());
 #ifdef ENABLE_WEBCAM
   m_cbEnableWebcam->setChecked(Config::enableWebcam());
 #else
@@ -791,6 +799,7 @@ void ConfigDialog::saveGeneralConfig() {
   }
   Config::setImageLocation(imageLocation);
   Config::setReopenLastFile(m_cbOpenLastFile->isChecked());
+  Config::setCacheFiles(m_cbCacheFiles->isChecked());
 
   Config::setAutoCapitalization(m_cbCapitalize->isChecked());
   Config::setAutoFormat(m_cbFormat->isChecked());
@@ -42,7 +42,12 @@
 #include "loanview.h"
 #include "entryupdater.h"
 #include "entrymerger.h"
+#include "duplicatefinder.h"
+#include "progressmanager.h"
+#include "images/imagefactory.h"
+#include "gui/statusbar.h"
 #include "utils/cursorsaver.h"
+#include "utils/stringset.h"
 #include "gui/lineedit.h"
 #include "gui/tabwidget.h"
 #include "tellico_debug.h"
@@ -198,6 +203,16 @@ void Controller::slotFieldAdded(Tellico::Data::CollPtr coll_, Tellico::Data::Fie
 
 // TODO: should be adding entries to models rather than to widget observers
 void Controller::addedEntries(Tellico::Data::EntryList entries_) {
+  // entries from the fetch dialog might still be waiting for their images
+  foreach(Data::EntryPtr entry, entries_) {
+    foreach(Data::FieldPtr field, entry->collection()->imageFields()) {
+      const QString value = entry->field(field);
+      if(!value.isEmpty() && ImageFactory::isImageRequestPending(QUrl(value))) {
+        m_imageRequestEntries.insert(value, entry->id());
+      }
+    }
+  }
+
   blockAllSignals(true);
   foreach(Observer* obs, m_observers) {
     obs->addEntries(entries_);
@@ -380,6 +395,55 @@ void Controller::slotMergeSelectedEntries() {
   new EntryMerger(m_selectedEntries, this);
 }
 
+void Controller::slotFindDuplicates() {
+  Data::CollPtr coll = Data::Document::self()->collection();
+  // only one search at a time
+  if(!coll || m_duplicateFinder) {
+    return;
+  }
+
+  m_duplicateEntries.clear();
+  m_duplicateFinder = new DuplicateFinder(coll, this);
+  ProgressItem& item = ProgressManager::self()->newProgressItem(m_duplicateFinder, i18n("Finding duplicate entries..."), true);
+  connect(&item, &Tellico::ProgressItem::signalCancelled, m_duplicateFinder.data(), &Tellico::DuplicateFinder::slotCancel);
+  connect(m_duplicateFinder.data(), &Tellico::DuplicateFinder::signalProgress, this, &Tellico::Controller::slotDuplicateProgress);
+  connect(m_duplicateFinder.data(), &Tellico::DuplicateFinder::signalDuplicates, this, &Tellico::Controller::slotDuplicatesFound);
+  connect(m_duplicateFinder.data(), &Tellico::DuplicateFinder::signalFinished, this, &Tellico::Controller::slotDuplicatesFinished);
+  StatusBar::self()->setStatus(i18n("Finding duplicate entries..."));
+  m_duplicateFinder->start();
+}
+
+void Controller::slotDuplicatesFound(const Tellico::Data::EntryList& entries_) {
+  foreach(Data::EntryPtr entry, entries_) {
+    if(!m_duplicateEntries.contains(entry)) {
+      m_duplicateEntries << entry;
+    }
+  }
+  m_mainWindow->m_detailedView->setEntriesSelected(m_duplicateEntries);
+  slotUpdateSelection(m_duplicateEntries);
+  StatusBar::self()->setStatus(i18np("Found 1 duplicate entry...", "Found %1 duplicate entries...",
+                                     m_duplicateEntries.count()));
+}
+
+void Controller::slotDuplicateProgress(int done_, int total_) {
+  ProgressManager::self()->setTotalSteps(m_duplicateFinder, total_);
+  ProgressManager::self()->setProgress(m_duplicateFinder, done_);
+}
+
+void Controller::slotDuplicatesFinished() {
+  if(!m_duplicateFinder) {
+    return;
+  }
+  ProgressManager::self()->setDone(m_duplicateFinder);
+  m_duplicateFinder->deleteLater();
+  m_duplicateFinder = nullptr;
+  StatusBar::self()->clearStatus();
+  if(m_duplicateEntries.isEmpty()) {
+    StatusBar::self()->setStatus(i18n("No duplicate entries were found."));
+  }
+  m_duplicateEntries.clear();
+}
+
 void Controller::slotRefreshField(Tellico::Data::FieldPtr field_) {
 //  DEBUG_LINE;
   // group view only needs to refresh if it's the title
@@ -674,3 +738,42 @@ bool Controller::canCheckIn() const {
 void Controller::updatedFetchers() {
   m_mainWindow->updateEntrySources();
 }
+
+void Controller::slotImageRequestFinished(const QString& url_, const QString& id_) {
+  if(!m_imageRequestEntries.contains(url_)) {
+    return;
+  }
+  const QList<Data::ID> ids = m_imageRequestEntries.values(url_);
+  m_imageRequestEntries.remove(url_);
+
+  // the user didn't change anything, so there's no command for the undo history
+  Data::CollPtr coll = Data::Document::self()->collection();
+  Data::EntryList entries;
+  StringSet fieldNames;
+  foreach(Data::ID id, ids) {
+    // the entry might have been deleted in the meantime
+    Data::EntryPtr entry = coll->entryById(id);
+    if(!entry) {
+      continue;
+    }
+    bool modified = false;
+    foreach(Data::FieldPtr field, coll->imageFields()) {
+      // the placeholder might have been edited by the user already
+      if(entry->field(field) == url_) {
+        // an empty id means the image could not be loaded
+        entry->setField(field, id_, false);
+        fieldNames.add(field->name());
+        modified = true;
+      }
+    }
+    if(modified) {
+      entries << entry;
+    }
+  }
+  if(entries.isEmpty()) {
+    return;
+  }
+  coll->updateDicts(entries, fieldNames.toList());
+  Data::Document::self()->setEntryImagesLoaded(entries);
+  modifiedEntries(entries);
+}
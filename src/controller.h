@@ -29,6 +29,8 @@
 
 #include <QObject>
 #include <QList>
+#include <QPointer>
+#include <QHash>
 
 class QMenu;
 
@@ -38,6 +40,7 @@ namespace Tellico {
     class Collection;
   }
   class Observer;
+  class DuplicateFinder;
 
 /**
  * @author Robby Stephenson
@@ -142,14 +145,29 @@ public Q_SLOTS:
   void slotUpdateSelectedEntries(const QString& source);
   void slotDeleteSelectedEntries();
   void slotMergeSelectedEntries();
+  /**
+   * Searches the whole collection for duplicate entries, in the background. The duplicates
+   * are selected as they are found, so they can be merged.
+   */
+  void slotFindDuplicates();
   void slotUpdateFilter(Tellico::FilterPtr filter);
   void slotCheckOut();
   void slotCheckIn();
   void slotCheckIn(const Data::EntryList& entries);
+  /**
+   * Replaces the url used as a placeholder in the image fields of any added entries,
+   * once the image has been downloaded in the background.
+   */
+  void slotImageRequestFinished(const QString& url, const QString& id);
 
 Q_SIGNALS:
   void collectionAdded(int collType);
 
+private Q_SLOTS:
+  void slotDuplicatesFound(const Tellico::Data::EntryList& entries);
+  void slotDuplicateProgress(int done, int total);
+  void slotDuplicatesFinished();
+
 private:
   static Controller* s_self;
   Controller(MainWindow* parent);
@@ -170,6 +188,11 @@ private:
    * Keep track of the selected entries so that a top-level delete has something for reference
    */
   Data::EntryList m_selectedEntries;
+
+  QPointer<DuplicateFinder> m_duplicateFinder;
+  Data::EntryList m_duplicateEntries;
+  // the ids of the entries waiting for an image, keyed by the url of the image
+  QMultiHash<QString, Data::ID> m_imageRequestEntries;
 };
 
 } // end namespace
@@ -44,9 +44,24 @@
 #include <QTextStream>
 #include <QTemporaryFile>
 #include <QSaveFile>
+#include <QCryptographicHash>
 
 namespace {
   static const int MAX_TEXT_CHUNK_WRITE_SIZE = 100 * 1024 * 1024;
+
+  class StringWriter : public Tellico::FileHandler::TextWriter {
+  public:
+    StringWriter(const QString& text_) : m_text(text_) {}
+    virtual bool writeText(QTextStream& ts_) Q_DECL_OVERRIDE {
+      // KDE Bug 380832. If string is longer than MAX_TEXT_CHUNK_WRITE_SIZE characters, split into chunks.
+      for(int i = 0; i < m_text.length(); i += MAX_TEXT_CHUNK_WRITE_SIZE) {
+        ts_ << m_text.midRef(i, MAX_TEXT_CHUNK_WRITE_SIZE);
+      }
+      return true;
+    }
+  private:
+    const QString& m_text;
+  };
 }
 
 using Tellico::FileHandler;
@@ -171,6 +186,18 @@ QByteArray FileHandler::readDataFile(const QUrl& url_, bool quiet_) {
   return f.file()->readAll();
 }
 
+QByteArray FileHandler::fileHash(const QString& fileName_) {
+  QFile file(fileName_);
+  if(!file.open(QIODevice::ReadOnly)) {
+    return QByteArray();
+  }
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  if(!hash.addData(&file)) {
+    return QByteArray();
+  }
+  return hash.result();
+}
+
 // TODO: really, this should be decoupled from the writeBackupFile() function
 // but every other function that calls it would need to be updated
 bool FileHandler::queryExists(const QUrl& url_) {
@@ -214,10 +241,16 @@ bool FileHandler::writeBackupFile(const QUrl& url_) {
 }
 
 bool FileHandler::writeTextURL(const QUrl& url_, const QString& text_, bool encodeUTF8_, bool force_, bool quiet_) {
-  if((!force_ && !queryExists(url_)) || text_.isNull()) {
-    if(text_.isNull()) {
-      myDebug() << "null string for" << url_;
-    }
+  if(text_.isNull()) {
+    myDebug() << "null string for" << url_;
+    return false;
+  }
+  StringWriter writer(text_);
+  return writeTextURL(url_, &writer, encodeUTF8_, force_, quiet_);
+}
+
+bool FileHandler::writeTextURL(const QUrl& url_, TextWriter* writer_, bool encodeUTF8_, bool force_, bool quiet_) {
+  if(!writer_ || (!force_ && !queryExists(url_))) {
     return false;
   }
 
@@ -230,7 +263,7 @@ bool FileHandler::writeTextURL(const QUrl& url_, const QString& text_, bool enco
       }
       return false;
     }
-    return FileHandler::writeTextFile(f, text_, encodeUTF8_);
+    return FileHandler::writeTextFile(f, writer_, encodeUTF8_);
   }
 
   // save to remote file
@@ -246,7 +279,7 @@ bool FileHandler::writeTextURL(const QUrl& url_, const QString& text_, bool enco
     return false;
   }
 
-  bool success = FileHandler::writeTextFile(f, text_, encodeUTF8_);
+  bool success = FileHandler::writeTextFile(f, writer_, encodeUTF8_);
   if(success) {
     KIO::Job* job = KIO::file_copy(QUrl::fromLocalFile(tempfile.fileName()), url_, -1, KIO::Overwrite);
     KJobWidgets::setWindow(job, GUI::Proxy::widget());
@@ -260,15 +293,18 @@ bool FileHandler::writeTextURL(const QUrl& url_, const QString& text_, bool enco
   return success;
 }
 
-bool FileHandler::writeTextFile(QSaveFile& file_, const QString& text_, bool encodeUTF8_) {
+bool FileHandler::writeTextFile(QSaveFile& file_, TextWriter* writer_, bool encodeUTF8_) {
   QTextStream ts(&file_);
   if(encodeUTF8_) {
     ts.setCodec("UTF-8");
   }
-  // KDE Bug 380832. If string is longer than MAX_TEXT_CHUNK_WRITE_SIZE characters, split into chunks.
-  for(int i = 0; i < text_.length(); i += MAX_TEXT_CHUNK_WRITE_SIZE) {
-    ts << text_.midRef(i, MAX_TEXT_CHUNK_WRITE_SIZE);
+  // the stream flushes to the file as its buffer fills, so the writer
+  // never needs to hold more than a single piece of the text
+  if(!writer_->writeText(ts)) {
+    file_.cancelWriting();
+    return false;
   }
+  ts.flush();
   file_.flush();
   bool success = file_.commit();
 #ifndef NDEBUG
@@ -37,6 +37,7 @@ namespace KIO {
 class QDomDocument;
 class QIODevice;
 class QSaveFile;
+class QTextStream;
 
 namespace Tellico {
   class ImageFactory;
@@ -77,6 +78,21 @@ public:
   };
   friend class FileRef;
 
+  /**
+   * An interface for anything that writes its text piece by piece, so the
+   * whole output never has to be held in memory at once.
+   */
+  class TextWriter {
+  public:
+    virtual ~TextWriter() {}
+    /**
+     * Writes the text to the stream. The stream encoding is already set.
+     *
+     * @return false to abort the write, leaving any existing file untouched
+     */
+    virtual bool writeText(QTextStream& ts) = 0;
+  };
+
   /**
    * Creates a FileRef for a given url. It's not meant to be used by methods in the class,
    * Rather by a class wanting direct access to a file. The caller takes ownership of the pointer.
@@ -120,6 +136,13 @@ public:
    * @return A QByteArray of the file's contents
    */
   static QByteArray readDataFile(const QUrl& url, bool quiet=false);
+  /**
+   * Computes the MD5 hash of the contents of a local file, without reading it all into memory.
+   *
+   * @param fileName The path of the file
+   * @return The raw hash, or an empty QByteArray if the file can't be read
+   */
+  static QByteArray fileHash(const QString& fileName);
   /**
    * Writes the contents of a string to a url. If the file already exists, a "~" is appended
    * and the existing file is moved. If the file is remote, a temporary file is written and
@@ -132,6 +155,17 @@ public:
    * @return A boolean indicating success
    */
   static bool writeTextURL(const QUrl& url, const QString& text, bool encodeUTF8, bool force=false, bool quiet=false);
+  /**
+   * Writes text to a url as it is generated by a TextWriter. Otherwise, the same
+   * as writeTextURL() with a string.
+   *
+   * @param url The url
+   * @param writer The writer which produces the text
+   * @param encodeUTF8 Whether to use UTF-8 encoding, or Locale
+   * @param force Whether to force the write
+   * @return A boolean indicating success
+   */
+  static bool writeTextURL(const QUrl& url, TextWriter* writer, bool encodeUTF8, bool force=false, bool quiet=false);
   /**
    * Writes data to a url. If the file already exists, a "~" is appended
    * and the existing file is moved. If the file is remote, a temporary file is written and
@@ -162,11 +196,11 @@ private:
    * Writes the contents of a string to a file.
    *
    * @param file The file object
-   * @param text The string
+   * @param writer The writer which produces the text
    * @param encodeUTF8 Whether to use UTF-8 encoding, or Locale
    * @return A boolean indicating success
    */
-  static bool writeTextFile(QSaveFile& file, const QString& text, bool encodeUTF8);
+  static bool writeTextFile(QSaveFile& file, TextWriter* writer, bool encodeUTF8);
   /**
    * Writes data to a file.
    *
@@ -27,6 +27,7 @@
 #include "../tellico_kernel.h"
 #include "../document.h"
 #include "../collection.h"
+#include "../collections/bibtexcollection.h"
 #include "../fieldformat.h"
 #include "../utils/bibtexhandler.h"
 #include "../mainwindow.h"
@@ -36,6 +37,17 @@
 using Tellico::ApplicationInterface;
 using Tellico::CollectionInterface;
 
+namespace {
+  // D-Bus callers may use either the field name or its title
+  Tellico::Data::FieldPtr fieldByNameOrTitle(Tellico::Data::CollPtr coll_, const QString& name_) {
+    Tellico::Data::FieldPtr field = coll_->fieldByName(name_);
+    if(!field) {
+      field = coll_->fieldByTitle(name_);
+    }
+    return field;
+  }
+}
+
 ApplicationInterface::ApplicationInterface(Tellico::MainWindow* parent_) : QObject(parent_), m_mainWindow(parent_) {
   QDBusConnection::sessionBus().registerObject(QStringLiteral("/Tellico"), this, QDBusConnection::ExportScriptableSlots);
 }
@@ -119,10 +131,7 @@ QStringList CollectionInterface::allValues(const QString& fieldName_) {
   if(!coll) {
     return results;
   }
-  Data::FieldPtr field = coll->fieldByName(fieldName_);
-  if(!field) {
-    field = coll->fieldByTitle(fieldName_);
-  }
+  Data::FieldPtr field = fieldByNameOrTitle(coll, fieldName_);
   if(!field) {
     return results;
   }
@@ -143,10 +152,7 @@ QStringList CollectionInterface::entryValues(int id_, const QString& fieldName_)
   if(!coll) {
     return results;
   }
-  Data::FieldPtr field = coll->fieldByName(fieldName_);
-  if(!field) {
-    field = coll->fieldByTitle(fieldName_);
-  }
+  Data::FieldPtr field = fieldByNameOrTitle(coll, fieldName_);
   if(!field) {
     return results;
   }
@@ -161,6 +167,44 @@ QStringList CollectionInterface::entryValues(int id_, const QString& fieldName_)
   return results;
 }
 
+// the values are returned as one flat list, row by row, with one value for each requested
+// field of each requested entry. Unknown entries or fields give empty values so the
+// positions in the list still line up with the requested ids and fields
+QStringList CollectionInterface::entriesValues(const QList<int>& ids_, const QStringList& fieldNames_) {
+  QStringList results;
+  Data::CollPtr coll = Data::Document::self()->collection();
+  if(!coll) {
+    return results;
+  }
+  // resolve the fields once, rather than for every entry
+  QStringList names;
+  names.reserve(fieldNames_.count());
+  foreach(const QString& fieldName, fieldNames_) {
+    Data::FieldPtr field = fieldByNameOrTitle(coll, fieldName);
+    names << (field ? field->name() : QString());
+  }
+  results.reserve(ids_.count() * names.count());
+  foreach(int id, ids_) {
+    Data::EntryPtr entry = coll->entryById(id);
+    foreach(const QString& name, names) {
+      results << (entry && !name.isEmpty() ? entry->field(name) : QString());
+    }
+  }
+  return results;
+}
+
+QStringList CollectionInterface::distinctValues(const QString& fieldName_) {
+  Data::CollPtr coll = Data::Document::self()->collection();
+  if(!coll) {
+    return QStringList();
+  }
+  Data::FieldPtr field = fieldByNameOrTitle(coll, fieldName_);
+  if(!field) {
+    return QStringList();
+  }
+  return coll->valuesByFieldName(field->name());
+}
+
 QStringList CollectionInterface::selectedBibtexKeys() {
   Data::CollPtr coll = Data::Document::self()->collection();
   if(!coll || coll->type() != Data::Collection::Bibtex) {
@@ -182,6 +226,15 @@ QString CollectionInterface::entryBibtexKey(int id_) {
   return keys.isEmpty() ? QString() : keys.first();
 }
 
+int CollectionInterface::entryByBibtexKey(const QString& key_) {
+  Data::CollPtr coll = Data::Document::self()->collection();
+  if(!coll || coll->type() != Data::Collection::Bibtex) {
+    return -1;
+  }
+  Data::EntryPtr entry = static_cast<Data::BibtexCollection*>(coll.data())->entryByBibtexKey(key_);
+  return entry ? entry->id() : -1;
+}
+
 bool CollectionInterface::setEntryValue(int id_, const QString& fieldName_, const QString& value_) {
   Data::CollPtr coll = Data::Document::self()->collection();
   if(!coll) {
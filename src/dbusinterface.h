@@ -94,8 +94,11 @@ public Q_SLOTS:
 
   Q_SCRIPTABLE QStringList allValues(const QString& fieldName);
   Q_SCRIPTABLE QStringList entryValues(int entryID, const QString& fieldName);
+  Q_SCRIPTABLE QStringList entriesValues(const QList<int>& entryIDs, const QStringList& fieldNames);
+  Q_SCRIPTABLE QStringList distinctValues(const QString& fieldName);
   Q_SCRIPTABLE QStringList selectedBibtexKeys();
   Q_SCRIPTABLE QString entryBibtexKey(int entryID);
+  Q_SCRIPTABLE int entryByBibtexKey(const QString& key);
 
   Q_SCRIPTABLE bool setEntryValue(int entryID, const QString& fieldName, const QString& value);
   Q_SCRIPTABLE bool addEntryValue(int entryID, const QString& fieldName, const QString& value);
@@ -27,6 +27,8 @@
 #include "translators/tellicoimporter.h"
 #include "translators/tellicozipexporter.h"
 #include "translators/tellicoxmlexporter.h"
+#include "translators/tellicocache.h"
+#include "translators/tellicojournal.h"
 #include "collection.h"
 #include "core/filehandler.h"
 #include "borrower.h"
@@ -41,6 +43,8 @@
 #include "config/tellico_config.h"
 #include "entrycomparison.h"
 #include "utils/guiproxy.h"
+#include "commands/modifyentries.h"
+#include "utils/tracer.h"
 #include "tellico_debug.h"
 
 #include <KMessageBox>
@@ -49,16 +53,43 @@
 #include <QRegExp>
 #include <QTimer>
 #include <QApplication>
+#include <QUndoStack>
+#include <QFileInfo>
+#include <QFile>
 
+#include <typeinfo>
 #include <unistd.h>
 
+namespace {
+  // beyond either limit, the journal is compacted by writing the complete file
+  static const int JOURNAL_MAX_ENTRIES = 1000;
+  static const int JOURNAL_MAX_PERCENT = 10;
+
+  // only the modification of entry values is journaled, whether the command
+  // was pushed by itself or as part of a macro
+  bool isJournaledCommand(const QUndoCommand* cmd_) {
+    if(cmd_->id() == Tellico::Command::ModifyEntries::CommandId) {
+      return true;
+    }
+    if(typeid(*cmd_) != typeid(QUndoCommand) || cmd_->childCount() == 0) {
+      return false;
+    }
+    for(int i = 0; i < cmd_->childCount(); ++i) {
+      if(!isJournaledCommand(cmd_->child(i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
 using namespace Tellico;
 using Tellico::Data::Document;
 Document* Document::s_self = nullptr;
 
 Document::Document() : QObject(), m_coll(nullptr), m_isModified(false),
     m_loadAllImages(false), m_validFile(false), m_importer(nullptr), m_cancelImageWriting(true),
-    m_fileFormat(Import::TellicoImporter::Unknown) {
+    m_fileFormat(Import::TellicoImporter::Unknown), m_fullSaveNeeded(false) {
   m_allImagesOnDisk = Config::imageLocation() != Config::ImagesInFile;
   newDocument(Collection::Book);
 }
@@ -81,6 +112,13 @@ void Document::setURL(const QUrl& url_) {
 }
 
 void Document::setModified(bool modified_) {
+  if(modified_) {
+    m_fullSaveNeeded = true;
+  }
+  updateModified(modified_);
+}
+
+void Document::updateModified(bool modified_) {
   if(modified_ != m_isModified) {
     m_isModified = modified_;
     emit signalModified(m_isModified);
@@ -96,7 +134,37 @@ void Document::slotSetModified() {
  * the document modified flag
  */
 void Document::slotSetClean(bool clean_) {
-  setModified(!clean_);
+  updateModified(!clean_);
+}
+
+void Document::setEntriesModified(const Tellico::Data::EntryList& entries_) {
+  foreach(EntryPtr entry, entries_) {
+    if(entry->collection() == m_coll) {
+      m_journalEntryIds.insert(entry->id());
+    }
+  }
+}
+
+void Document::setEntryImagesLoaded(const Tellico::Data::EntryList& entries_) {
+  setEntriesModified(entries_);
+  // the entries are already modified if they have not been saved since they were added
+  bool saved = false;
+  foreach(EntryPtr entry, entries_) {
+    if(m_pendingImageEntryIds.remove(entry->id())) {
+      saved = true;
+    }
+  }
+  if(saved) {
+    updateModified(true);
+  }
+}
+
+void Document::setCommandHistory(QUndoStack* history_) {
+  m_commandHistory = history_;
+}
+
+QUrl Document::journalURL(const QUrl& url_) {
+  return TellicoJournal::journalURL(url_);
 }
 
 bool Document::newDocument(int type_) {
@@ -117,12 +185,16 @@ bool Document::newDocument(int type_) {
   setURL(url);
   m_validFile = false;
   m_fileFormat = Import::TellicoImporter::Unknown;
+  m_journalEntryIds.clear();
+  m_journalFileHash.clear();
+  m_fullSaveNeeded = false;
 
   return true;
 }
 
 bool Document::openDocument(const QUrl& url_) {
   MARK;
+  TRACE_SCOPE("file", "openDocument");
   m_loadAllImages = false;
   // delayed image loading only works for local files
   if(!url_.isLocalFile()) {
@@ -164,12 +236,42 @@ bool Document::openDocument(const QUrl& url_) {
     return false;
   }
   deleteContents();
+  m_journalEntryIds.clear();
+  m_journalFileHash.clear();
+  m_fullSaveNeeded = false;
+  // the importer already applied the journal, keep those entries in it until the next complete save
+  if(m_importer) {
+    foreach(ID id, m_importer->journalEntryIds()) {
+      m_journalEntryIds.insert(id);
+    }
+    m_journalFileHash = m_importer->journalFileHash();
+  }
   m_coll = coll;
   m_coll->setTrackGroups(true);
   setURL(url_);
   m_validFile = true;
 
   emit signalCollectionAdded(m_coll);
+  // the default group field and the people pseudo-group are the most likely to be chosen
+  // so group the entries by them in the background, along with any which were grouped
+  // when the cache was written
+  QStringList groupFields;
+  groupFields << m_coll->defaultGroupField() << Data::Collection::s_peopleGroupName;
+  const QStringList groupFieldHints = m_importer ? m_importer->groupFieldHints() : QStringList();
+  foreach(const QString& fieldName, groupFieldHints) {
+    if(!groupFields.contains(fieldName)) {
+      groupFields << fieldName;
+    }
+  }
+  m_coll->precomputeEntryGroupDicts(groupFields);
+
+  // the cache only matches the file, without the journal. And when the images are inside
+  // the XML file, it has to be read again anyway
+  if(m_importer && !m_importer->loadedFromCache() && m_journalEntryIds.isEmpty() &&
+     !(m_fileFormat == Import::TellicoImporter::XML && m_importer->hasImages()) &&
+     url_.isLocalFile() && Config::cacheFiles()) {
+    QTimer::singleShot(0, this, &Document::slotWriteCache);
+  }
 
   // m_importer might have been deleted?
   setModified(m_importer && m_importer->modifiedOriginal());
@@ -190,6 +292,13 @@ bool Document::openDocument(const QUrl& url_) {
 }
 
 bool Document::saveDocument(const QUrl& url_, bool force_) {
+  TRACE_SCOPE("file", "saveDocument");
+  // when only a few entries have changed, just write those to the journal
+  if(url_ == m_url && saveJournal(url_)) {
+    setModified(false);
+    return true;
+  }
+
   // FileHandler::queryExists calls FileHandler::writeBackupFile
   // so the only reason to check queryExists() is if the url to write to is different than the current one
   if(url_ == m_url) {
@@ -206,6 +315,8 @@ bool Document::saveDocument(const QUrl& url_, bool force_) {
   m_cancelImageWriting = true;
   qApp->processEvents();
 
+  const QList<PendingImage> pendingImages = clearPendingImages(m_coll->entries());
+
   ProgressItem& item = ProgressManager::self()->newProgressItem(this, i18n("Saving file..."), false);
   ProgressItem::Done done(this);
 
@@ -245,17 +356,173 @@ bool Document::saveDocument(const QUrl& url_, bool force_) {
   exporter->setOptions(opt);
   const bool success = exporter->exec();
   item.setProgress(int(0.9*totalSteps));
+  restorePendingImages(pendingImages);
 
   if(success) {
     setURL(url_);
     // if successful, doc is no longer modified
     setModified(false);
+    // the complete file supersedes any journal
+    if(url_.isLocalFile()) {
+      TellicoJournal::remove(url_);
+      // the cache of an XML file holding its own images is never loaded, so don't bother hashing and writing it
+      const bool embeddedImages = m_fileFormat == Import::TellicoImporter::XML && includeImages;
+      if(embeddedImages || !Config::cacheFiles() || !TellicoCache(url_).write(m_coll, false /* no embedded images */)) {
+        TellicoCache::remove(url_);
+      }
+    }
+    m_journalEntryIds.clear();
+    m_journalFileHash.clear();
+    m_fullSaveNeeded = false;
+    m_pendingImageEntryIds.clear();
+    foreach(const PendingImage& image, pendingImages) {
+      m_pendingImageEntryIds.insert(image.entry->id());
+    }
   } else {
     myDebug() << "Document::saveDocument() - not successful saving to" << url_.url();
   }
   return success;
 }
 
+void Document::slotWriteCache() {
+  // anything changed since opening the file would not match it
+  if(!m_coll || m_isModified || !m_journalEntryIds.isEmpty() || !m_url.isLocalFile()) {
+    return;
+  }
+  TellicoCache(m_url).write(m_coll, false /* no embedded images */);
+}
+
+bool Document::saveJournal(const QUrl& url_) {
+  if(m_fullSaveNeeded || m_journalEntryIds.isEmpty() || !url_.isLocalFile() ||
+     !QFile::exists(url_.toLocalFile())) {
+    return false;
+  }
+  TRACE_SCOPE("file", "saveJournal");
+  if(m_journalEntryIds.count() > JOURNAL_MAX_ENTRIES ||
+     100 * m_journalEntryIds.count() > JOURNAL_MAX_PERCENT * m_coll->entryCount()) {
+    return false;
+  }
+  if(!journalHistoryOnly()) {
+    return false;
+  }
+
+  const int imageLocation = Config::imageLocation();
+  EntryList entries;
+  StringSet images;
+  foreach(ID id, m_journalEntryIds) {
+    EntryPtr entry = m_coll->entryById(id);
+    if(!entry) {
+      return false;
+    }
+    foreach(FieldPtr field, m_coll->imageFields()) {
+      const QString imageId = ImageFactory::requestedImageId(entry->field(field));
+      if(imageId.isEmpty() || ImageFactory::isImageRequestPending(QUrl(imageId)) ||
+         ImageFactory::imageInfo(imageId).linkOnly) {
+        continue;
+      }
+      // images inside the file can only be written with the complete file
+      if(imageLocation == Config::ImagesInFile) {
+        return false;
+      }
+      images.add(imageId);
+    }
+    entries.append(entry);
+  }
+
+  // existing images are not rewritten, so this only writes the new ones
+  if(imageLocation == Config::ImagesInLocalDir) {
+    ImageDirectory imgDir(ImageFactory::localDirectory(url_));
+    foreach(const QString& imageId, images) {
+      ImageFactory::writeCachedImage(imageId, &imgDir);
+    }
+  } else {
+    foreach(const QString& imageId, images) {
+      ImageFactory::writeCachedImage(imageId, ImageFactory::DataDir);
+    }
+  }
+
+  Export::TellicoXMLExporter exporter(m_coll);
+  exporter.setEntries(entries);
+  exporter.setIncludeImages(false);
+  exporter.setOptions(Export::ExportUTF8 | Export::ExportForce);
+  const QList<PendingImage> pendingImages = clearPendingImages(entries);
+  const QByteArray text = exporter.text().toUtf8();
+  restorePendingImages(pendingImages);
+  // the file does not change until the next complete save, so it is only hashed once
+  if(m_journalFileHash.isEmpty()) {
+    m_journalFileHash = TellicoJournal::fileHash(url_);
+  }
+  if(!TellicoJournal(url_).write(text, m_journalFileHash)) {
+    myDebug() << "failed to write journal for" << url_.toLocalFile();
+    TellicoJournal::remove(url_);
+    return false;
+  }
+  foreach(const PendingImage& image, pendingImages) {
+    m_pendingImageEntryIds.insert(image.entry->id());
+  }
+  return true;
+}
+
+// entries added from the fetch dialog hold the url of any image still being downloaded, see
+// Controller::slotImageRequestFinished(). The field gets the image id once the image is loaded
+QList<Tellico::Data::Document::PendingImage> Document::clearPendingImages(const Tellico::Data::EntryList& entries_) {
+  QList<PendingImage> images;
+  const FieldList imageFields = m_coll->imageFields();
+  if(imageFields.isEmpty()) {
+    return images;
+  }
+  foreach(EntryPtr entry, entries_) {
+    foreach(FieldPtr field, imageFields) {
+      const QString value = entry->field(field);
+      if(value.isEmpty()) {
+        continue;
+      }
+      const QString id = ImageFactory::requestedImageId(value);
+      if(id != value) {
+        // the request is done, an empty id means the image could not be loaded
+        entry->setField(field, id, false);
+      } else if(ImageFactory::isImageRequestPending(QUrl(value))) {
+        PendingImage image;
+        image.entry = entry;
+        image.field = field;
+        image.url = value;
+        images << image;
+        entry->setField(field, QString(), false);
+      }
+    }
+  }
+  return images;
+}
+
+void Document::restorePendingImages(const QList<PendingImage>& images_) {
+  foreach(const PendingImage& image, images_) {
+    image.entry->setField(image.field, image.url, false);
+  }
+}
+
+bool Document::journalHistoryOnly() const {
+  // without an undo history, only the modified flag is tracked
+  if(!m_commandHistory) {
+    return true;
+  }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+  const int cleanIndex = m_commandHistory->cleanIndex();
+  if(cleanIndex < 0) {
+    return false;
+  }
+  // commands between the clean state and the current one, whether done or undone
+  const int index = m_commandHistory->index();
+  for(int i = qMin(cleanIndex, index); i < qMax(cleanIndex, index); ++i) {
+    if(!isJournaledCommand(m_commandHistory->command(i))) {
+      return false;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool Document::closeDocument() {
   if(m_importer) {
     m_importer->deleteLater();
@@ -384,6 +651,8 @@ void Document::replaceCollection(Tellico::Data::CollPtr coll_) {
   QUrl url = QUrl::fromLocalFile(i18n(Tellico::untitledFilename));
   setURL(url);
   m_validFile = false;
+  m_journalEntryIds.clear();
+  m_journalFileHash.clear();
 
   // the collection gets cleared by the CollectionCommand that called this function
   // no need to do it here
@@ -31,6 +31,9 @@
 #include <QObject>
 #include <QPointer>
 #include <QUrl>
+#include <QSet>
+
+class QUndoStack;
 
 namespace Tellico {
   namespace Import {
@@ -79,7 +82,36 @@ public:
    * @return A boolean indicating the modified status
    */
   bool isModified() const { return m_isModified; }
+  /**
+   * Sets the modified flag. Marking the document as modified from outside
+   * of the undo history forces the next save to rewrite the whole file.
+   */
   void setModified(bool modified);
+  /**
+   * Records that only the field values of some entries have changed, so the next save
+   * to the same file may append them to the journal instead of rewriting the file.
+   *
+   * @param entries The modified entries
+   */
+  void setEntriesModified(const EntryList& entries);
+  /**
+   * Records that the images requested for some entries have been set, without any command
+   * in the undo history. The document is only marked modified if the entries were saved
+   * while the images were still loading.
+   *
+   * @param entries The entries with new images
+   */
+  void setEntryImagesLoaded(const EntryList& entries);
+  /**
+   * Sets the undo history which gets checked before writing the journal, to verify
+   * that nothing other than entry values has been modified since the last save.
+   */
+  void setCommandHistory(QUndoStack* history);
+  /**
+   * Returns the location of the journal holding the entries saved incrementally
+   * since the last complete save of the file at @p url.
+   */
+  static QUrl journalURL(const QUrl& url);
   /**
    * Sets whether all images are loaded from file or not
    */
@@ -223,6 +255,10 @@ private Q_SLOTS:
    * images to temp dir initially
    */
   void slotLoadAllImages();
+  /**
+   * Writes the cache of the file which was just opened, so it opens faster next time
+   */
+  void slotWriteCache();
 
 private:
   static Document* s_self;
@@ -233,6 +269,25 @@ private:
    */
   void writeAllImages(int cacheDir, const QUrl& url=QUrl());
   bool pruneImages();
+  void updateModified(bool modified);
+  /**
+   * Writes the entries modified since the last complete save to the journal. Returns
+   * false if the whole file must be written instead.
+   */
+  bool saveJournal(const QUrl& url);
+  bool journalHistoryOnly() const;
+
+  struct PendingImage {
+    EntryPtr entry;
+    FieldPtr field;
+    QString url;
+  };
+  /**
+   * Clears the image fields which still hold the url of an image being downloaded,
+   * since the url is not an image id. Requests which are done are set for good.
+   */
+  QList<PendingImage> clearPendingImages(const EntryList& entries);
+  void restorePendingImages(const QList<PendingImage>& images);
 
   // make all constructors private
   Document();
@@ -249,6 +304,14 @@ private:
   bool m_cancelImageWriting;
   int m_fileFormat;
   bool m_allImagesOnDisk;
+  // entries saved to the journal, or waiting to be, since the last complete save
+  QSet<ID> m_journalEntryIds;
+  bool m_fullSaveNeeded;
+  // the hash of the data file for the journal, computed at most once after opening or saving the file
+  QByteArray m_journalFileHash;
+  // entries which were saved without an image that was still loading
+  QSet<ID> m_pendingImageEntryIds;
+  QPointer<QUndoStack> m_commandHistory;
 };
 
   } // end namespace
@@ -0,0 +1,395 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "duplicatefinder.h"
+#include "collection.h"
+#include "entry.h"
+#include "field.h"
+#include "fieldformat.h"
+#include "entrycomparison.h"
+#include "collectionfactory.h"
+#include "utils/isbnvalidator.h"
+#include "utils/lccnvalidator.h"
+#include "tellico_debug.h"
+
+#include <QUrl>
+#include <QThread>
+
+#include <algorithm>
+
+using Tellico::DuplicateFinder;
+
+namespace {
+  // the entries and pairs are split into more jobs than threads, so the progress moves along
+  static const int DUPLICATE_JOBS_PER_THREAD = 4;
+  static const int DUPLICATE_PAIR_CHUNK_SIZE = 2000;
+  // a key shared by too many entries says little about whether they match, and only
+  // adds comparisons. Identifiers are allowed larger blocks than words of the title
+  static const int DUPLICATE_MAX_ID_BLOCK = 2000;
+  static const int DUPLICATE_MAX_TITLE_BLOCK = 200;
+
+  const QStringList& identifierFields() {
+    static const QStringList fields = QStringList() << QStringLiteral("isbn")
+                                                    << QStringLiteral("lccn")
+                                                    << QStringLiteral("upc")
+                                                    << QStringLiteral("imdb")
+                                                    << QStringLiteral("doi")
+                                                    << QStringLiteral("pmid")
+                                                    << QStringLiteral("arxiv")
+                                                    << QStringLiteral("url");
+    return fields;
+  }
+
+  // the same normalization that EntryComparison::score() uses to decide if identifiers match
+  QString normalizedIdentifier(const QString& fieldName_, const QString& value_) {
+    if(fieldName_ == QLatin1String("isbn")) {
+      return Tellico::ISBNValidator::cleanValue(Tellico::ISBNValidator::isbn10(value_)).toUpper();
+    } else if(fieldName_ == QLatin1String("lccn")) {
+      return Tellico::LCCNValidator::formalize(value_);
+    } else if(fieldName_ == QLatin1String("imdb")) {
+      QUrl u = QUrl::fromUserInput(value_);
+      u.setHost(QString());
+      return u.toString();
+    } else if(fieldName_ == QLatin1String("arxiv")) {
+      return Tellico::EntryComparison::normalizeArxiv(value_);
+    }
+    return value_.trimmed().toLower();
+  }
+
+  // lower-case words of the title, without accents or punctuation
+  QStringList titleWords(const QString& title_) {
+    const QString title = title_.normalized(QString::NormalizationForm_D).toLower();
+    QStringList words;
+    QString word;
+    for(int i = 0; i < title.length(); ++i) {
+      const QChar c = title.at(i);
+      if(c.isLetterOrNumber()) {
+        word += c;
+      } else if(!c.isMark() && !word.isEmpty()) {
+        words << word;
+        word.clear();
+      }
+    }
+    if(!word.isEmpty()) {
+      words << word;
+    }
+    return words;
+  }
+
+  inline qint64 pairKey(int entry1_, int entry2_) {
+    return (static_cast<qint64>(qMin(entry1_, entry2_)) << 32) | qMax(entry1_, entry2_);
+  }
+}
+
+class DuplicateFinder::KeyReader : public QRunnable {
+public:
+  KeyReader(DuplicateFinder* finder_, int begin_, int end_)
+      : m_finder(finder_), m_keys(finder_->m_keys.data()), m_begin(begin_), m_end(end_) {}
+
+  virtual void run() Q_DECL_OVERRIDE {
+    for(int i = m_begin; i < m_end && !m_finder->m_cancelled.load(); ++i) {
+      m_keys[i] = blockingKeys(m_finder->m_copies.at(i));
+    }
+    QMetaObject::invokeMethod(m_finder, "slotKeysRead", Qt::QueuedConnection);
+  }
+
+private:
+  DuplicateFinder* m_finder;
+  QStringList* m_keys;
+  const int m_begin;
+  const int m_end;
+};
+
+class DuplicateFinder::PairBuilder : public QRunnable {
+public:
+  PairBuilder(DuplicateFinder* finder_) : m_finder(finder_) {}
+
+  virtual void run() Q_DECL_OVERRIDE {
+    QHash<QString, QVector<int> > blocks;
+    for(int i = 0; i < m_finder->m_keys.count() && !m_finder->m_cancelled.load(); ++i) {
+      foreach(const QString& key, m_finder->m_keys.at(i)) {
+        blocks[key].append(i);
+      }
+    }
+
+    QVector<qint64> pairs;
+    QHash<QString, QVector<int> >::ConstIterator it = blocks.constBegin();
+    for( ; it != blocks.constEnd() && !m_finder->m_cancelled.load(); ++it) {
+      const QVector<int>& block = it.value();
+      const int maxSize = it.key().startsWith(QLatin1String("title:")) ? DUPLICATE_MAX_TITLE_BLOCK
+                                                                       : DUPLICATE_MAX_ID_BLOCK;
+      if(block.count() < 2 || block.count() > maxSize) {
+        continue;
+      }
+      for(int i = 0; i < block.count(); ++i) {
+        for(int j = i+1; j < block.count(); ++j) {
+          pairs.append(pairKey(block.at(i), block.at(j)));
+        }
+      }
+    }
+    // entries sharing several keys would be compared more than once
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    m_finder->m_pairs = pairs;
+    QMetaObject::invokeMethod(m_finder, "slotPairsFound", Qt::QueuedConnection);
+  }
+
+private:
+  DuplicateFinder* m_finder;
+};
+
+class DuplicateFinder::PairScorer : public QRunnable {
+public:
+  PairScorer(DuplicateFinder* finder_, int chunk_, int begin_, int end_)
+      : m_finder(finder_), m_matches(finder_->m_matches.data() + chunk_)
+      , m_chunk(chunk_), m_begin(begin_), m_end(end_) {}
+
+  virtual void run() Q_DECL_OVERRIDE {
+    const Data::EntryList& copies = m_finder->m_copies;
+    for(int i = m_begin; i < m_end && !m_finder->m_cancelled.load(); ++i) {
+      const qint64 pair = m_finder->m_pairs.at(i);
+      Data::EntryPtr entry1 = copies.at(static_cast<int>(pair >> 32));
+      Data::EntryPtr entry2 = copies.at(static_cast<int>(pair & 0xffffffff));
+      if(m_finder->m_searchColl->sameEntry(entry1, entry2) >= EntryComparison::ENTRY_GOOD_MATCH) {
+        m_matches->append(pair);
+      }
+    }
+    QMetaObject::invokeMethod(m_finder, "slotPairsScored", Qt::QueuedConnection, Q_ARG(int, m_chunk));
+  }
+
+private:
+  DuplicateFinder* m_finder;
+  QVector<qint64>* m_matches;
+  const int m_chunk;
+  const int m_begin;
+  const int m_end;
+};
+
+DuplicateFinder::DuplicateFinder(Tellico::Data::CollPtr coll_, QObject* parent_)
+    : QObject(parent_), m_coll(coll_), m_pendingJobs(0), m_pairsScored(0), m_running(false) {
+  Q_ASSERT(m_coll);
+}
+
+DuplicateFinder::~DuplicateFinder() {
+  m_cancelled.store(1);
+  m_pool.clear();
+  m_pool.waitForDone();
+}
+
+void DuplicateFinder::start() {
+  if(m_running) {
+    return;
+  }
+  // jobs from a cancelled search may still be running
+  m_pool.waitForDone();
+  m_running = true;
+  m_cancelled.store(0);
+  m_entries = m_coll->entries();
+  // the entries read their fields from their collection, and sameEntry() looks up the
+  // fields to compare, so the copies belong to a copy of the collection and its fields
+  m_searchColl = CollectionFactory::collection(m_coll->type(), false);
+  foreach(Data::FieldPtr field, m_coll->fields()) {
+    m_searchColl->addField(Data::FieldPtr(new Data::Field(*field)));
+  }
+  m_copies.clear();
+  m_copies.reserve(m_entries.count());
+  foreach(Data::EntryPtr entry, m_entries) {
+    Data::EntryPtr copy(new Data::Entry(*entry));
+    copy->setCollection(m_searchColl);
+    m_copies << copy;
+  }
+  m_setOf.resize(m_entries.count());
+  for(int i = 0; i < m_setOf.count(); ++i) {
+    m_setOf[i] = i;
+  }
+  m_setMembers.clear();
+  m_pairs.clear();
+  m_matches.clear();
+  m_pairsScored = 0;
+
+  if(m_entries.count() < 2) {
+    finish();
+    return;
+  }
+
+  m_keys = QVector<QStringList>(m_copies.count());
+  const int jobCount = qMax(1, QThread::idealThreadCount()) * DUPLICATE_JOBS_PER_THREAD;
+  const int jobSize = (m_copies.count() + jobCount - 1) / jobCount;
+  m_pendingJobs = 0;
+  for(int begin = 0; begin < m_copies.count(); begin += jobSize) {
+    ++m_pendingJobs;
+    m_pool.start(new KeyReader(this, begin, qMin(begin + jobSize, m_copies.count())));
+  }
+}
+
+void DuplicateFinder::slotCancel() {
+  if(!m_running) {
+    return;
+  }
+  m_cancelled.store(1);
+  m_pool.clear();
+  finish();
+}
+
+void DuplicateFinder::slotKeysRead() {
+  if(!m_running || --m_pendingJobs > 0) {
+    return;
+  }
+  m_pool.start(new PairBuilder(this));
+}
+
+void DuplicateFinder::slotPairsFound() {
+  if(!m_running) {
+    return;
+  }
+  // the keys are not needed any longer
+  m_keys.clear();
+  emit signalProgress(0, m_pairs.count());
+  if(m_pairs.isEmpty()) {
+    finish();
+    return;
+  }
+
+  const int chunkCount = (m_pairs.count() + DUPLICATE_PAIR_CHUNK_SIZE - 1) / DUPLICATE_PAIR_CHUNK_SIZE;
+  m_matches = QVector< QVector<qint64> >(chunkCount);
+  m_pendingJobs = chunkCount;
+  for(int chunk = 0; chunk < chunkCount; ++chunk) {
+    const int begin = chunk * DUPLICATE_PAIR_CHUNK_SIZE;
+    m_pool.start(new PairScorer(this, chunk, begin, qMin(begin + DUPLICATE_PAIR_CHUNK_SIZE, m_pairs.count())));
+  }
+}
+
+void DuplicateFinder::slotPairsScored(int chunk_) {
+  if(!m_running) {
+    return;
+  }
+  m_pairsScored = qMin(m_pairsScored + DUPLICATE_PAIR_CHUNK_SIZE, m_pairs.count());
+
+  QList<int> modifiedSets;
+  foreach(qint64 pair, m_matches.at(chunk_)) {
+    const int root = joinSets(static_cast<int>(pair >> 32), static_cast<int>(pair & 0xffffffff));
+    if(!modifiedSets.contains(root)) {
+      modifiedSets << root;
+    }
+  }
+  m_matches[chunk_].clear();
+
+  foreach(int root, modifiedSets) {
+    // a set might have been joined to a larger one by a later pair
+    if(m_setOf.at(root) != root) {
+      continue;
+    }
+    const Data::EntryList entries = entriesInSet(root);
+    if(entries.count() > 1) {
+      emit signalDuplicates(entries);
+    }
+  }
+  emit signalProgress(m_pairsScored, m_pairs.count());
+
+  if(--m_pendingJobs == 0) {
+    finish();
+  }
+}
+
+QList<Tellico::Data::EntryList> DuplicateFinder::duplicates() {
+  QList<Data::EntryList> sets;
+  for(QHash<int, QVector<int> >::ConstIterator it = m_setMembers.constBegin(); it != m_setMembers.constEnd(); ++it) {
+    const Data::EntryList entries = entriesInSet(it.key());
+    if(entries.count() > 1) {
+      sets << entries;
+    }
+  }
+  return sets;
+}
+
+// the smaller set is moved into the larger one, so an entry is moved only a few times
+int DuplicateFinder::joinSets(int entry1_, int entry2_) {
+  int root1 = m_setOf.at(entry1_);
+  int root2 = m_setOf.at(entry2_);
+  if(root1 == root2) {
+    return root1;
+  }
+  if(!m_setMembers.contains(root1)) {
+    m_setMembers.insert(root1, QVector<int>() << root1);
+  }
+  if(!m_setMembers.contains(root2)) {
+    m_setMembers.insert(root2, QVector<int>() << root2);
+  }
+  if(m_setMembers.value(root1).count() < m_setMembers.value(root2).count()) {
+    qSwap(root1, root2);
+  }
+  const QVector<int> members = m_setMembers.take(root2);
+  foreach(int member, members) {
+    m_setOf[member] = root1;
+  }
+  m_setMembers[root1] += members;
+  return root1;
+}
+
+Tellico::Data::EntryList DuplicateFinder::entriesInSet(int root_) {
+  Data::EntryList entries;
+  foreach(int member, m_setMembers.value(root_)) {
+    Data::EntryPtr entry = m_entries.at(member);
+    if(m_coll->entryById(entry->id()) == entry) {
+      entries << entry;
+    }
+  }
+  return entries;
+}
+
+void DuplicateFinder::finish() {
+  m_running = false;
+  emit signalFinished();
+}
+
+QStringList DuplicateFinder::blockingKeys(Tellico::Data::EntryPtr entry_) {
+  QStringList keys;
+  Data::CollPtr coll = entry_->collection();
+  if(!coll) {
+    return keys;
+  }
+
+  foreach(const QString& fieldName, identifierFields()) {
+    Data::FieldPtr field = coll->fieldByName(fieldName);
+    if(!field) {
+      continue;
+    }
+    foreach(const QString& value, FieldFormat::splitValue(entry_->field(field))) {
+      const QString id = normalizedIdentifier(fieldName, value);
+      if(!id.isEmpty()) {
+        keys << fieldName + QLatin1Char(':') + id;
+      }
+    }
+  }
+
+  // pairs of words from the title, after any leading article
+  const QStringList words = titleWords(FieldFormat::sortKeyTitle(entry_->field(QStringLiteral("title"))));
+  if(words.count() == 1) {
+    keys << QLatin1String("title:") + words.first();
+  }
+  for(int i = 1; i < words.count(); ++i) {
+    keys << QLatin1String("title:") + words.at(i-1) + QLatin1Char(' ') + words.at(i);
+  }
+  return keys;
+}
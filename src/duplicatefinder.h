@@ -0,0 +1,122 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_DUPLICATEFINDER_H
+#define TELLICO_DUPLICATEFINDER_H
+
+#include "datavectors.h"
+
+#include <QObject>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QThreadPool>
+#include <QAtomicInt>
+
+namespace Tellico {
+
+/**
+ * The DuplicateFinder looks for duplicate entries throughout a collection.
+ *
+ * Rather than comparing every pair of entries, each entry gets a few blocking keys, such
+ * as a normalized ISBN or pairs of words from the title, and only the entries which share
+ * a key are compared with @ref Data::Collection::sameEntry. Both the keys and the comparisons
+ * run on a thread pool, reading a copy of the collection's fields and entries, so the collection
+ * may be edited while the search runs. The sets of duplicates are announced as they are found.
+ *
+ * @author Robby Stephenson
+ */
+class DuplicateFinder : public QObject {
+Q_OBJECT
+
+public:
+  DuplicateFinder(Data::CollPtr coll, QObject* parent = nullptr);
+  ~DuplicateFinder();
+
+  /**
+   * Starts the search, which continues in the background. @ref signalFinished is
+   * emitted when it is done or cancelled.
+   */
+  void start();
+  bool isRunning() const { return m_running; }
+  /**
+   * Returns every set of duplicates found so far. Entries which have been removed from
+   * the collection since the search started are not included.
+   */
+  QList<Data::EntryList> duplicates();
+  /**
+   * Returns the blocking keys for an entry. Entries without any key in common
+   * are never compared to each other.
+   */
+  static QStringList blockingKeys(Data::EntryPtr entry);
+
+public Q_SLOTS:
+  void slotCancel();
+
+Q_SIGNALS:
+  /**
+   * Emitted when a set of duplicates is found, or when it grows. The list has every
+   * entry in the set, so a set might be announced more than once.
+   */
+  void signalDuplicates(const Tellico::Data::EntryList& entries);
+  void signalProgress(int done, int total);
+  void signalFinished();
+
+private Q_SLOTS:
+  void slotKeysRead();
+  void slotPairsFound();
+  void slotPairsScored(int chunk);
+
+private:
+  class KeyReader;
+  class PairBuilder;
+  class PairScorer;
+
+  int joinSets(int entry1, int entry2);
+  Data::EntryList entriesInSet(int root);
+  void finish();
+
+  Data::CollPtr m_coll;
+  Data::EntryList m_entries;
+  // the threads only read the copies, never the collection or its entries
+  Data::CollPtr m_searchColl;
+  Data::EntryList m_copies;
+  QVector<QStringList> m_keys;
+  // every pair of entries to compare, the lower index is in the high bits
+  QVector<qint64> m_pairs;
+  QVector< QVector<qint64> > m_matches;
+  // each entry points to the first entry of its set, which holds the list of members
+  QVector<int> m_setOf;
+  QHash<int, QVector<int> > m_setMembers;
+
+  QThreadPool m_pool;
+  QAtomicInt m_cancelled;
+  int m_pendingJobs;
+  int m_pairsScored;
+  bool m_running;
+};
+
+} // end namespace
+
+#endif
@@ -34,6 +34,7 @@
 #include <KLocalizedString>
 
 #include <QRegExp>
+#include <QMutexLocker>
 
 using namespace Tellico;
 using namespace Tellico::Data;
@@ -59,18 +60,41 @@ Entry::Entry(const Entry& entry_) :
     QSharedData(entry_),
     m_coll(entry_.m_coll),
     m_id(-1),
-    m_fieldValues(entry_.m_fieldValues),
-    m_formattedFields(entry_.m_formattedFields) {
+    m_fieldValues(entry_.m_fieldValues) {
+  QMutexLocker locker(&entry_.m_cacheMutex);
+  m_formattedFields = entry_.m_formattedFields;
+  m_preparedFields = entry_.m_preparedFields;
+  m_formattedFieldLists = entry_.m_formattedFieldLists;
 }
 
 Entry& Entry::operator=(const Entry& other_) {
   if(this == &other_) return *this;
 
 //  static_cast<QSharedData&>(*this) = static_cast<const QSharedData&>(other_);
+  // swapping values for undo assigns to an entry in the collection, which keeps a value index
+  CollPtr indexColl;
+  if(m_coll && m_coll->isIndexedEntry(this)) {
+    indexColl = m_coll;
+    indexColl->indexEntryValues(this, -1);
+  }
   m_coll = other_.m_coll;
   m_id = other_.m_id;
   m_fieldValues = other_.m_fieldValues;
-  m_formattedFields = other_.m_formattedFields;
+  {
+    // copy the other caches first, so the two mutexes are never held together
+    other_.m_cacheMutex.lock();
+    const QHash<QString, QString> formattedFields = other_.m_formattedFields;
+    const QHash<QString, QString> preparedFields = other_.m_preparedFields;
+    const QHash<QString, QStringList> formattedFieldLists = other_.m_formattedFieldLists;
+    other_.m_cacheMutex.unlock();
+    QMutexLocker locker(&m_cacheMutex);
+    m_formattedFields = formattedFields;
+    m_preparedFields = preparedFields;
+    m_formattedFieldLists = formattedFieldLists;
+  }
+  if(indexColl) {
+    indexColl->indexEntryValues(this, 1);
+  }
   return *this;
 }
 
@@ -146,46 +170,162 @@ QString Entry::formattedField(Tellico::Data::FieldPtr field_, FieldFormat::Reque
 
   // if auto format is not set or FormatNone, then just return the value
   if(flag == FieldFormat::FormatNone) {
-    return m_coll->prepareText(field(field_));
-  }
-
-  if(!m_formattedFields.contains(field_->name())) {
-    QString formattedValue;
-    if(field_->type() == Field::Table) {
-      QStringList rows;
-      // we only format the first column
-      foreach(const QString& row, FieldFormat::splitTable(field(field_->name()))) {
-        QStringList columns = FieldFormat::splitRow(row);
-        QStringList newValues;
-        if(!columns.isEmpty()) {
-          foreach(const QString& value, FieldFormat::splitValue(columns.at(0))) {
-            newValues << FieldFormat::format(value, field_->formatType(), FieldFormat::DefaultFormat);
-          }
-          columns.replace(0, newValues.join(FieldFormat::delimiterString()));
-        }
-        rows << columns.join(FieldFormat::columnDelimiterString());
+    if(!m_coll->preparesText()) {
+      return field(field_);
+    }
+    // preparing the text is not free, and views ask for the same value on every paint
+    {
+      QMutexLocker locker(&m_cacheMutex);
+      QHash<QString, QString>::ConstIterator it = m_preparedFields.constFind(field_->name());
+      if(it != m_preparedFields.constEnd()) {
+        return it.value();
       }
-      formattedValue = rows.join(FieldFormat::rowDelimiterString());
-    } else {
-      QStringList values;
-      if(field_->hasFlag(Field::AllowMultiple)) {
-        values = FieldFormat::splitValue(field(field_->name()));
-      } else {
-        values << field(field_->name());
+    }
+    // the lock is not held while formatting, so two threads might both prepare the value
+    const QString value = m_coll->prepareText(field(field_));
+    QMutexLocker locker(&m_cacheMutex);
+    m_preparedFields.insert(field_->name(), value);
+    return value;
+  }
+
+  {
+    QMutexLocker locker(&m_cacheMutex);
+    QHash<QString, QString>::ConstIterator it = m_formattedFields.constFind(field_->name());
+    if(it != m_formattedFields.constEnd()) {
+      return it.value();
+    }
+  }
+
+  QString formattedValue;
+  if(field_->type() == Field::Table) {
+    QStringList rows;
+    // we only format the first column
+    foreach(const QString& row, FieldFormat::splitTable(field(field_->name()))) {
+      QStringList columns = FieldFormat::splitRow(row);
+      if(!columns.isEmpty()) {
+        const QStringList newValues = FieldFormat::formatList(FieldFormat::splitValue(columns.at(0)),
+                                                              field_->formatType(), FieldFormat::DefaultFormat);
+        columns.replace(0, newValues.join(FieldFormat::delimiterString()));
       }
-      QStringList formattedValues;
-      foreach(const QString& value, values) {
-        formattedValues << FieldFormat::format(m_coll->prepareText(value), flag, request_);
+      rows << columns.join(FieldFormat::columnDelimiterString());
+    }
+    formattedValue = rows.join(FieldFormat::rowDelimiterString());
+  } else {
+    QStringList values;
+    if(field_->hasFlag(Field::AllowMultiple)) {
+      values = FieldFormat::splitValue(field(field_->name()));
+    } else {
+      values << field(field_->name());
+    }
+    for(int i = 0; i < values.count(); ++i) {
+      values[i] = m_coll->prepareText(values.at(i));
+    }
+    formattedValue = FieldFormat::formatList(values, flag, request_).join(FieldFormat::delimiterString());
+  }
+  if(!formattedValue.isEmpty()) {
+    QMutexLocker locker(&m_cacheMutex);
+    m_formattedFields.insert(field_->name(), formattedValue);
+  }
+  return formattedValue;
+}
+
+void Entry::formatFieldColumn(const Tellico::Data::EntryList& entries_, Tellico::Data::FieldPtr field_) {
+  // derived values, tables and unformatted fields go through formattedField() one entry at a time
+  if(!field_ || field_->hasFlag(Field::Derived) || field_->type() == Field::Table ||
+     field_->formatType() == FieldFormat::FormatNone) {
+    return;
+  }
+
+  // gather the values of every entry without a cached value into one list
+  const bool allowMultiple = field_->hasFlag(Field::AllowMultiple);
+  EntryList columnEntries;
+  QList<int> valueCounts;
+  QStringList values;
+  foreach(EntryPtr entry, entries_) {
+    {
+      QMutexLocker locker(&entry->m_cacheMutex);
+      if(entry->m_formattedFields.contains(field_->name())) {
+        continue;
       }
-      formattedValue = formattedValues.join(FieldFormat::delimiterString());
     }
+    QStringList entryValues;
+    if(allowMultiple) {
+      entryValues = FieldFormat::splitValue(entry->field(field_));
+    } else {
+      entryValues << entry->field(field_);
+    }
+    foreach(const QString& value, entryValues) {
+      values << entry->m_coll->prepareText(value);
+    }
+    columnEntries << entry;
+    valueCounts << entryValues.count();
+  }
+  if(columnEntries.isEmpty()) {
+    return;
+  }
+
+  const QStringList formattedValues = FieldFormat::formatList(values, field_->formatType(), FieldFormat::DefaultFormat);
+  int pos = 0;
+  for(int i = 0; i < columnEntries.count(); ++i) {
+    const QString formattedValue = formattedValues.mid(pos, valueCounts.at(i)).join(FieldFormat::delimiterString());
+    pos += valueCounts.at(i);
     if(!formattedValue.isEmpty()) {
-      m_formattedFields.insert(field_->name(), formattedValue);
+      EntryPtr entry = columnEntries.at(i);
+      QMutexLocker locker(&entry->m_cacheMutex);
+      entry->m_formattedFields.insert(field_->name(), formattedValue);
+    }
+  }
+}
+
+QStringList Entry::formattedFieldList(Tellico::Data::FieldPtr field_, FieldFormat::Request request_) const {
+  if(!field_) {
+    return QStringList();
+  }
+
+  // derived values can change along with any other field, so they're never cached
+  const bool useCache = request_ != FieldFormat::AsIsFormat && !field_->hasFlag(Field::Derived);
+  if(useCache) {
+    QMutexLocker locker(&m_cacheMutex);
+    QHash<QString, QStringList>::const_iterator it = m_formattedFieldLists.constFind(field_->name());
+    if(it != m_formattedFieldLists.constEnd()) {
+      return it.value();
+    }
+  }
+
+  QStringList values;
+  // check table before multiple since tables are always multiple
+  if(field_->type() == Field::Table) {
+    // we only take values from the first column
+    foreach(const QString& row, FieldFormat::splitTable(field(field_))) {
+      const QStringList columns = FieldFormat::splitRow(row);
+      if(columns.isEmpty()) {
+        continue;
+      }
+      QStringList rowValues = FieldFormat::splitValue(columns.at(0));
+      if(request_ != FieldFormat::AsIsFormat) {
+        rowValues = FieldFormat::formatList(rowValues, field_->formatType(), request_);
+      }
+      foreach(const QString& formattedValue, rowValues) {
+        if(!formattedValue.isEmpty()) {
+          values << formattedValue;
+        }
+      }
+    }
+  } else if(field_->hasFlag(Field::AllowMultiple)) {
+    // use a string split instead of regexp split, since we've already enforced the space after the semi-comma
+    values = FieldFormat::splitValue(formattedField(field_, request_), FieldFormat::StringSplit, QString::SkipEmptyParts);
+  } else {
+    const QString value = formattedField(field_, request_);
+    if(!value.isEmpty()) {
+      values << value;
     }
-    return formattedValue;
   }
-  // otherwise, just look it up
-  return m_formattedFields.value(field_->name());
+
+  if(useCache) {
+    QMutexLocker locker(&m_cacheMutex);
+    m_formattedFieldLists.insert(field_->name(), values);
+  }
+  return values;
 }
 
 bool Entry::setField(Tellico::Data::FieldPtr field_, const QString& value_, bool updateMDate_) {
@@ -222,12 +362,24 @@ bool Entry::setField(const QString& name_, const QString& value_, bool updateMDa
   return res;
 }
 
+void Entry::setFieldValues(const QHash<QString, QString>& values_) {
+  // the collection keeps an index of the values of its entries
+  Q_ASSERT(!m_coll || !m_coll->isIndexedEntry(this));
+  m_fieldValues = values_;
+  invalidateFormattedFieldValue();
+}
+
 bool Entry::setFieldImpl(const QString& name_, const QString& value_) {
   // an empty value means remove the field
   if(value_.isEmpty()) {
-    if(m_fieldValues.contains(name_)) {
-      m_fieldValues.remove(name_);
+    QHash<QString, QString>::Iterator it = m_fieldValues.find(name_);
+    if(it != m_fieldValues.end()) {
+      const QString oldValue = it.value();
+      m_fieldValues.erase(it);
       invalidateFormattedFieldValue(name_);
+      if(m_coll) {
+        m_coll->entryValueChanged(this, name_, oldValue, QString());
+      }
     }
     return true;
   }
@@ -242,6 +394,7 @@ bool Entry::setFieldImpl(const QString& name_, const QString& value_) {
     return false;
   }
 
+  const QString oldValue = m_fieldValues.value(name_);
   // the string store is probable only useful for fields with auto-completion or choice/number/bool
   bool shareType = f->type() == Field::Choice ||
                    f->type() == Field::Bool ||
@@ -256,6 +409,7 @@ bool Entry::setFieldImpl(const QString& name_, const QString& value_) {
     m_fieldValues.insert(Tellico::shareString(name_), value_);
   }
   invalidateFormattedFieldValue(name_);
+  m_coll->entryValueChanged(this, name_, oldValue, value_);
   return true;
 }
 
@@ -284,11 +438,24 @@ void Entry::clearGroups() {
   m_groups.clear();
 }
 
+void Entry::clearGroups(const QStringList& fieldNames_) {
+  QMutableListIterator<EntryGroup*> it(m_groups);
+  while(it.hasNext()) {
+    if(fieldNames_.contains(it.next()->fieldName())) {
+      it.remove();
+    }
+  }
+}
+
 // this function gets called before m_groups is updated. In fact, it is used to
 // update that list. This is the function that actually parses the field values
 // and returns the list of the group names.
 QStringList Entry::groupNamesByFieldName(const QString& fieldName_) const {
 //  myDebug() << fieldName_;
+  if(fieldName_ == Collection::s_peopleGroupName) {
+    return peopleGroupNames();
+  }
+
   FieldPtr f = m_coll->fieldByName(fieldName_);
   if(!f) {
     myWarning() << "no field named" << fieldName_;
@@ -296,37 +463,73 @@ QStringList Entry::groupNamesByFieldName(const QString& fieldName_) const {
   }
 
   StringSet groups;
-  // check table before multiple since tables are always multiple
-  if(f->type() == Field::Table) {
-    // we only take groups from the first column
-    foreach(const QString& row, FieldFormat::splitTable(field(f))) {
-      const QStringList columns = FieldFormat::splitRow(row);
-      const QStringList values = columns.isEmpty() ? QStringList() : FieldFormat::splitValue(columns.at(0));
-      foreach(const QString& value, values) {
-        groups.add(FieldFormat::format(value, f->formatType(), FieldFormat::DefaultFormat));
-      }
-    }
-  } else if(f->hasFlag(Field::AllowMultiple)) {
-    // use a string split instead of regexp split, since we've already enforced the space after the semi-comma
-    groups.add(FieldFormat::splitValue(formattedField(f), FieldFormat::StringSplit));
-  } else {
-    groups.add(formattedField(f));
-  }
+  groups.add(formattedFieldList(f));
 
   // possible to be empty for no value
   // but we want to populate an empty group
   return groups.isEmpty() ? QStringList(QString()) : groups.toList();
 }
 
+// the people pseudo-group includes every name from all the people fields
+// the empty group is only used if every people field is empty
+QStringList Entry::peopleGroupNames() const {
+  {
+    QMutexLocker locker(&m_cacheMutex);
+    QHash<QString, QStringList>::const_iterator it = m_formattedFieldLists.constFind(Collection::s_peopleGroupName);
+    if(it != m_formattedFieldLists.constEnd()) {
+      return it.value();
+    }
+  }
+
+  bool useCache = true;
+  StringSet values;
+  foreach(FieldPtr field, m_coll->peopleFields()) {
+    values.add(formattedFieldList(field));
+    if(field->hasFlag(Field::Derived)) {
+      useCache = false;
+    }
+  }
+
+  const QStringList names = values.isEmpty() ? QStringList(QString()) : values.toList();
+  if(useCache) {
+    QMutexLocker locker(&m_cacheMutex);
+    m_formattedFieldLists.insert(Collection::s_peopleGroupName, names);
+  }
+  return names;
+}
+
+QStringList Entry::formattedFieldValues() const {
+  QMutexLocker locker(&m_cacheMutex);
+  return m_formattedFields.values();
+}
+
 bool Entry::isOwned() {
   return (m_coll && m_id > -1 && m_coll->entryCount() > 0 && m_coll->entries().contains(EntryPtr(this)));
 }
 
 // an empty string means invalidate all
 void Entry::invalidateFormattedFieldValue(const QString& name_) {
+  QMutexLocker locker(&m_cacheMutex);
   if(name_.isEmpty()) {
     m_formattedFields.clear();
-  } else if(!m_formattedFields.isEmpty() && m_formattedFields.contains(name_)) {
+    m_preparedFields.clear();
+    m_formattedFieldLists.clear();
+    return;
+  }
+  if(!m_formattedFields.isEmpty() && m_formattedFields.contains(name_)) {
     m_formattedFields.remove(name_);
   }
+  if(!m_preparedFields.isEmpty()) {
+    m_preparedFields.remove(name_);
+  }
+  if(!m_formattedFieldLists.isEmpty()) {
+    m_formattedFieldLists.remove(name_);
+    // the people pseudo-group depends on every name field
+    if(m_formattedFieldLists.contains(Collection::s_peopleGroupName)) {
+      FieldPtr f = m_coll ? m_coll->fieldByName(name_) : FieldPtr();
+      if(!f || f->formatType() == FieldFormat::FormatName) {
+        m_formattedFieldLists.remove(Collection::s_peopleGroupName);
+      }
+    }
+  }
 }
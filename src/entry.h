@@ -30,6 +30,7 @@
 
 #include <QStringList>
 #include <QHash>
+#include <QMutex>
 
 #include <functional>
 
@@ -96,6 +97,27 @@ public:
                          FieldFormat::Request formatted = FieldFormat::DefaultFormat) const;
   QString formattedField(Data::FieldPtr field,
                          FieldFormat::Request formatted = FieldFormat::DefaultFormat) const;
+  /**
+   * Returns the formatted values of a field, split into a list when the field allows multiple
+   * values. For tables, the values come from the first column of every row. The list is cached
+   * along with the formatted value, so that grouping and comparing names does not need to format
+   * and split the value every time.
+   *
+   * @param field The field
+   * @return The list of formatted values, empty values are not included
+   */
+  QStringList formattedFieldList(Data::FieldPtr field,
+                                 FieldFormat::Request formatted = FieldFormat::DefaultFormat) const;
+  /**
+   * Formats the values of a field for a whole list of entries at once, filling in the cached
+   * value that formattedField() returns. Views showing a column of values use this so that the
+   * formatting options are only read once for the column, rather than once for every entry.
+   * Entries which already have a cached value are skipped.
+   *
+   * @param entries The entries
+   * @param field The field
+   */
+  static void formatFieldColumn(const Data::EntryList& entries, Data::FieldPtr field);
   /**
    * Sets the value of an field for the entry. The method first verifies that
    * the value is allowed for that particular key.
@@ -107,6 +129,14 @@ public:
    */
   bool setField(const QString& fieldName, const QString& value, bool updateMDate=true);
   bool setField(Data::FieldPtr field, const QString& value, bool updateMDate=true);
+  /**
+   * Replaces all the field values at once, without checking whether the values are allowed.
+   * Only meant for values which were already checked, such as those read back from the cache
+   * of a data file, and before the entry is added to the collection.
+   *
+   * @param values The field values, keyed by field name
+   */
+  void setFieldValues(const QHash<QString, QString>& values);
   /**
    * Returns a pointer to the parent collection of the entry.
    *
@@ -142,6 +172,12 @@ public:
    */
   bool removeFromGroup(EntryGroup* group);
   void clearGroups();
+  /**
+   * Clears the list of groups for certain fields, without removing the entry from the groups.
+   *
+   * @param fieldNames The names of the group fields
+   */
+  void clearGroups(const QStringList& fieldNames);
   /**
    * Returns a list of the groups to which the entry belongs
    *
@@ -150,7 +186,8 @@ public:
   const QList<EntryGroup*>& groups() const { return m_groups; }
   /**
    * Returns a list containing the names of the groups for
-   * a certain field to which the entry belongs
+   * a certain field to which the entry belongs. The people pseudo-group
+   * includes the names from every people field.
    *
    * @param fieldName The name of the field
    * @return The list of names
@@ -167,7 +204,7 @@ public:
    *
    * @return The list of field values
    */
-  QStringList formattedFieldValues() const { return m_formattedFields.values(); }
+  QStringList formattedFieldValues() const;
   /**
    * Returns a boolean indicating if the entry's parent collection recognizes
    * it existence, that is, the parent collection has this entry in its list.
@@ -190,11 +227,18 @@ private:
   bool operator==(const Entry& other) const;
 
   bool setFieldImpl(const QString& fieldName, const QString& value);
+  QStringList peopleGroupNames() const;
 
   CollPtr m_coll;
   ID m_id;
   QHash<QString, QString> m_fieldValues;
+  // the caches are filled in by const methods, which may run on several threads at once
+  mutable QMutex m_cacheMutex;
   mutable QHash<QString, QString> m_formattedFields;
+  // the unformatted values after the collection has prepared them, see Collection::prepareText()
+  mutable QHash<QString, QString> m_preparedFields;
+  // the split formatted values, also holds the names for the people pseudo-group
+  mutable QHash<QString, QStringList> m_formattedFieldLists;
   QList<EntryGroup*> m_groups;
 };
 
@@ -32,8 +32,39 @@
 
 using Tellico::EntryComparison;
 
+namespace {
+  // same as removing [^\\s\\w], without a static QRegExp, which can't be shared between threads
+  QString removePunctuation(const QString& text_) {
+    QString result;
+    result.reserve(text_.length());
+    for(int i = 0; i < text_.length(); ++i) {
+      const QChar c = text_.at(i);
+      if(c.isSpace() || c.isLetterOrNumber() || c.isMark() || c == QLatin1Char('_')) {
+        result += c;
+      }
+    }
+    return result;
+  }
+}
+
 QUrl EntryComparison::s_documentUrl;
 
+// normalize and unVersion arxiv ID
+QString EntryComparison::normalizeArxiv(const QString& value_) {
+  QString value = value_;
+  if(value.startsWith(QLatin1String("arxiv:"))) {
+    value.remove(0, 6);
+  }
+  int pos = value.length();
+  while(pos > 0 && value.at(pos-1).isDigit()) {
+    --pos;
+  }
+  if(pos < value.length() && pos > 0 && value.at(pos-1) == QLatin1Char('v')) {
+    value.truncate(pos-1);
+  }
+  return value;
+}
+
 void EntryComparison::setDocumentUrl(const QUrl& url_) {
   s_documentUrl = url_;
 }
@@ -97,14 +128,7 @@ int EntryComparison::score(const Tellico::Data::EntryPtr& e1, const Tellico::Dat
     return MATCH_VALUE_STRONG;
   }
   if(f->name() == QStringLiteral("arxiv")) {
-    // normalize and unVersion arxiv ID
-    static QRegExp rx1(QStringLiteral("^arxiv:"));
-    static QRegExp rx2(QStringLiteral("v\\d+$"));
-    s1.remove(rx1);
-    s1.remove(rx2);
-    s2.remove(rx1);
-    s2.remove(rx2);
-    return (s1 == s2) ? MATCH_VALUE_STRONG : MATCH_VALUE_NONE;
+    return normalizeArxiv(s1) == normalizeArxiv(s2) ? MATCH_VALUE_STRONG : MATCH_VALUE_NONE;
   }
   if(f->formatType() == FieldFormat::FormatTitle) {
 //    FieldFormat::stripArticles(s1);
@@ -125,20 +149,18 @@ int EntryComparison::score(const Tellico::Data::EntryPtr& e1, const Tellico::Dat
       matches += MATCH_VALUE_STRONG*sl2.count(*it);
     }
     if(matches == 0 && f->formatType() == FieldFormat::FormatName) {
-      sl1 = FieldFormat::splitValue(e1->formattedField(f, FieldFormat::ForceFormat));
-      sl2 = FieldFormat::splitValue(e2->formattedField(f, FieldFormat::ForceFormat));
+      // the split names are cached in the entry
+      sl1 = e1->formattedFieldList(f, FieldFormat::ForceFormat);
+      sl2 = e2->formattedFieldList(f, FieldFormat::ForceFormat);
       for(QStringList::ConstIterator it = sl1.constBegin(); it != sl1.constEnd(); ++it) {
         matches += MATCH_VALUE_STRONG*sl2.count(*it);
       }
     }
-    return matches / sl1.count();
+    return sl1.isEmpty() ? MATCH_VALUE_NONE : matches / sl1.count();
   }
   // last resort try removing punctuation
-  static QRegExp notAlphaNum(QStringLiteral("[^\\s\\w]"));
-  QString s1a = s1;
-  s1a.remove(notAlphaNum);
-  QString s2a = s2;
-  s2a.remove(notAlphaNum);
+  const QString s1a = removePunctuation(s1);
+  const QString s2a = removePunctuation(s2);
   if(!s1a.isEmpty() && s1a == s2a) {
 //    myDebug() << "match without punctuation";
     return MATCH_VALUE_STRONG;
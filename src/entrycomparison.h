@@ -42,6 +42,10 @@ public:
 
   static int score(const Data::EntryPtr& entry1, const Data::EntryPtr& entry2, Data::FieldPtr field);
   static int score(const Data::EntryPtr& entry1, const Data::EntryPtr& entry2, const QString& field, const Data::Collection* coll);
+  /**
+   * Returns an arXiv id without any "arxiv:" prefix or version suffix
+   */
+  static QString normalizeArxiv(const QString& value);
 
   // match scores for individual fields
   enum MatchValue {
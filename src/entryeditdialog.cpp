@@ -28,7 +28,6 @@
 #include "controller.h"
 #include "field.h"
 #include "entry.h"
-#include "fieldformat.h"
 #include "tellico_kernel.h"
 #include "utils/cursorsaver.h"
 #include "tellico_debug.h"
@@ -605,36 +604,6 @@ void EntryEditDialog::removeField(Tellico::Data::CollPtr, Tellico::Data::FieldPt
   }
 }
 
-void EntryEditDialog::updateCompletions(Tellico::Data::EntryPtr entry_) {
-#ifndef NDEBUG
-  if(m_currColl != entry_->collection()) {
-    myDebug() << "inconsistent collection pointers!";
-//    m_currColl = entry_->collection();
-  }
-#endif
-
-  foreach(Data::FieldPtr f, m_currColl->fields()) {
-    if(f->type() != Data::Field::Line
-       || !f->hasFlag(Data::Field::AllowCompletion)) {
-      continue;
-    }
-
-    QString key = QString::number(m_currColl->id()) + f->name();
-    GUI::FieldWidget* widget = m_widgetDict.value(key);
-    if(!widget) {
-      continue;
-    }
-    if(f->hasFlag(Data::Field::AllowMultiple)) {
-      QStringList items = FieldFormat::splitValue(entry_->field(f));
-      for(QStringList::ConstIterator it = items.constBegin(); it != items.constEnd(); ++it) {
-        widget->addCompletionObjectItem(*it);
-      }
-    } else {
-      widget->addCompletionObjectItem(entry_->field(f));
-    }
-  }
-}
-
 void EntryEditDialog::slotSetModified(bool mod_/*=true*/) {
   m_modified = mod_;
   m_saveButton->setEnabled(mod_);
@@ -725,16 +694,10 @@ void EntryEditDialog::modifyField(Tellico::Data::CollPtr coll_, Tellico::Data::F
   }
 }
 
-void EntryEditDialog::addEntries(Tellico::Data::EntryList entries_) {
-  foreach(Data::EntryPtr entry, entries_) {
-    updateCompletions(entry);
-  }
-}
-
 void EntryEditDialog::modifyEntries(Tellico::Data::EntryList entries_) {
   bool updateContents = false;
+  // the completion objects read the collection's value index, so only the contents need updating
   foreach(Data::EntryPtr entry, entries_) {
-    updateCompletions(entry);
     if(!updateContents && m_currEntries.contains(entry)) {
       updateContents = true;
     }
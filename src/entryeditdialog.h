@@ -68,7 +68,6 @@ public:
    */
   void clear();
 
-  virtual void    addEntries(Data::EntryList entries) Q_DECL_OVERRIDE;
   virtual void modifyEntries(Data::EntryList entries) Q_DECL_OVERRIDE;
 
   virtual void    addField(Data::CollPtr coll, Data::FieldPtr field) Q_DECL_OVERRIDE;
@@ -140,13 +139,6 @@ private:
    * @param highlight An optional string to highlight
    */
   void setEntry(Data::EntryPtr entry);
-  /**
-   * Updates the completion objects in the edit boxes to include values
-   * contained in a certain entry.
-   *
-   * @param entry A pointer to the entry
-   */
-  void updateCompletions(Data::EntryPtr entry);
   virtual void showEvent(QShowEvent* event) Q_DECL_OVERRIDE;
   virtual void hideEvent(QHideEvent* event) Q_DECL_OVERRIDE;
   virtual void closeEvent(QCloseEvent* event) Q_DECL_OVERRIDE;
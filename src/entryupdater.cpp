@@ -32,6 +32,7 @@
 #include "document.h"
 #include "fetch/fetchresult.h"
 #include "entrymatchdialog.h"
+#include "utils/tracer.h"
 #include "tellico_debug.h"
 
 #include <KLocalizedString>
@@ -116,10 +117,12 @@ void EntryUpdater::slotStartNext() {
 
   Fetch::Fetcher::Ptr f = m_fetchers[m_fetchIndex];
 //  myDebug() << "starting " << f->source();
+  Tracer::beginAsync("fetch", f->source().toUtf8(), f.data());
   f->startUpdate(m_entriesToUpdate.front());
 }
 
 void EntryUpdater::slotDone() {
+  Tracer::endAsync(m_fetchers[m_fetchIndex].data());
   if(m_cancelled) {
     QTimer::singleShot(500, this, &EntryUpdater::slotCleanup);
     return;
@@ -32,6 +32,8 @@
 #include "../document.h"
 #include "../utils/string_utils.h"
 #include "../utils/tellico_utils.h"
+#include "../utils/isbnvalidator.h"
+#include "../utils/tracer.h"
 #include "../tellico_debug.h"
 
 #ifdef HAVE_YAZ
@@ -48,6 +50,13 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QTemporaryFile>
+#include <QTimer>
+#include <QRegularExpression>
+
+namespace {
+  // seconds each source has to finish an all sources search before it gets stopped
+  static const int FETCH_SOURCE_TIMEOUT = 30;
+}
 
 #define LOAD_ICON(name, group, size) \
   KIconLoader::global()->loadIcon(name, static_cast<KIconLoader::Group>(group), size_)
@@ -55,11 +64,13 @@
 using Tellico::Fetch::Manager;
 Manager* Manager::s_self = nullptr;
 
-Manager::Manager() : QObject(), m_currentFetcherIndex(-1), m_messager(new ManagerMessage()),
-                     m_count(0), m_loadDefaults(false) {
+Manager::Manager() : QObject(), m_currentFetcherIndex(-1), m_searchTimer(new QTimer(this)),
+                     m_messager(new ManagerMessage()), m_count(0), m_loadDefaults(false) {
   // must create static pointer first
   Q_ASSERT(!s_self);
   s_self = this;
+  m_searchTimer->setSingleShot(true);
+  connect(m_searchTimer, &QTimer::timeout, this, &Manager::slotSearchTimeout);
   // no need to load fetchers since the initializer does it for us
 
 //  m_keyMap.insert(FetchFirst, QString());
@@ -154,6 +165,16 @@ Tellico::Fetch::KeyMap Manager::keyMap(const QString& source_) const {
   return map;
 }
 
+Tellico::Fetch::KeyMap Manager::allSourcesKeyMap() const {
+  KeyMap map;
+  for(KeyMap::ConstIterator it = m_keyMap.constBegin(); it != m_keyMap.constEnd(); ++it) {
+    if(!allSourcesFetchers(it.key()).isEmpty()) {
+      map.insert(it.key(), it.value());
+    }
+  }
+  return map;
+}
+
 void Manager::startSearch(const QString& source_, Tellico::Fetch::FetchKey key_, const QString& value_) {
   if(value_.isEmpty()) {
     emit signalDone();
@@ -162,9 +183,12 @@ void Manager::startSearch(const QString& source_, Tellico::Fetch::FetchKey key_,
 
   FetchRequest request(Data::Document::self()->collection()->type(), key_, value_);
 
+  m_currentFetcherIndex = -1;
+  m_searchFetchers.clear();
+  m_resultSources.clear();
+
   // assume there's only one fetcher match
   int i = 0;
-  m_currentFetcherIndex = -1;
   foreach(Fetcher::Ptr fetcher, m_fetchers) {
     if(source_ == fetcher->source()) {
       ++m_count; // Fetcher::search() might emit done(), so increment before calling search()
@@ -172,6 +196,7 @@ void Manager::startSearch(const QString& source_, Tellico::Fetch::FetchKey key_,
               this, &Manager::signalResultFound);
       connect(fetcher.data(), &Fetcher::signalDone,
               this, &Manager::slotFetcherDone);
+      Tracer::beginAsync("fetch", fetcher->source().toUtf8(), fetcher.data());
       fetcher->startSearch(request);
       m_currentFetcherIndex = i;
       break;
@@ -180,7 +205,54 @@ void Manager::startSearch(const QString& source_, Tellico::Fetch::FetchKey key_,
   }
 }
 
+void Manager::startAllSourcesSearch(Tellico::Fetch::FetchKey key_, const QString& value_) {
+  if(value_.isEmpty()) {
+    emit signalDone();
+    return;
+  }
+
+  FetchRequest request(Data::Document::self()->collection()->type(), key_, value_);
+
+  m_currentFetcherIndex = -1;
+  m_resultSources.clear();
+  m_searchFetchers = allSourcesFetchers(key_);
+  if(m_searchFetchers.isEmpty()) {
+    emit signalDone();
+    return;
+  }
+  // count them all first, since any fetcher might be done as soon as it starts
+  m_count += m_searchFetchers.count();
+  m_searchTimer->start(FETCH_SOURCE_TIMEOUT * 1000);
+  foreach(Fetcher::Ptr fetcher, m_searchFetchers) {
+    startFetcher(fetcher, request);
+  }
+}
+
 void Manager::continueSearch() {
+  if(!m_searchFetchers.isEmpty()) {
+    FetcherVec moreFetchers;
+    foreach(Fetcher::Ptr fetcher, m_searchFetchers) {
+      if(fetcher->hasMoreResults()) {
+        moreFetchers.append(fetcher);
+      }
+    }
+    if(moreFetchers.isEmpty()) {
+      emit signalDone();
+      return;
+    }
+    m_count += moreFetchers.count();
+    m_searchTimer->start(FETCH_SOURCE_TIMEOUT * 1000);
+    foreach(Fetcher::Ptr fetcher, moreFetchers) {
+      connect(fetcher.data(), &Fetcher::signalResultFound,
+              this, &Manager::slotResultFound);
+      connect(fetcher.data(), &Fetcher::signalDone,
+              this, &Manager::slotFetcherDone);
+      Tracer::beginAsync("fetch", fetcher->source().toUtf8(), fetcher.data());
+      fetcher->continueSearch();
+    }
+    return;
+  }
+
   if(m_currentFetcherIndex < 0 || m_currentFetcherIndex >= static_cast<int>(m_fetchers.count())) {
     myDebug() << "can't continue!";
     emit signalDone();
@@ -193,6 +265,7 @@ void Manager::continueSearch() {
             this, &Manager::signalResultFound);
     connect(fetcher.data(), &Fetcher::signalDone,
             this, &Manager::slotFetcherDone);
+    Tracer::beginAsync("fetch", fetcher->source().toUtf8(), fetcher.data());
     fetcher->continueSearch();
   } else {
     emit signalDone();
@@ -200,6 +273,14 @@ void Manager::continueSearch() {
 }
 
 bool Manager::hasMoreResults() const {
+  if(!m_searchFetchers.isEmpty()) {
+    foreach(Fetcher::Ptr fetcher, m_searchFetchers) {
+      if(fetcher->hasMoreResults()) {
+        return true;
+      }
+    }
+    return false;
+  }
   if(m_currentFetcherIndex < 0 || m_currentFetcherIndex >= static_cast<int>(m_fetchers.count())) {
     return false;
   }
@@ -209,6 +290,7 @@ bool Manager::hasMoreResults() const {
 
 void Manager::stop() {
 //  DEBUG_LINE;
+  m_searchTimer->stop();
   foreach(Fetcher::Ptr fetcher, m_fetchers) {
     if(fetcher->isSearching()) {
       fetcher->stop();
@@ -225,14 +307,88 @@ void Manager::stop() {
 
 void Manager::slotFetcherDone(Tellico::Fetch::Fetcher* fetcher_) {
 //  myDebug() << (fetcher_ ? fetcher_->source() : QString()) << ":" << m_count;
+  Tracer::endAsync(fetcher_);
   fetcher_->disconnect(); // disconnect all signals
   fetcher_->saveConfig();
   --m_count;
   if(m_count <= 0) {
+    m_searchTimer->stop();
     emit signalDone();
   }
 }
 
+void Manager::slotResultFound(Tellico::Fetch::FetchResult* result_) {
+  // the same item is often found by several sources, only the first source's results are kept
+  // a single source may well have several results which look the same, like different editions
+  const QString key = resultKey(result_);
+  if(!key.isEmpty()) {
+    const Fetcher* source = result_->fetcher.data();
+    QHash<QString, const Fetcher*>::ConstIterator it = m_resultSources.constFind(key);
+    if(it == m_resultSources.constEnd()) {
+      m_resultSources.insert(key, source);
+    } else if(it.value() != source) {
+      delete result_;
+      return;
+    }
+  }
+  emit signalResultFound(result_);
+}
+
+void Manager::slotSearchTimeout() {
+  // stopping the slow sources lets the search finish with whatever has been found
+  foreach(Fetcher::Ptr fetcher, m_searchFetchers) {
+    if(fetcher->isSearching()) {
+      myLog() << fetcher->source() << "did not finish in time";
+      fetcher->stop();
+    }
+  }
+}
+
+Tellico::Fetch::FetcherVec Manager::allSourcesFetchers(FetchKey key_) const {
+  const int collType = Data::Document::self()->collection()->type();
+  FetcherVec vec;
+  foreach(Fetcher::Ptr fetcher, m_fetchers) {
+    // a multiple source fetcher would just search the same sources again
+    if(fetcher->type() != Multiple && fetcher->canFetch(collType) && fetcher->canSearch(key_)) {
+      vec.append(fetcher);
+    }
+  }
+  return vec;
+}
+
+void Manager::startFetcher(Fetcher::Ptr fetcher_, const FetchRequest& request_) {
+  connect(fetcher_.data(), &Fetcher::signalResultFound,
+          this, &Manager::slotResultFound);
+  connect(fetcher_.data(), &Fetcher::signalDone,
+          this, &Manager::slotFetcherDone);
+  Tracer::beginAsync("fetch", fetcher_->source().toUtf8(), fetcher_.data());
+  fetcher_->startSearch(request_);
+}
+
+// the ISBN is the surest match, otherwise the title along with the first part of the
+// description, usually the author or the studio
+QString Manager::resultKey(const FetchResult* result_) {
+  static const QRegularExpression nonWordChars(QStringLiteral("[^\\w]"));
+  if(!result_->isbn.isEmpty()) {
+    const QString isbn = ISBNValidator::cleanValue(result_->isbn.section(QLatin1Char(';'), 0, 0));
+    if(!isbn.isEmpty()) {
+      return QLatin1String("isbn:") + ISBNValidator::isbn13(isbn).remove(QLatin1Char('-'));
+    }
+  }
+  QString title = removeAccents(result_->title).toLower();
+  title.remove(nonWordChars);
+  if(title.isEmpty()) {
+    return QString();
+  }
+  QString desc = removeAccents(result_->desc.section(QLatin1Char('/'), 0, 0)).toLower();
+  desc.remove(nonWordChars);
+  return QLatin1String("title:") + title + QLatin1Char('|') + desc;
+}
+
+QString Manager::allSourcesName() {
+  return i18n("All Sources");
+}
+
 bool Manager::canFetch() const {
   foreach(Fetcher::Ptr fetcher, m_fetchers) {
     if(fetcher->canFetch(Data::Document::self()->collection()->type())) {
@@ -34,6 +34,9 @@
 #include <QMap>
 #include <QList>
 #include <QPixmap>
+#include <QHash>
+
+class QTimer;
 
 class QUrl;
 
@@ -80,7 +83,16 @@ public:
   ~Manager();
 
   KeyMap keyMap(const QString& source = QString()) const;
+  /**
+   * Returns the keys which at least one source can search, for startAllSourcesSearch().
+   */
+  KeyMap allSourcesKeyMap() const;
   void startSearch(const QString& source, FetchKey key, const QString& value);
+  /**
+   * Starts a search of every source able to do it. All the sources search together and results
+   * are reported as they arrive, skipping any which were already found by another source.
+   */
+  void startAllSourcesSearch(FetchKey key, const QString& value);
   void continueSearch();
   bool canFetch() const;
   bool hasMoreResults() const;
@@ -102,6 +114,11 @@ public:
    */
   void registerFunction(int type, const FetcherFunction& func);
 
+  /**
+   * Returns the label for searching all sources. It's only for display, since a source
+   * could have the same name.
+   */
+  static QString allSourcesName();
   static QString typeName(Type type);
   static QPixmap fetcherIcon(Type type, int iconGroup=3 /*Small*/, int size=0 /* default */);
   static QPixmap fetcherIcon(Fetcher::Ptr ptr, int iconGroup=3 /*Small*/, int size=0 /* default*/);
@@ -117,6 +134,8 @@ public Q_SLOTS:
 
 private Q_SLOTS:
   void slotFetcherDone(Tellico::Fetch::Fetcher* fetcher);
+  void slotResultFound(Tellico::Fetch::FetchResult* result);
+  void slotSearchTimeout();
 
 private:
   friend class ManagerMessage;
@@ -126,8 +145,12 @@ private:
   Manager();
   Fetcher::Ptr createFetcher(KSharedConfigPtr config, const QString& configGroup);
   FetcherVec defaultFetchers();
+  FetcherVec allSourcesFetchers(FetchKey key) const;
+  void startFetcher(Fetcher::Ptr fetcher, const FetchRequest& request);
   void updateStatus(const QString& message);
 
+  static QString resultKey(const FetchResult* result);
+
   static bool bundledScriptHasExecPath(const QString& specFile, KConfigGroup& config);
 
   typedef QHash<int, FetcherFunction> FunctionRegistry;
@@ -135,6 +158,11 @@ private:
 
   FetcherVec m_fetchers;
   int m_currentFetcherIndex;
+  // the fetchers of an all sources search
+  FetcherVec m_searchFetchers;
+  // the source which first found each result key
+  QHash<QString, const Fetcher*> m_resultSources;
+  QTimer* m_searchTimer;
   KeyMap m_keyMap;
   QHash<QString, Fetcher::Ptr> m_uuidHash;
 
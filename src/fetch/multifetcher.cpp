@@ -26,6 +26,9 @@
 #include "fetchmanager.h"
 #include "../entrycomparison.h"
 #include "../document.h"
+#include "../fieldformat.h"
+#include "../utils/isbnvalidator.h"
+#include "../utils/string_utils.h"
 #include "../gui/collectiontypecombo.h"
 #include "../tellico_debug.h"
 
@@ -35,6 +38,37 @@
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QRegularExpression>
+#include <QSet>
+
+namespace {
+  static const char* MULTIFETCHER_ID_FIELDS[] = {"isbn", "lccn", "upc", "doi", "arxiv", "pmid", "imdb"};
+
+  // entries are only compared if they share one of these keys, either an identifier
+  // or the words of the title, in any order and case
+  QStringList blockingKeys(Tellico::Data::EntryPtr entry_) {
+    QStringList keys;
+    for(uint i = 0; i < sizeof(MULTIFETCHER_ID_FIELDS)/sizeof(MULTIFETCHER_ID_FIELDS[0]); ++i) {
+      const QString fieldName = QLatin1String(MULTIFETCHER_ID_FIELDS[i]);
+      foreach(QString value, Tellico::FieldFormat::splitValue(entry_->field(fieldName))) {
+        if(fieldName == QLatin1String("isbn")) {
+          value = Tellico::ISBNValidator::isbn13(Tellico::ISBNValidator::cleanValue(value)).remove(QLatin1Char('-'));
+        }
+        value = value.trimmed().toLower();
+        if(!value.isEmpty()) {
+          keys << fieldName + QLatin1Char(':') + value;
+        }
+      }
+    }
+    static const QRegularExpression nonWordChars(QStringLiteral("[^\\w]+"));
+    QStringList words = Tellico::removeAccents(entry_->title()).toLower().split(nonWordChars, QString::SkipEmptyParts);
+    if(!words.isEmpty()) {
+      words.sort();
+      keys << QLatin1String("title:") + words.join(QLatin1Char(' '));
+    }
+    return keys;
+  }
+}
 
 using namespace Tellico;
 using Tellico::Fetch::MultiFetcher;
@@ -82,6 +116,8 @@ void MultiFetcher::readSources() const {
 
 void MultiFetcher::search() {
   m_started = true;
+  m_entries.clear();
+  m_entryIndex.clear();
   readSources();
   foreach(Fetcher::Ptr fetcher, m_fetchers) {
     fetcher->startSearch(request());
@@ -109,19 +145,51 @@ void MultiFetcher::stop() {
 
 void MultiFetcher::slotResult(Tellico::Fetch::FetchResult* result) {
   Data::EntryPtr newEntry = result->fetchEntry();
+  if(!newEntry) {
+    return;
+  }
   // first check if we've already received this entry result from another fetcher
+  // only the entries sharing a key are compared, rather than every one found so far
+  const QStringList keys = blockingKeys(newEntry);
+  QList<int> candidates;
+  if(keys.isEmpty()) {
+    for(int i = 0; i < m_entries.count(); ++i) {
+      candidates << i;
+    }
+  } else {
+    foreach(const QString& key, keys) {
+      candidates += m_entryIndex.values(key);
+    }
+  }
+
   bool alreadyFound = false;
-  foreach(Data::EntryPtr entry, m_entries) {
+  QSet<int> compared;
+  foreach(int i, candidates) {
+    if(compared.contains(i)) {
+      continue;
+    }
+    compared.insert(i);
+    Data::EntryPtr entry = m_entries.at(i);
     if(entry->collection()->sameEntry(entry, newEntry) > EntryComparison::ENTRY_GOOD_MATCH) {
       // same entry, so instead of adding a new result, just merge it
       Data::Document::mergeEntry(entry, newEntry);
+      // the merge might have added an identifier
+      foreach(const QString& key, blockingKeys(entry)) {
+        if(!m_entryIndex.contains(key, i)) {
+          m_entryIndex.insert(key, i);
+        }
+      }
       alreadyFound = true;
       break;
     }
   }
 
   if(!alreadyFound) {
+    const int i = m_entries.count();
     m_entries.append(newEntry);
+    foreach(const QString& key, keys) {
+      m_entryIndex.insert(key, i);
+    }
   }
 }
 
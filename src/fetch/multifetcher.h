@@ -31,6 +31,7 @@
 #include "../gui/kwidgetlister.h"
 
 #include <QFrame>
+#include <QHash>
 
 namespace Tellico {
 
@@ -93,6 +94,8 @@ private:
   void readSources() const;
 
   Data::EntryList m_entries;
+  // maps the blocking keys of each entry to its position in the list
+  QMultiHash<QString, int> m_entryIndex;
   QHash<uint, Data::EntryPtr> m_entryHash;
   int m_collType;
   QStringList m_uuids;
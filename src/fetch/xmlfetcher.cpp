@@ -26,7 +26,6 @@
 #include "../translators/xslthandler.h"
 #include "../translators/tellicoimporter.h"
 #include "../utils/guiproxy.h"
-#include "../utils/xmlhandler.h"
 #include "../utils/string_utils.h"
 #include "../utils/datafileregistry.h"
 #include "../tellico_debug.h"
@@ -128,18 +127,18 @@ void XMLFetcher::slotComplete(KJob* ) {
 
   parseData(data);
 
-  const QString str = m_xsltHandler->applyStylesheet(XMLHandler::readXMLData(data));
+  // the transformed document is read directly, rather than being serialized and parsed again
+  xmlDocPtr doc = m_xsltHandler->transform(data);
+  if(!doc) {
+    myDebug() << "no transformed document";
+    stop();
+    return;
+  }
 #if 0
   myWarning() << "Remove debug from xmlfetcher.cpp";
-  QFile f2(QStringLiteral("/tmp/test-tellico.xml"));
-  if(f2.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f2);
-    t.setCodec("utf-8");
-    t << str;
-  }
-  f2.close();
+  xmlSaveFormatFileEnc("/tmp/test-tellico.xml", doc, "UTF-8", 1);
 #endif
-  Import::TellicoImporter imp(str);
+  Import::TellicoImporter imp(doc);
   // be quiet when loading images
   imp.setOptions(imp.options() ^ Import::ImportShowImageErrors);
   Data::CollPtr coll = imp.collection();
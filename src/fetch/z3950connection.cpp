@@ -27,6 +27,7 @@
 #include "z3950connection.h"
 #include "z3950fetcher.h"
 #include "messagehandler.h"
+#include "../translators/xslthandler.h"
 #include "../utils/iso5426converter.h"
 #include "../utils/iso6937converter.h"
 #include "../tellico_debug.h"
@@ -36,6 +37,11 @@
 
 #include <QFile>
 #include <QApplication>
+#include <QMutex>
+#include <QStringList>
+#include <QDateTime>
+#include <QBasicTimer>
+#include <QTimerEvent>
 
 #ifdef HAVE_YAZ
 extern "C" {
@@ -48,6 +54,14 @@ extern "C" {
 namespace {
   static const size_t Z3950_DEFAULT_MAX_RECORDS = 20;
 
+  // records are concatenated into a collection document, so any XML declaration has to go
+  void stripXmlDeclaration(QByteArray& xml_) {
+    if(xml_.startsWith("<?xml")) {
+      const int pos = xml_.indexOf("?>");
+      xml_.remove(0, pos == -1 ? xml_.size() : pos + 2);
+    }
+  }
+
 #ifdef HAVE_YAZ
   class QueryDestroyer {
   public:
@@ -65,6 +79,129 @@ namespace {
     ZOOM_resultset result;
   };
 
+  /**
+   * Open connections are kept between searches, so repeated searches of the same server,
+   * as when updating many entries, skip the connection and Z39.50 init handshake. A connection
+   * is only used by one search at a time, and is closed once it has been idle too long.
+   *
+   * The pool lives in the main thread, where a timer closes the idle connections
+   * even when no other search comes along.
+   */
+  class ConnectionPool : public QObject {
+  public:
+    ConnectionPool() : QObject() {
+      if(QCoreApplication::instance()) {
+        moveToThread(QCoreApplication::instance()->thread());
+      }
+    }
+
+    ~ConnectionPool() {
+      m_timer.stop();
+      foreach(const PooledConnection& pc, m_connections) {
+        ZOOM_connection_destroy(pc.conn);
+      }
+    }
+
+    ZOOM_connection take(const QString& key_) {
+      QMutexLocker lock(&m_mutex);
+      expire();
+      for(int i = m_connections.size()-1; i >= 0; --i) {
+        if(m_connections.at(i).key == key_) {
+          return m_connections.takeAt(i).conn;
+        }
+      }
+      return nullptr;
+    }
+
+    void put(const QString& key_, ZOOM_connection conn_, int idleTimeout_) {
+      QMutexLocker lock(&m_mutex);
+      expire();
+      PooledConnection pc;
+      pc.key = key_;
+      pc.conn = conn_;
+      pc.expires = QDateTime::currentMSecsSinceEpoch() + 1000 * static_cast<qint64>(idleTimeout_);
+      m_connections.append(pc);
+      // connections are put back from the search thread, the timer can only be started in the pool's thread
+      QCoreApplication::postEvent(this, new QEvent(QEvent::User));
+    }
+
+    int count(const QString& key_) {
+      QMutexLocker lock(&m_mutex);
+      expire();
+      int n = 0;
+      foreach(const PooledConnection& pc, m_connections) {
+        if(pc.key == key_) {
+          ++n;
+        }
+      }
+      return n;
+    }
+
+  protected:
+    virtual void customEvent(QEvent* event_) Q_DECL_OVERRIDE {
+      if(event_->type() == QEvent::User) {
+        QMutexLocker lock(&m_mutex);
+        scheduleExpiry();
+      }
+    }
+
+    virtual void timerEvent(QTimerEvent* event_) Q_DECL_OVERRIDE {
+      if(event_->timerId() == m_timer.timerId()) {
+        QMutexLocker lock(&m_mutex);
+        expire();
+        scheduleExpiry();
+      }
+    }
+
+  private:
+    struct PooledConnection {
+      QString key;
+      ZOOM_connection conn;
+      qint64 expires;
+    };
+
+    // the mutex must be locked
+    void expire() {
+      const qint64 now = QDateTime::currentMSecsSinceEpoch();
+      for(int i = m_connections.size()-1; i >= 0; --i) {
+        if(m_connections.at(i).expires <= now) {
+          ZOOM_connection_destroy(m_connections.takeAt(i).conn);
+        }
+      }
+    }
+
+    // the mutex must be locked, and this must be called in the pool's thread
+    void scheduleExpiry() {
+      if(m_connections.isEmpty()) {
+        m_timer.stop();
+        return;
+      }
+      qint64 next = m_connections.first().expires;
+      foreach(const PooledConnection& pc, m_connections) {
+        next = qMin(next, pc.expires);
+      }
+      const qint64 wait = qMax(Q_INT64_C(0), next - QDateTime::currentMSecsSinceEpoch());
+      // the timer restarts if it's already running
+      m_timer.start(static_cast<int>(qMin(wait, Q_INT64_C(0x7fffffff))), this);
+    }
+
+    QMutex m_mutex;
+    QList<PooledConnection> m_connections;
+    QBasicTimer m_timer;
+  };
+
+  Q_GLOBAL_STATIC(ConnectionPool, connectionPool)
+
+  // errors which leave the connection itself unusable, rather than just failing the search
+  bool isConnectionError(int errcode_) {
+    return errcode_ == ZOOM_ERROR_CONNECT ||
+           errcode_ == ZOOM_ERROR_CONNECTION_LOST ||
+           errcode_ == ZOOM_ERROR_INIT ||
+           errcode_ == ZOOM_ERROR_ENCODE ||
+           errcode_ == ZOOM_ERROR_DECODE ||
+           errcode_ == ZOOM_ERROR_TIMEOUT;
+  }
+
   class YazCloser {
   public:
     YazCloser(yaz_iconv_t iconv_) : iconv(iconv_), marc(nullptr) {}
@@ -81,6 +218,7 @@ namespace {
 }
 
 using Tellico::Fetch::Z3950ResultFound;
+using Tellico::Fetch::Z3950ResultsFound;
 using Tellico::Fetch::Z3950Connection;
 
 Z3950ResultFound::Z3950ResultFound(const QString& s) : QEvent(uid())
@@ -92,16 +230,32 @@ Z3950ResultFound::~Z3950ResultFound() {
   --Z3950Connection::resultsLeft;
 }
 
+Z3950ResultsFound::Z3950ResultsFound(xmlDocPtr doc_) : QEvent(uid())
+    , m_doc(doc_) {
+  ++Z3950Connection::resultsLeft;
+}
+
+Z3950ResultsFound::~Z3950ResultsFound() {
+  if(m_doc) {
+    xmlFreeDoc(m_doc);
+  }
+  --Z3950Connection::resultsLeft;
+}
+
+xmlDocPtr Z3950ResultsFound::takeDocument() {
+  xmlDocPtr doc = m_doc;
+  m_doc = nullptr;
+  return doc;
+}
+
 class Z3950Connection::Private {
 public:
 #ifdef HAVE_YAZ
-  Private() : conn_opt(nullptr), conn(nullptr) {}
+  Private() : conn(nullptr) {}
   ~Private() {
-    ZOOM_options_destroy(conn_opt);
     ZOOM_connection_destroy(conn);
   };
 
-  ZOOM_options conn_opt;
   ZOOM_connection conn;
 #else
   Private() {}
@@ -124,6 +278,7 @@ Z3950Connection::Z3950Connection(Tellico::Fetch::Z3950Fetcher* fetcher,
     , d(new Private())
     , m_connected(false)
     , m_aborted(false)
+    , m_idleTimeout(0)
     , m_fetcher(fetcher)
     , m_host(host)
     , m_port(port)
@@ -156,7 +311,36 @@ void Z3950Connection::setUserPassword(const QString& user_, const QString& pword
   m_password = pword_;
 }
 
+void Z3950Connection::setIdleTimeout(int seconds_) {
+  m_idleTimeout = seconds_;
+}
+
+int Z3950Connection::pooledConnectionCount(const QString& host_, uint port_, const QString& dbname_,
+                                           const QString& user_, const QString& pword_) {
+#ifdef HAVE_YAZ
+  return connectionPool()->count(poolKey(host_, port_, dbname_, user_, pword_));
+#else
+  Q_UNUSED(host_);
+  Q_UNUSED(port_);
+  Q_UNUSED(dbname_);
+  Q_UNUSED(user_);
+  Q_UNUSED(pword_);
+  return 0;
+#endif
+}
+
+QString Z3950Connection::poolKey(const QString& host_, uint port_, const QString& dbname_,
+                                 const QString& user_, const QString& pword_) {
+  return (QStringList() << host_ << QString::number(port_) << dbname_ << user_ << pword_).join(QLatin1Char('\n'));
+}
+
 void Z3950Connection::run() {
+  search();
+  // the result set has been destroyed, so the connection can go back to the pool
+  releaseConnection();
+}
+
+void Z3950Connection::search() {
 //  myDebug() << m_fetcher->source();
   m_aborted = false;
   m_hasMore = false;
@@ -213,8 +397,6 @@ void Z3950Connection::run() {
   const char* addinfo;
   errcode = ZOOM_connection_error(d->conn, &errmsg, &addinfo);
   if(errcode != 0) {
-    m_connected = false;
-
     QString s = i18n("Connection search error %1: %2", errcode, toString(errmsg));
     if(!QByteArray(addinfo).isEmpty()) {
       s += QLatin1String(" (") + toString(addinfo) + QLatin1Char(')');
@@ -323,6 +505,10 @@ void Z3950Connection::run() {
 
   const size_t realLimit = qMin(numResults, m_limit);
 
+  // MODS and MARC records are gathered for the whole page and transformed in a single pass
+  const bool batchRecords = m_syntax != QLatin1String("grs-1") && m_syntax != QLatin1String("ads");
+  QList<QByteArray> records;
+
   bool showError = true;
   for(size_t i = m_start; i < realLimit && !m_aborted; ++i) {
 //    myLog() << "grabbing index" << i;
@@ -347,7 +533,10 @@ void Z3950Connection::run() {
     int len;
     QString data;
     if(m_syntax == QLatin1String("mods")) {
-      data = toString(ZOOM_record_get(rec, "xml", &len));
+      QByteArray record = toString(ZOOM_record_get(rec, "xml", &len)).toUtf8();
+      stripXmlDeclaration(record);
+      records += record;
+      continue;
     } else if(m_syntax == QLatin1String("grs-1")) {
       // grs-1 means we have to try to parse the rendered data, very ugly...
       data = toString(ZOOM_record_get(rec, "render", &len));
@@ -368,12 +557,17 @@ void Z3950Connection::run() {
         f1.close();
       }
 #endif
-      data = toXML(ZOOM_record_get(rec, "raw", &len), m_sourceCharSet);
+      records += toXML(ZOOM_record_get(rec, "raw", &len), m_sourceCharSet);
+      continue;
     }
     Z3950ResultFound* ev = new Z3950ResultFound(data);
     QApplication::postEvent(m_fetcher.data(), ev);
   }
 
+  if(batchRecords && !records.isEmpty() && !m_aborted) {
+    postResults(records);
+  }
+
   m_hasMore = m_limit < numResults;
   if(m_hasMore) {
     m_start = m_limit;
@@ -390,16 +584,24 @@ bool Z3950Connection::makeConnection() {
 //  myDebug() << m_fetcher->source();
 // I don't know what to do except assume database, user, and password are in locale encoding
 #ifdef HAVE_YAZ
-  d->conn_opt = ZOOM_options_create();
-  ZOOM_options_set(d->conn_opt, "implementationName", "Tellico");
+  d->conn = connectionPool()->take(poolKey(m_host, m_port, m_dbname, m_user, m_password));
+  if(d->conn) {
+    m_connected = true;
+    return true;
+  }
+
+  ZOOM_options opt = ZOOM_options_create();
+  ZOOM_options_set(opt, "implementationName", "Tellico");
   QByteArray ba = toByteArray(m_dbname);
-  ZOOM_options_set(d->conn_opt, "databaseName",       ba.constData());
+  ZOOM_options_set(opt, "databaseName",       ba.constData());
   ba = toByteArray(m_user);
-  ZOOM_options_set(d->conn_opt, "user",               ba.constData());
+  ZOOM_options_set(opt, "user",               ba.constData());
   ba = toByteArray(m_password);
-  ZOOM_options_set(d->conn_opt, "password",           ba.constData());
+  ZOOM_options_set(opt, "password",           ba.constData());
 
-  d->conn = ZOOM_connection_create(d->conn_opt);
+  d->conn = ZOOM_connection_create(opt);
+  // the connection holds its own reference to the options
+  ZOOM_options_destroy(opt);
   ZOOM_connection_connect(d->conn, m_host.toLatin1().constData(), m_port);
 
   int errcode;
@@ -407,8 +609,8 @@ bool Z3950Connection::makeConnection() {
   const char* addinfo;
   errcode = ZOOM_connection_error(d->conn, &errmsg, &addinfo);
   if(errcode != 0) {
-    ZOOM_options_destroy(d->conn_opt);
     ZOOM_connection_destroy(d->conn);
+    d->conn = nullptr;
     m_connected = false;
 
     QString s = i18n("Connection error %1: %2", errcode, toString(errmsg));
@@ -426,6 +628,24 @@ bool Z3950Connection::makeConnection() {
   return true;
 }
 
+void Z3950Connection::releaseConnection() {
+#ifdef HAVE_YAZ
+  if(!d->conn) {
+    return;
+  }
+  const char* errmsg;
+  const char* addinfo;
+  const int errcode = ZOOM_connection_error(d->conn, &errmsg, &addinfo);
+  if(m_idleTimeout > 0 && !isConnectionError(errcode)) {
+    connectionPool()->put(poolKey(m_host, m_port, m_dbname, m_user, m_password), d->conn, m_idleTimeout);
+  } else {
+    ZOOM_connection_destroy(d->conn);
+  }
+  d->conn = nullptr;
+#endif
+  m_connected = false;
+}
+
 void Z3950Connection::done() {
   checkPendingEvents();
   qApp->postEvent(m_fetcher.data(), new Z3950ConnectionDone(m_hasMore));
@@ -440,6 +660,71 @@ void Z3950Connection::done(const QString& msg_, int type_) {
   }
 }
 
+// the fetcher loads the stylesheets before starting the connection, and leaves them alone while it runs
+void Z3950Connection::postResults(const QList<QByteArray>& records_) {
+  QByteArray page;
+  foreach(const QByteArray& record, records_) {
+    page += record;
+  }
+  xmlDocPtr tellicoDoc = transformRecords(page);
+  if(tellicoDoc) {
+    QApplication::postEvent(m_fetcher.data(), new Z3950ResultsFound(tellicoDoc));
+    return;
+  }
+  if(records_.count() < 2) {
+    myDebug() << "unable to transform the records, maybe the character encoding or record format is wrong?";
+    return;
+  }
+
+  // a single bad record spoils the whole page, so fall back to transforming each record on its own
+  myDebug() << "unable to transform the page, transforming" << records_.count() << "records one at a time";
+  foreach(const QByteArray& record, records_) {
+    if(m_aborted) {
+      break;
+    }
+    tellicoDoc = transformRecords(record);
+    if(tellicoDoc) {
+      QApplication::postEvent(m_fetcher.data(), new Z3950ResultsFound(tellicoDoc));
+    } else {
+      myDebug() << "unable to transform a record, maybe the character encoding or record format is wrong?";
+    }
+  }
+}
+
+xmlDocPtr Z3950Connection::transformRecords(const QByteArray& records_) {
+  XSLTHandler* modsHandler = m_fetcher->m_MODSHandler;
+  if(!modsHandler) {
+    myDebug() << "no MODS handler";
+    return nullptr;
+  }
+
+  xmlDocPtr tellicoDoc = nullptr;
+  if(m_syntax == QLatin1String("mods")) {
+    QByteArray modsCollection("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                              "<modsCollection xmlns=\"http://www.loc.gov/mods/v3\">\n");
+    modsCollection += records_;
+    modsCollection += "</modsCollection>\n";
+    tellicoDoc = modsHandler->transform(modsCollection);
+  } else {
+    XSLTHandler* marcHandler = m_syntax == QLatin1String("unimarc") ? m_fetcher->m_UNIMARCXMLHandler
+                                                                    : m_fetcher->m_MARC21XMLHandler;
+    if(!marcHandler) {
+      myDebug() << "no MARC handler for" << m_syntax;
+      return nullptr;
+    }
+    QByteArray marcCollection("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                              "<collection xmlns=\"http://www.loc.gov/MARC21/slim\">\n");
+    marcCollection += records_;
+    marcCollection += "</collection>\n";
+    xmlDocPtr modsDoc = marcHandler->transform(marcCollection);
+    if(modsDoc) {
+      tellicoDoc = modsHandler->transform(modsDoc);
+      xmlFreeDoc(modsDoc);
+    }
+  }
+  return tellicoDoc;
+}
+
 void Z3950Connection::checkPendingEvents() {
   // if there's still some pending result events, go ahead and just wait 1 second
   if(resultsLeft > 0) {
@@ -514,11 +799,11 @@ QByteArray Z3950Connection::iconvRun(const QByteArray& text_, const QString& fro
   return text_;
 }
 
-QString Z3950Connection::toXML(const QByteArray& marc_, const QString& charSet_) {
+QByteArray Z3950Connection::toXML(const QByteArray& marc_, const QString& charSet_) {
 #ifdef HAVE_YAZ
   if(marc_.isEmpty()) {
     myDebug() << "empty string";
-    return QString();
+    return QByteArray();
   }
 
   yaz_iconv_t cd = yaz_iconv_open("utf-8", charSet_.toLatin1().constData());
@@ -532,7 +817,7 @@ QString Z3950Connection::toXML(const QByteArray& marc_, const QString& charSet_)
       return toXML(Iso6937Converter::toUtf8(marc_).toUtf8(), QStringLiteral("utf-8"));
     }
     myWarning() << "conversion from" << charSet_ << "is unsupported";
-    return QString();
+    return QByteArray();
   }
 
   yaz_marc_t mt = yaz_marc_create();
@@ -550,7 +835,7 @@ QString Z3950Connection::toXML(const QByteArray& marc_, const QString& charSet_)
 #endif
   if(ok && (len < 25 || len > 100000)) {
     myDebug() << "bad length:" << (ok ? len : -1);
-    return QString();
+    return QByteArray();
   }
 
 #if YAZ_VERSIONL < 0x030000
@@ -561,12 +846,11 @@ QString Z3950Connection::toXML(const QByteArray& marc_, const QString& charSet_)
   int r = yaz_marc_decode_buf(mt, marc_.constData(), -1, &result, &len);
   if(r <= 0) {
     myDebug() << "can't decode buffer";
-    return QString();
+    return QByteArray();
   }
 
-  QString output = QStringLiteral("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-  output += QString::fromUtf8(result, len+1);
-//  myDebug() << QCString(result);
+  // no XML declaration, the record gets added to a collection document
+  QByteArray output(result, len);
 //  myDebug() << "-------------------------------------------";
 //  myDebug() << output;
 
@@ -574,6 +858,6 @@ QString Z3950Connection::toXML(const QByteArray& marc_, const QString& charSet_)
 #else // no yaz
   Q_UNUSED(marc_);
   Q_UNUSED(charSet_);
-  return QString();
+  return QByteArray();
 #endif
 }
@@ -29,6 +29,9 @@
 #include <QEvent>
 #include <QExplicitlySharedDataPointer>
 
+// for xmlDocPtr
+#include <libxml/tree.h>
+
 namespace Tellico {
   namespace Fetch {
     class Z3950Fetcher;
@@ -46,6 +49,23 @@ private:
   QString m_result;
 };
 
+/**
+ * Carries a whole page of MARC or MODS records, already transformed into a Tellico document.
+ * The receiver takes the document, otherwise it is freed with the event.
+ */
+class Z3950ResultsFound : public QEvent {
+public:
+  Z3950ResultsFound(xmlDocPtr doc);
+  ~Z3950ResultsFound();
+  xmlDocPtr takeDocument();
+
+  static QEvent::Type uid() { return static_cast<QEvent::Type>(QEvent::User + 11112); }
+
+private:
+  Q_DISABLE_COPY(Z3950ResultsFound)
+  xmlDocPtr m_doc;
+};
+
 class Z3950ConnectionDone : public QEvent {
 public:
   Z3950ConnectionDone(bool more) : QEvent(uid()), m_type(-1), m_hasMore(more) {}
@@ -93,26 +113,45 @@ public:
   void reset();
   void setQuery(const QString& query);
   void setUserPassword(const QString& user, const QString& pword);
+  /**
+   * Sets how long the connection is kept open for later searches after this one is done.
+   * A connection is not kept at all when the timeout is zero.
+   */
+  void setIdleTimeout(int seconds);
   void run() Q_DECL_OVERRIDE;
 
   void abort() { m_aborted = true; }
 
+  /**
+   * Returns the number of idle connections kept open for a server.
+   */
+  static int pooledConnectionCount(const QString& host, uint port, const QString& dbname,
+                                   const QString& user = QString(), const QString& pword = QString());
+
 private:
   static QByteArray iconvRun(const QByteArray& text, const QString& fromCharSet, const QString& toCharSet);
-  static QString toXML(const QByteArray& marc, const QString& fromCharSet);
+  static QByteArray toXML(const QByteArray& marc, const QString& fromCharSet);
+
+  static QString poolKey(const QString& host, uint port, const QString& dbname,
+                         const QString& user, const QString& pword);
 
+  void search();
   bool makeConnection();
+  void releaseConnection();
   void done();
   void done(const QString& message, int type);
   QByteArray toByteArray(const QString& text);
   QString toString(const QByteArray& text);
   void checkPendingEvents();
+  void postResults(const QList<QByteArray>& records);
+  xmlDocPtr transformRecords(const QByteArray& records);
 
   class Private;
   Private* d;
 
   bool m_connected;
   bool m_aborted;
+  int m_idleTimeout;
 
   QExplicitlySharedDataPointer<Z3950Fetcher> m_fetcher;
   QString m_host;
@@ -129,6 +168,7 @@ private:
   bool m_hasMore;
 
   friend class Z3950ResultFound;
+  friend class Z3950ResultsFound;
   static int resultsLeft;
 };
 
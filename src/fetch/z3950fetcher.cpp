@@ -68,6 +68,8 @@
 namespace {
   static const int Z3950_DEFAULT_PORT = 210;
   static const char* Z3950_DEFAULT_ESN = "F";
+  // seconds to keep an idle connection open for the next search
+  static const int Z3950_DEFAULT_IDLE_TIMEOUT = 120;
 }
 
 using namespace Tellico;
@@ -75,12 +77,13 @@ using Tellico::Fetch::Z3950Fetcher;
 
 Z3950Fetcher::Z3950Fetcher(QObject* parent_)
     : Fetcher(parent_), m_conn(nullptr), m_port(Z3950_DEFAULT_PORT), m_esn(QLatin1String(Z3950_DEFAULT_ESN)),
-      m_started(false), m_done(true), m_MARC21XMLHandler(nullptr),
+      m_idleTimeout(Z3950_DEFAULT_IDLE_TIMEOUT), m_started(false), m_done(true), m_MARC21XMLHandler(nullptr),
       m_UNIMARCXMLHandler(nullptr), m_MODSHandler(nullptr) {
 }
 
 Z3950Fetcher::Z3950Fetcher(QObject* parent_, const QString& preset_)
-    : Fetcher(parent_), m_conn(nullptr), m_port(Z3950_DEFAULT_PORT), m_started(false), m_done(true), m_preset(preset_),
+    : Fetcher(parent_), m_conn(nullptr), m_port(Z3950_DEFAULT_PORT), m_idleTimeout(Z3950_DEFAULT_IDLE_TIMEOUT),
+      m_started(false), m_done(true), m_preset(preset_),
       m_MARC21XMLHandler(nullptr), m_UNIMARCXMLHandler(nullptr), m_MODSHandler(nullptr) {
   QString serverFile = DataFileRegistry::self()->locate(QStringLiteral("z3950-servers.cfg"));
   if(!serverFile.isEmpty()) {
@@ -107,23 +110,24 @@ Z3950Fetcher::Z3950Fetcher(QObject* parent_, const QString& host_, int port_,
                            const QString& dbName_, const QString& syntax_)
     : Fetcher(parent_), m_conn(nullptr), m_host(host_), m_port(port_), m_dbname(dbName_)
     , m_syntax(syntax_), m_esn(QLatin1String(Z3950_DEFAULT_ESN))
-    , m_started(false), m_done(true), m_MARC21XMLHandler(nullptr)
+    , m_idleTimeout(Z3950_DEFAULT_IDLE_TIMEOUT), m_started(false), m_done(true), m_MARC21XMLHandler(nullptr)
     , m_UNIMARCXMLHandler(nullptr), m_MODSHandler(nullptr) {
 }
 
 Z3950Fetcher::~Z3950Fetcher() {
+  // the connection thread uses the stylesheets
+  if(m_conn) {
+    m_conn->wait();
+    m_conn->deleteLater();
+    m_conn = nullptr;
+  }
+
   delete m_MARC21XMLHandler;
   m_MARC21XMLHandler = nullptr;
   delete m_UNIMARCXMLHandler;
   m_UNIMARCXMLHandler = nullptr;
   delete m_MODSHandler;
   m_MODSHandler = nullptr;
-
-  if(m_conn) {
-    m_conn->wait();
-    m_conn->deleteLater();
-    m_conn = nullptr;
-  }
 }
 
 QString Z3950Fetcher::source() const {
@@ -135,6 +139,7 @@ bool Z3950Fetcher::canFetch(int type) const {
 }
 
 void Z3950Fetcher::readConfigHook(const KConfigGroup& config_) {
+  m_idleTimeout = config_.readEntry("Idle Timeout", Z3950_DEFAULT_IDLE_TIMEOUT);
   QString preset = config_.readEntry("Preset");
   if(preset.isEmpty()) {
     m_host = config_.readEntry("Host");
@@ -373,6 +378,15 @@ void Z3950Fetcher::process() {
     if(!m_user.isEmpty()) {
       m_conn->setUserPassword(m_user, m_password);
     }
+    m_conn->setIdleTimeout(m_idleTimeout);
+  }
+
+  // the record syntax may change once the connection is running, so load every
+  // stylesheet now, since the records get transformed on the connection thread
+  if(m_syntax != QLatin1String("grs-1") && m_syntax != QLatin1String("ads")) {
+    initMARC21Handler();
+    initUNIMARCHandler();
+    initMODSHandler();
   }
 
   m_conn->setQuery(m_pqn);
@@ -403,8 +417,8 @@ void Z3950Fetcher::handleResult(const QString& result_) {
     f1.close();
   }
 #endif
-  // assume always utf-8
-  QString str, msg;
+  // MARC and MODS records come in batches through handleResults()
+  QString msg;
   Data::CollPtr coll;
   // not marc, has to be grs-1
   if(m_syntax == QLatin1String("grs-1")) {
@@ -415,47 +429,35 @@ void Z3950Fetcher::handleResult(const QString& result_) {
     Import::ADSImporter imp(result_);
     coll = imp.collection();
     msg = imp.statusMessage();
-  } else { // now the MODS stuff
-    if(m_syntax == QLatin1String("mods")) {
-      str = result_;
-    } else if(m_syntax == QLatin1String("unimarc") && initUNIMARCHandler()) {
-      str = m_UNIMARCXMLHandler->applyStylesheet(result_);
-    } else if(initMARC21Handler()) { // got to be usmarc/marc21
-      str = m_MARC21XMLHandler->applyStylesheet(result_);
-    }
-    if(str.isEmpty() || !initMODSHandler()) {
-      myDebug() << "empty string or can't init";
-      stop();
-      return;
-    }
-#if 0
-    myWarning() << "Remove debug from z3950fetcher.cpp";
-    {
-      QFile f2(QLatin1String("/tmp/mods.xml"));
-//      if(f2.open(QIODevice::WriteOnly)) {
-      if(f2.open(QIODevice::WriteOnly | QIODevice::Append)) {
-        QTextStream t(&f2);
-        t.setCodec("UTF-8");
-        t << str;
-      }
-      f2.close();
-    }
-#endif
-    Import::TellicoImporter imp(m_MODSHandler->applyStylesheet(str));
-    imp.setOptions(imp.options() ^ Import::ImportProgress); // no progress needed
-    coll = imp.collection();
-    msg = imp.statusMessage();
+  }
+  addResults(coll, msg);
+}
+
+void Z3950Fetcher::handleResults(xmlDocPtr doc_) {
+  if(!doc_) {
+    return;
+  }
+  if(!m_started) {
+    xmlFreeDoc(doc_);
+    return;
   }
 
-  if(!coll) {
-    if(!msg.isEmpty()) {
-      message(msg, MessageHandler::Warning);
+  // the importer takes ownership of the document
+  Import::TellicoImporter imp(doc_);
+  imp.setOptions(imp.options() ^ Import::ImportProgress); // no progress needed
+  addResults(imp.collection(), imp.statusMessage());
+}
+
+void Z3950Fetcher::addResults(Data::CollPtr coll_, const QString& msg_) {
+  if(!coll_) {
+    if(!msg_.isEmpty()) {
+      message(msg_, MessageHandler::Warning);
     }
-    myDebug() << "no collection pointer:" << msg;
+    myDebug() << "no collection pointer:" << msg_;
     return;
   }
 
-  if(coll->entryCount() == 0) {
+  if(coll_->entryCount() == 0) {
 //    myDebug() << "no Tellico entry in result";
     return;
   }
@@ -466,14 +468,14 @@ void Z3950Fetcher::handleResult(const QString& result_) {
   QHashIterator<QString, QString> i(allOptionalFields());
   while(i.hasNext()) {
     i.next();
-    Data::FieldPtr field = coll->fieldByName(i.key());
+    Data::FieldPtr field = coll_->fieldByName(i.key());
     if(field) {
       field->setTitle(i.value());
-      coll->modifyField(field);
+      coll_->modifyField(field);
     }
   }
 
-  Data::EntryList entries = coll->entries();
+  Data::EntryList entries = coll_->entries();
   foreach(Data::EntryPtr entry, entries) {
     FetchResult* r = new FetchResult(Fetcher::Ptr(this), entry);
     m_entries.insert(r->uid, entry);
@@ -501,6 +503,12 @@ void Z3950Fetcher::customEvent(QEvent* event_) {
     }
     Z3950ResultFound* e = static_cast<Z3950ResultFound*>(event_);
     handleResult(e->result());
+  } else if(event_->type() == Z3950ResultsFound::uid()) {
+    if(m_done) {
+      myWarning() << "result returned after done signal!";
+    }
+    Z3950ResultsFound* e = static_cast<Z3950ResultsFound*>(event_);
+    handleResults(e->takeDocument());
   } else if(event_->type() == Z3950ConnectionDone::uid()) {
     Z3950ConnectionDone* e = static_cast<Z3950ConnectionDone*>(event_);
     if(e->messageType() > -1) {
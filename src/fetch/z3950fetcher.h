@@ -41,6 +41,9 @@
 #include <QPointer>
 #include <QEvent>
 
+// for xmlDocPtr
+#include <libxml/tree.h>
+
 class QSpinBox;
 
 class KComboBox;
@@ -101,6 +104,8 @@ private:
   bool initMODSHandler();
   void process();
   void handleResult(const QString& result);
+  void handleResults(xmlDocPtr doc);
+  void addResults(Data::CollPtr coll, const QString& msg);
   void done();
 
   Z3950Connection* m_conn;
@@ -114,6 +119,7 @@ private:
   QString m_syntax;
   QString m_pqn; // prefix query notation
   QString m_esn; // element set name
+  int m_idleTimeout; // seconds
 
   QHash<uint, Data::EntryPtr> m_entries;
   bool m_started;
@@ -43,6 +43,7 @@
 #include "utils/cursorsaver.h"
 #include "utils/stringset.h"
 #include "images/image.h"
+#include "images/imagefactory.h"
 #include "tellico_debug.h"
 
 #ifdef ENABLE_WEBCAM
@@ -83,6 +84,14 @@ namespace {
   static const char* FETCH_STRING_SEARCH = I18N_NOOP("&Search");
   static const char* FETCH_STRING_STOP   = I18N_NOOP("&Stop");
 
+  // the all sources item is marked by its data, since a source could have the same name
+  Tellico::Fetch::KeyMap sourceKeyMap(const QComboBox* combo_, int idx_) {
+    if(combo_->itemData(idx_).toBool()) {
+      return Tellico::Fetch::Manager::self()->allSourcesKeyMap();
+    }
+    return Tellico::Fetch::Manager::self()->keyMap(combo_->itemText(idx_));
+  }
+
   static const int StringDataType = QEvent::User;
   static const int ImageDataType = QEvent::User+1;
 
@@ -223,12 +232,9 @@ FetchDialog::FetchDialog(QWidget* parent_)
   m_sourceCombo = new KComboBox(box2);
   box2HBoxLayout->addWidget(m_sourceCombo);
   label->setBuddy(m_sourceCombo);
-  Fetch::FetcherVec sources = Fetch::Manager::self()->fetchers(m_collType);
-  foreach(Fetch::Fetcher::Ptr fetcher, sources) {
-    m_sourceCombo->addItem(Fetch::Manager::self()->fetcherIcon(fetcher), fetcher->source());
-  }
-  void (QComboBox::* activatedString)(const QString&) = &QComboBox::activated;
-  connect(m_sourceCombo, activatedString, this, &FetchDialog::slotSourceChanged);
+  fillSourceCombo();
+  void (QComboBox::* activatedInt)(int) = &QComboBox::activated;
+  connect(m_sourceCombo, activatedInt, this, &FetchDialog::slotSourceChanged);
   m_sourceCombo->setWhatsThis(i18n("Select the database to search"));
 
   // for whatever reason, the dialog window could get shrunk and truncate the text
@@ -334,6 +340,8 @@ FetchDialog::FetchDialog(QWidget* parent_)
                                   this, &FetchDialog::slotStatus);
   connect(Fetch::Manager::self(), &Fetch::Manager::signalDone,
                                   this, &FetchDialog::slotFetchDone);
+  connect(ImageFactory::self(), &ImageFactory::imageRequestFinished,
+          this, &FetchDialog::slotImageRequestFinished);
 
   KAcceleratorManager::manage(this);
   // initialize combos
@@ -373,6 +381,7 @@ FetchDialog::~FetchDialog() {
   config.writeEntry("Splitter Sizes", static_cast<QSplitter*>(m_treeWidget->parentWidget())->sizes());
   config.writeEntry("Search Key", m_keyCombo->currentData().toInt());
   config.writeEntry("Search Source", m_sourceCombo->currentText());
+  config.writeEntry("Search All Sources", isAllSourcesSelected());
 }
 
 void FetchDialog::closeEvent(QCloseEvent* event_) { // stop fetchers when the dialog is closed
@@ -400,9 +409,12 @@ void FetchDialog::slotSearchClicked() {
     startProgress();
     setStatus(i18n("Searching..."));
     qApp->processEvents();
-    Fetch::Manager::self()->startSearch(m_sourceCombo->currentText(),
-                                        static_cast<Fetch::FetchKey>(m_keyCombo->currentData().toInt()),
-                                        value);
+    const Fetch::FetchKey key = static_cast<Fetch::FetchKey>(m_keyCombo->currentData().toInt());
+    if(isAllSourcesSelected()) {
+      Fetch::Manager::self()->startAllSourcesSearch(key, value);
+    } else {
+      Fetch::Manager::self()->startSearch(m_sourceCombo->currentText(), key, value);
+    }
   }
 }
 
@@ -546,7 +558,7 @@ void FetchDialog::slotAddEntry() {
     if(!entry) {
       setStatus(i18n("Fetching %1...", r->title));
       startProgress();
-      entry = r->fetchEntry();
+      entry = fetchResultEntry(r);
       if(!entry) {
         continue;
       }
@@ -605,7 +617,7 @@ void FetchDialog::slotShowEntry() {
   if(!entry) {
     GUI::CursorSaver cs;
     startProgress();
-    entry = r->fetchEntry();
+    entry = fetchResultEntry(r);
     if(entry) { // might conceivably be null
       m_entries.insert(r->uid, entry);
     }
@@ -632,6 +644,43 @@ void FetchDialog::slotShowEntry() {
   m_entryView->showEntry(entry);
 }
 
+Tellico::Data::EntryPtr FetchDialog::fetchResultEntry(Tellico::Fetch::FetchResult* result_) {
+  // only the entries being shown or added get their images, and those are downloaded
+  // in the background. The image fields hold the urls until slotImageRequestFinished()
+  ImageFactory::setDeferImageRequests(true);
+  Data::EntryPtr entry = result_->fetchEntry();
+  ImageFactory::setDeferImageRequests(false);
+  return entry;
+}
+
+void FetchDialog::slotImageRequestFinished(const QString& url_, const QString& id_) {
+  QList<uint> updatedResults;
+  QHash<int, Data::EntryPtr>::ConstIterator it = m_entries.constBegin();
+  for( ; it != m_entries.constEnd(); ++it) {
+    Data::EntryPtr entry = it.value();
+    if(!entry || !entry->collection()) {
+      continue;
+    }
+    foreach(Data::FieldPtr field, entry->collection()->imageFields()) {
+      if(entry->field(field) == url_) {
+        // an empty id means the image could not be loaded
+        entry->setField(field, id_);
+        updatedResults << it.key();
+      }
+    }
+  }
+  if(updatedResults.isEmpty()) {
+    return;
+  }
+  QList<QTreeWidgetItem*> items = m_treeWidget->selectedItems();
+  if(items.count() == 1) {
+    Fetch::FetchResult* r = static_cast<FetchResultItem*>(items.first())->m_result;
+    if(updatedResults.contains(r->uid)) {
+      m_entryView->showEntry(m_entries.value(r->uid));
+    }
+  }
+}
+
 void FetchDialog::startProgress() {
   m_progress->show();
   m_timer->start(100);
@@ -664,14 +713,19 @@ void FetchDialog::slotInit() {
   }
   slotKeyChanged(m_keyCombo->currentIndex());
 
-  QString source = config.readEntry("Search Source");
-  if(!source.isEmpty()) {
-    int idx = m_sourceCombo->findText(source);
-    if(idx > -1) {
-      m_sourceCombo->setCurrentIndex(idx);
+  int idx = -1;
+  if(config.readEntry("Search All Sources", false)) {
+    idx = m_sourceCombo->findData(true);
+  } else {
+    QString source = config.readEntry("Search Source");
+    if(!source.isEmpty()) {
+      idx = m_sourceCombo->findText(source);
     }
   }
-  slotSourceChanged(m_sourceCombo->currentText());
+  if(idx > -1) {
+    m_sourceCombo->setCurrentIndex(idx);
+  }
+  slotSourceChanged(m_sourceCombo->currentIndex());
 
   m_valueLineEdit->setFocus();
   m_searchButton->setDefault(true);
@@ -688,7 +742,7 @@ void FetchDialog::slotKeyChanged(int idx_) {
       connect(upc, &UPCValidator::signalISBN, this, &FetchDialog::slotUPC2ISBN);
       m_valueLineEdit->setValidator(upc);
       // only want to convert to ISBN if ISBN is accepted by the fetcher
-      Fetch::KeyMap map = Fetch::Manager::self()->keyMap(m_sourceCombo->currentText());
+      Fetch::KeyMap map = sourceKeyMap(m_sourceCombo, m_sourceCombo->currentIndex());
       upc->setCheckISBN(map.contains(Fetch::ISBN));
     }
   } else {
@@ -705,10 +759,10 @@ void FetchDialog::slotKeyChanged(int idx_) {
   }
 }
 
-void FetchDialog::slotSourceChanged(const QString& source_) {
+void FetchDialog::slotSourceChanged(int idx_) {
   int curr = m_keyCombo->currentData().toInt();
   m_keyCombo->clear();
-  Fetch::KeyMap map = Fetch::Manager::self()->keyMap(source_);
+  Fetch::KeyMap map = sourceKeyMap(m_sourceCombo, idx_);
   for(Fetch::KeyMap::ConstIterator it = map.constBegin(); it != map.constEnd(); ++it) {
     m_keyCombo->addItem(it.value(), it.key());
   }
@@ -869,10 +923,7 @@ void FetchDialog::slotResetCollection() {
   }
   m_collType = Kernel::self()->collectionType();
   m_sourceCombo->clear();
-  Fetch::FetcherVec sources = Fetch::Manager::self()->fetchers(m_collType);
-  foreach(Fetch::Fetcher::Ptr fetcher, sources) {
-    m_sourceCombo->addItem(Fetch::Manager::self()->fetcherIcon(fetcher), fetcher->source());
-  }
+  fillSourceCombo();
 
   m_addButton->setIcon(QIcon(QLatin1String(":/icons/") + Kernel::self()->collectionTypeName()));
 
@@ -884,6 +935,21 @@ void FetchDialog::slotResetCollection() {
   }
 }
 
+// the all sources item goes last, so a single source stays the default
+void FetchDialog::fillSourceCombo() {
+  Fetch::FetcherVec sources = Fetch::Manager::self()->fetchers(m_collType);
+  foreach(Fetch::Fetcher::Ptr fetcher, sources) {
+    m_sourceCombo->addItem(Fetch::Manager::self()->fetcherIcon(fetcher), fetcher->source(), false);
+  }
+  if(sources.count() > 1) {
+    m_sourceCombo->addItem(QIcon::fromTheme(QStringLiteral("edit-find")), Fetch::Manager::allSourcesName(), true);
+  }
+}
+
+bool FetchDialog::isAllSourcesSelected() const {
+  return m_sourceCombo->currentData().toBool();
+}
+
 void FetchDialog::slotBarcodeRecognized(const QString& string_) {
   // attention: this slot is called in the context of another thread => do not use GUI-functions!
   StringDataEvent* e = new StringDataEvent(string_);
@@ -97,7 +97,7 @@ private Q_SLOTS:
   void slotFetchDone();
   void slotResultFound(Tellico::Fetch::FetchResult* result);
   void slotKeyChanged(int);
-  void slotSourceChanged(const QString& source);
+  void slotSourceChanged(int idx);
   void slotMultipleISBN(bool toggle);
   void slotEditMultipleISBN();
   void slotInit();
@@ -108,9 +108,13 @@ private Q_SLOTS:
 
   void slotBarcodeRecognized(const QString&);
   void slotBarcodeGotImage(const QImage&);
+  void slotImageRequestFinished(const QString& url, const QString& id);
 
 private:
   void fetchDone(bool checkISBN);
+  void fillSourceCombo();
+  bool isAllSourcesSelected() const;
+  Data::EntryPtr fetchResultEntry(Fetch::FetchResult* result);
   void startProgress();
   void stopProgress();
   void setStatus(const QString& text);
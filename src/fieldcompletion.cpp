@@ -24,12 +24,15 @@
 
 #include "fieldcompletion.h"
 #include "fieldformat.h"
+#include "document.h"
+#include "collection.h"
 
 #include <KCompletion/KCompletionMatches>
 
 using Tellico::FieldCompletion;
 
-FieldCompletion::FieldCompletion(bool multiple_) : KCompletion(), m_multiple(multiple_) {
+FieldCompletion::FieldCompletion(const QString& fieldName_, bool multiple_) : KCompletion()
+    , m_fieldName(fieldName_), m_multiple(multiple_), m_itemsRevision(0), m_itemsCollectionId(-1) {
 }
 
 QString FieldCompletion::makeCompletion(const QString& string_) {
@@ -39,27 +42,54 @@ QString FieldCompletion::makeCompletion(const QString& string_) {
   }
 
   if(!m_multiple) {
+    updateItems(string_);
     return KCompletion::makeCompletion(string_);
   }
 
   static QRegExp rx = FieldFormat::delimiterRegExp();
   int pos = rx.lastIndexIn(string_);
   if(pos == -1) {
+    updateItems(string_);
     m_beginText.clear();
     return KCompletion::makeCompletion(string_);
   }
 
   pos += rx.matchedLength();
   QString final = string_.mid(pos);
+  // setting the items clears the begin text, so update them first
+  updateItems(final);
   m_beginText = string_.mid(0, pos);
   return m_beginText + KCompletion::makeCompletion(final);
 }
 
 void FieldCompletion::clear() {
   m_beginText.clear();
+  m_itemsPrefix.clear();
   KCompletion::clear();
 }
 
+// the current items are still good as long as the index has not changed and the text
+// only got longer, since KCompletion narrows down the matches by itself
+void FieldCompletion::updateItems(const QString& prefix_) {
+  if(prefix_.isEmpty()) {
+    return;
+  }
+  Data::CollPtr coll = Data::Document::self()->collection();
+  if(!coll) {
+    return;
+  }
+  if(!m_itemsPrefix.isEmpty() &&
+     prefix_.startsWith(m_itemsPrefix, Qt::CaseInsensitive) &&
+     m_itemsRevision == coll->valuesRevision() &&
+     m_itemsCollectionId == coll->id()) {
+    return;
+  }
+  setItems(coll->valuesByPrefix(m_fieldName, prefix_));
+  m_itemsPrefix = prefix_;
+  m_itemsRevision = coll->valuesRevision();
+  m_itemsCollectionId = coll->id();
+}
+
 void FieldCompletion::postProcessMatch(QString* match_) const {
   if(m_multiple) {
     match_->prepend(m_beginText);
@@ -30,13 +30,16 @@
 namespace Tellico {
 
 /**
+ * Completes the values of a collection field. The items are not set up front, but
+ * read from the collection's value index for the text being completed.
+ *
  * @author Robby Stephenson
  */
 class FieldCompletion : public KCompletion {
 Q_OBJECT
 
 public:
-  FieldCompletion(bool multiple);
+  FieldCompletion(const QString& fieldName, bool multiple);
 
   void setMultiple(bool m) { m_multiple = m; }
   virtual QString makeCompletion(const QString& string) Q_DECL_OVERRIDE;
@@ -48,8 +51,15 @@ protected:
   virtual void postProcessMatches(KCompletionMatches* matches) const Q_DECL_OVERRIDE;
 
 private:
+  void updateItems(const QString& prefix);
+
+  QString m_fieldName;
   bool m_multiple;
   QString m_beginText;
+  // the prefix and index revision of the current items
+  QString m_itemsPrefix;
+  uint m_itemsRevision;
+  int m_itemsCollectionId;
 };
 
 } // end namespace
@@ -25,10 +25,112 @@
 #include "fieldformat.h"
 #include "config/tellico_config.h"
 
+#include <QSet>
+#include <QThreadStorage>
+
 using Tellico::FieldFormat;
 
+namespace {
+  // the config lists are checked for nearly every word which gets formatted, so keep
+  // case-folded sets of the words, rebuilt only when the config strings change.
+  // QRegExp keeps the state of its last match, and values may be formatted on
+  // background threads, so every thread has its own tables
+  class FormatTables {
+  public:
+    FormatTables()
+        : commaSplit(QLatin1String("\\s*,\\s*"))
+        , spaceComma(QLatin1String("[\\s,]"))
+        , periodSpace(QLatin1String("\\.\\s*(?=.)")) {}
+
+    static FormatTables& self() {
+      static QThreadStorage<FormatTables> tables;
+      FormatTables& t = tables.localData();
+      t.update();
+      return t;
+    }
+
+    const QList<QRegExp>& articles() {
+      const QStringList articleList = Tellico::Config::articleList();
+      if(m_articleList != articleList) {
+        m_articleList = articleList;
+        m_articles.clear();
+        foreach(const QString& article, m_articleList) {
+          m_articles << QRegExp(QLatin1String("\\b") + QRegExp::escape(article) + QLatin1String("\\b"));
+        }
+      }
+      return m_articles;
+    }
+
+    QSet<QString> noCapitalization;
+    QSet<QString> surnamePrefixes;
+    QSet<QString> nameSuffixes;
+    QRegExp commaSplit;
+    QRegExp spaceComma;
+    // the ending look-ahead is so that a space is not added at the end
+    QRegExp periodSpace;
+
+  private:
+    static QSet<QString> foldedSet(const QStringList& list) {
+      QSet<QString> set;
+      set.reserve(list.count());
+      foreach(const QString& word, list) {
+        set.insert(word.toCaseFolded());
+      }
+      return set;
+    }
+
+    // the config strings are only read on the main thread, so compare the lists, which are
+    // shared with the config cache until it changes and so are quick to compare
+    void update() {
+      const QStringList noCapitalizationList = Tellico::Config::noCapitalizationList();
+      if(m_noCapitalizationList != noCapitalizationList) {
+        m_noCapitalizationList = noCapitalizationList;
+        noCapitalization = foldedSet(noCapitalizationList);
+      }
+      const QStringList surnamePrefixTokens = Tellico::Config::surnamePrefixTokens();
+      if(m_surnamePrefixTokens != surnamePrefixTokens) {
+        m_surnamePrefixTokens = surnamePrefixTokens;
+        surnamePrefixes = foldedSet(surnamePrefixTokens);
+      }
+      const QStringList nameSuffixList = Tellico::Config::nameSuffixList();
+      if(m_nameSuffixList != nameSuffixList) {
+        m_nameSuffixList = nameSuffixList;
+        nameSuffixes = foldedSet(nameSuffixList);
+      }
+    }
+
+    QStringList m_noCapitalizationList;
+    QStringList m_surnamePrefixTokens;
+    QStringList m_nameSuffixList;
+    QStringList m_articleList;
+    QList<QRegExp> m_articles;
+  };
+
+  // same as the [-\s,.;] regexp used to split words for capitalization
+  inline bool isWordSeparator(QChar c) {
+    return c == QLatin1Char('-') || c == QLatin1Char(',') || c == QLatin1Char('.') ||
+           c == QLatin1Char(';') || c.isSpace();
+  }
+
+  int nextWordSeparator(const QString& str, int from) {
+    const int length = str.length();
+    for(int i = from; i < length; ++i) {
+      if(isWordSeparator(str.at(i))) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // true if the lower-case string starts with the article, followed by a space
+  inline bool startsWithArticle(const QString& lower, const QString& article) {
+    return lower.length() > article.length() &&
+           lower.at(article.length()) == QLatin1Char(' ') &&
+           lower.startsWith(article);
+  }
+}
+
 QRegExp FieldFormat::delimiterRx = QRegExp(QLatin1String("\\s*;\\s*"));
-QRegExp FieldFormat::commaSplitRx = QRegExp(QLatin1String("\\s*,\\s*"));
 
 QString FieldFormat::delimiterString() {
   return QStringLiteral("; ");
@@ -39,9 +141,8 @@ QRegExp FieldFormat::delimiterRegExp() {
 }
 
 QString FieldFormat::fixupValue(const QString& value_) {
-  QString value = value_;
-  value.replace(delimiterRx, delimiterString());
-  return value;
+  // same as replacing delimiterRx with the delimiter string
+  return splitValue(value_).join(delimiterString());
 }
 
 QString FieldFormat::columnDelimiterString() {
@@ -56,8 +157,36 @@ QStringList FieldFormat::splitValue(const QString& string_, SplitParsing parsing
   if(string_.isEmpty()) {
     return QStringList();
   }
-  return parsing_ == StringSplit ? string_.split(delimiterString(), behavior_)
-                                 : string_.split(delimiterRx, behavior_);
+  if(parsing_ == StringSplit) {
+    return string_.split(delimiterString(), behavior_);
+  }
+
+  // this gives the same result as splitting with delimiterRx, but without the regexp engine
+  // the white space on either side of the semi-colon is part of the delimiter
+  // QString::indexOf(QChar) is already vectorized by Qt
+  const QChar* data = string_.constData();
+  const int length = string_.length();
+  QStringList values;
+  int start = 0;
+  int pos = string_.indexOf(QLatin1Char(';'));
+  while(pos > -1) {
+    int end = pos;
+    while(end > start && data[end-1].isSpace()) {
+      --end;
+    }
+    if(end > start || behavior_ == QString::KeepEmptyParts) {
+      values << string_.mid(start, end-start);
+    }
+    start = pos + 1;
+    while(start < length && data[start].isSpace()) {
+      ++start;
+    }
+    pos = string_.indexOf(QLatin1Char(';'), start);
+  }
+  if(start < length || behavior_ == QString::KeepEmptyParts) {
+    values << string_.mid(start);
+  }
+  return values;
 }
 
 QStringList FieldFormat::splitRow(const QString& string_, QString::SplitBehavior behavior_) {
@@ -65,7 +194,8 @@ QStringList FieldFormat::splitRow(const QString& string_, QString::SplitBehavior
 }
 
 QStringList FieldFormat::splitTable(const QString& string_, QString::SplitBehavior behavior_) {
-  return string_.isEmpty() ? QStringList() : string_.split(rowDelimiterString(), behavior_);
+  // the row delimiter is a single character, avoid creating the string each time
+  return string_.isEmpty() ? QStringList() : string_.split(QChar(0x2028), behavior_);
 }
 
 QString FieldFormat::sortKeyTitle(const QString& title_) {
@@ -73,7 +203,7 @@ QString FieldFormat::sortKeyTitle(const QString& title_) {
   foreach(const QString& article, Config::articleList()) {
     // assume white space is already stripped
     // the articles are already in lower-case
-    if(lower.startsWith(article + QLatin1Char(' '))) {
+    if(startsWithArticle(lower, article)) {
       return title_.mid(article.length() + 1);
     }
   }
@@ -87,19 +217,7 @@ QString FieldFormat::sortKeyTitle(const QString& title_) {
 }
 
 void FieldFormat::stripArticles(QString& value) {
-  static QStringList oldArticleList;
-  static QList<QRegExp> rxList;
-  if(oldArticleList != Config::articleList()) {
-    oldArticleList = Config::articleList();
-    rxList.clear();
-    foreach(const QString& article, oldArticleList) {
-      QRegExp rx(QLatin1String("\\b") +
-                 QRegExp::escape(article) +
-                 QLatin1String("\\b"));
-      rxList << rx;
-    }
-  }
-  foreach(const QRegExp& rx, rxList) {
+  foreach(const QRegExp& rx, FormatTables::self().articles()) {
     value.remove(rx);
   }
   value = value.trimmed();
@@ -112,7 +230,21 @@ QString FieldFormat::format(const QString& value_, Type type_, Request request_)
   if(value_.isEmpty()) {
     return value_;
   }
+  return formatValue(value_, type_, formatOptions(request_));
+}
 
+QStringList FieldFormat::formatList(const QStringList& values_, Type type_, Request request_) {
+  // only look up the config options once for the whole list
+  const Options options = formatOptions(request_);
+  QStringList formattedValues;
+  formattedValues.reserve(values_.count());
+  foreach(const QString& value, values_) {
+    formattedValues << (value.isEmpty() ? value : formatValue(value, type_, options));
+  }
+  return formattedValues;
+}
+
+FieldFormat::Options FieldFormat::formatOptions(Request request_) {
   Options options;
   if(request_ == ForceFormat || (request_ != AsIsFormat && Config::autoCapitalization())) {
     options |= FormatCapitalize;
@@ -120,20 +252,23 @@ QString FieldFormat::format(const QString& value_, Type type_, Request request_)
   if(request_ == ForceFormat || (request_ != AsIsFormat && Config::autoFormat())) {
     options |= FormatAuto;
   }
+  return options;
+}
 
+QString FieldFormat::formatValue(const QString& value_, Type type_, Options options_) {
   QString text;
   switch(type_) {
     case FormatTitle:
-      text = title(value_, options);
+      text = title(value_, options_);
       break;
     case FormatName:
-      text = name(value_, options);
+      text = name(value_, options_);
       break;
     case FormatDate:
       text = date(value_);
       break;
     case FormatPlain:
-      text = options.testFlag(FormatCapitalize) ? capitalize(value_) : value_;
+      text = options_.testFlag(FormatCapitalize) ? capitalize(value_) : value_;
       break;
     case FormatNone:
       text = value_;
@@ -155,7 +290,7 @@ QString FieldFormat::title(const QString& title_, Options opt_) {
 
     // arbitrarily impose rule that a space must follow every comma
     // has to come before the capitalization since the space is significant
-    newTitle.replace(commaSplitRx, QStringLiteral(", "));
+    newTitle.replace(FormatTables::self().commaSplit, QStringLiteral(", "));
   }
 
   if(opt_.testFlag(FormatCapitalize)) {
@@ -168,11 +303,15 @@ QString FieldFormat::title(const QString& title_, Options opt_) {
     foreach(const QString& article, Config::articleList()) {
       // assume white space is already stripped
       // the articles are already in lower-case
-      if(lower.startsWith(article + QLatin1Char(' '))) {
-        QRegExp regexp(QLatin1Char('^') + QRegExp::escape(article) + QLatin1String("\\s*"), Qt::CaseInsensitive);
+      if(startsWithArticle(lower, article)) {
         // can't just use article since it's in lower-case
-        QString titleArticle = newTitle.left(article.length());
-        newTitle = newTitle.remove(regexp)
+        const QString titleArticle = newTitle.left(article.length());
+        // remove the article and the white space after it
+        int pos = article.length();
+        while(pos < newTitle.length() && newTitle.at(pos).isSpace()) {
+          ++pos;
+        }
+        newTitle = newTitle.mid(pos)
                            .append(QLatin1String(", "))
                            .append(titleArticle);
         break;
@@ -184,18 +323,15 @@ QString FieldFormat::title(const QString& title_, Options opt_) {
 }
 
 QString FieldFormat::name(const QString& name_, Options opt_) {
-  static const QRegExp spaceComma(QLatin1String("[\\s,]"));
-  // the ending look-ahead is so that a space is not added at the end
-  static const QRegExp periodSpace(QLatin1String("\\.\\s*(?=.)"));
-
+  const FormatTables& tables = FormatTables::self();
   QString name = name_;
-  name.replace(periodSpace, QStringLiteral(". "));
+  name.replace(tables.periodSpace, QStringLiteral(". "));
   if(opt_.testFlag(FormatCapitalize)) {
     name = capitalize(name);
   }
 
   // split the name by white space and commas
-  QStringList words = name.split(spaceComma, QString::SkipEmptyParts);
+  QStringList words = name.split(tables.spaceComma, QString::SkipEmptyParts);
   // psycho case where name == ","
   if(words.isEmpty()) {
     return name;
@@ -203,16 +339,16 @@ QString FieldFormat::name(const QString& name_, Options opt_) {
 
   // if it contains a comma already and the last word is not a suffix, don't format it
   if(!opt_.testFlag(FormatAuto) ||
-      (name.indexOf(QLatin1Char(',')) > -1 && !Config::nameSuffixList().contains(words.last(), Qt::CaseInsensitive))) {
+      (name.indexOf(QLatin1Char(',')) > -1 && !tables.nameSuffixes.contains(words.last().toCaseFolded()))) {
     // arbitrarily impose rule that no spaces before a comma and
     // a single space after every comma
-    name.replace(commaSplitRx, QStringLiteral(", "));
+    name.replace(tables.commaSplit, QStringLiteral(", "));
   } else if(words.count() > 1) {
     // otherwise split it by white space, move the last word to the front
     // but only if there is more than one word
 
     // if the last word is a suffix, it has to be kept with last name
-    if(Config::nameSuffixList().contains(words.last(), Qt::CaseInsensitive)) {
+    if(tables.nameSuffixes.contains(words.last().toCaseFolded())) {
       words.prepend(words.last().append(QLatin1Char(',')));
       words.removeLast();
     }
@@ -226,7 +362,7 @@ QString FieldFormat::name(const QString& name_, Options opt_) {
     // In a previous version of Tellico, using a prefix such as "van der" (with a space) would work
     // because QStringList::contains did substring matching, but now need to add a function for tokenizing
     // the list with whitespace as well as comma
-    while(Config::surnamePrefixTokens().contains(words.last(), Qt::CaseInsensitive)) {
+    while(tables.surnamePrefixes.contains(words.last().toCaseFolded())) {
       words.prepend(words.last());
       words.removeLast();
     }
@@ -273,20 +409,21 @@ QString FieldFormat::capitalize(QString str_) {
     return str_;
   }
 
-  // regexp to split words
-  const QRegExp rx(QLatin1String("[-\\s,.;]"));
+  const FormatTables& tables = FormatTables::self();
+  const QStringList aposArticles = Config::articleAposList();
 
   // first letter is always capitalized
-  str_.replace(0, 1, str_.at(0).toUpper());
+  str_[0] = str_.at(0).toUpper();
 
   // special case for french words like l'espace
 
-  int pos = rx.indexIn(str_, 1);
+  // words are split by the same characters as the [-\s,.;] regexp
+  int pos = nextWordSeparator(str_, 1);
   int nextPos;
 
   QString word = str_.mid(0, pos);
   // now check to see if words starts with apostrophe list
-  foreach(const QString& aposArticle, Config::articleAposList()) {
+  foreach(const QString& aposArticle, aposArticles) {
     if(word.startsWith(aposArticle, Qt::CaseInsensitive)) {
       const uint l = aposArticle.length();
       str_.replace(l, 1, str_.at(l).toUpper());
@@ -296,14 +433,14 @@ QString FieldFormat::capitalize(QString str_) {
 
   while(pos > -1) {
     // also need to compare against list of non-capitalized words
-    nextPos = rx.indexIn(str_, pos+1);
+    nextPos = nextWordSeparator(str_, pos+1);
     if(nextPos == -1) {
       nextPos = str_.length();
     }
     word = str_.mid(pos+1, nextPos-pos-1);
     bool aposMatch = false;
     // now check to see if words starts with apostrophe list
-    foreach(const QString& aposArticle, Config::articleAposList()) {
+    foreach(const QString& aposArticle, aposArticles) {
       if(word.startsWith(aposArticle, Qt::CaseInsensitive)) {
         const uint l = aposArticle.length();
         str_.replace(pos+l+1, 1, str_.at(pos+l+1).toUpper());
@@ -312,17 +449,17 @@ QString FieldFormat::capitalize(QString str_) {
       }
     }
 
-    if(!aposMatch) {
+    if(!aposMatch && nextPos-pos > 1) {
       // check against the noCapitalization list AND the surnamePrefix list
       // does this hold true everywhere other than english?
-      if(!Config::noCapitalizationList().contains(word, Qt::CaseInsensitive) &&
-         !Config::surnamePrefixTokens().contains(word, Qt::CaseInsensitive) &&
-         nextPos-pos > 1) {
-        str_.replace(pos+1, 1, str_.at(pos+1).toUpper());
+      const QString foldedWord = word.toCaseFolded();
+      if(!tables.noCapitalization.contains(foldedWord) &&
+         !tables.surnamePrefixes.contains(foldedWord)) {
+        str_[pos+1] = str_.at(pos+1).toUpper();
       }
     }
 
-    pos = rx.indexIn(str_, pos+1);
+    pos = nextWordSeparator(str_, pos+1);
   }
   return str_;
 }
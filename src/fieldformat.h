@@ -98,6 +98,13 @@ public:
   static void stripArticles(QString& value);
 
   static QString format(const QString& value, Type type, Request req);
+  /**
+   * Formats a list of values, such as all the values in a column, checking the
+   * formatting options only once.
+   *
+   * @param values The strings to be formatted
+   */
+  static QStringList formatList(const QStringList& values, Type type, Request req);
 
   /**
    * A convenience function to format a string as a title.
@@ -132,8 +139,10 @@ public:
   static QString capitalize(QString str);
 
 private:
+  static Options formatOptions(Request req);
+  static QString formatValue(const QString& value, Type type, Options options);
+
   static QRegExp delimiterRx;
-  static QRegExp commaSplitRx;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(FieldFormat::Options)
@@ -46,6 +46,11 @@
 #include <QHeaderView>
 #include <QContextMenuEvent>
 
+namespace {
+  // collections with more entries than this get grouped incrementally
+  static const int GROUP_VIEW_INCREMENTAL_SIZE = 2000;
+}
+
 using Tellico::GroupView;
 
 GroupView::GroupView(QWidget* parent_)
@@ -128,6 +133,13 @@ void GroupView::populateCollection() {
     return;
   }
 
+  // for large collections, the groups get added as they are populated from the event loop
+  if(m_coll->entryCount() > GROUP_VIEW_INCREMENTAL_SIZE && !m_coll->isEntryGroupDictPopulated(m_groupBy)) {
+    setUpdatesEnabled(true);
+    m_coll->requestEntryGroupDict(m_groupBy);
+    return;
+  }
+
   Data::EntryGroupDict* dict = m_coll->entryGroupDictByName(m_groupBy);
   if(!dict) { // could happen if m_groupBy is non empty, but there are no entries with a value
     setUpdatesEnabled(true);
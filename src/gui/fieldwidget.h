@@ -65,9 +65,6 @@ public:
   // calls updateFieldHook()
   void updateField(Data::FieldPtr oldField, Data::FieldPtr newField);
 
-  // only used by LineFieldWidget, really
-  virtual void addCompletionObjectItem(const QString&) {}
-
   // factory function
   static FieldWidget* create(Data::FieldPtr field, QWidget* parent);
 
@@ -138,8 +138,7 @@ void FilterRuleWidget::slotRuleFieldChanged(int which_) {
   }
   Data::FieldPtr field = Data::Document::self()->collection()->fieldByTitle(fieldTitle);
   if(field && field->hasFlag(Data::Field::AllowCompletion)) {
-    FieldCompletion* completion = new FieldCompletion(field->hasFlag(Data::Field::AllowMultiple));
-    completion->setItems(Kernel::self()->valuesByFieldName(field->name()));
+    FieldCompletion* completion = new FieldCompletion(field->name(), field->hasFlag(Data::Field::AllowMultiple));
     completion->setIgnoreCase(true);
     m_ruleValue->setCompletionObject(completion);
     m_ruleValue->setAutoDeleteCompletionObject(true);
@@ -26,7 +26,6 @@
 #include "../field.h"
 #include "../fieldformat.h"
 #include "../fieldcompletion.h"
-#include "../tellico_kernel.h"
 #include "../gui/lineedit.h"
 #include "../utils/isbnvalidator.h"
 
@@ -43,8 +42,7 @@ LineFieldWidget::LineFieldWidget(Tellico::Data::FieldPtr field_, QWidget* parent
   registerWidget();
 
   if(field_->hasFlag(Data::Field::AllowCompletion)) {
-    FieldCompletion* completion = new FieldCompletion(field_->hasFlag(Data::Field::AllowMultiple));
-    completion->setItems(Kernel::self()->valuesByFieldName(field_->name()));
+    FieldCompletion* completion = new FieldCompletion(field_->name(), field_->hasFlag(Data::Field::AllowMultiple));
     completion->setIgnoreCase(true);
     m_lineEdit->setCompletionObject(completion);
     m_lineEdit->setAutoDeleteCompletionObject(true);
@@ -72,21 +70,16 @@ void LineFieldWidget::clearImpl() {
   editMultiple(false);
 }
 
-void LineFieldWidget::addCompletionObjectItem(const QString& text_) {
-  m_lineEdit->completionObject()->addItem(text_);
-}
-
 void LineFieldWidget::updateFieldHook(Tellico::Data::FieldPtr oldField_, Tellico::Data::FieldPtr newField_) {
   bool wasComplete = (oldField_->hasFlag(Data::Field::AllowCompletion));
   bool isComplete = (newField_->hasFlag(Data::Field::AllowCompletion));
   if(!wasComplete && isComplete) {
-    FieldCompletion* completion = new FieldCompletion(isComplete);
-    completion->setItems(Kernel::self()->valuesByFieldName(newField_->name()));
+    FieldCompletion* completion = new FieldCompletion(newField_->name(), newField_->hasFlag(Data::Field::AllowMultiple));
     completion->setIgnoreCase(true);
     m_lineEdit->setCompletionObject(completion);
     m_lineEdit->setAutoDeleteCompletionObject(true);
   } else if(wasComplete && !isComplete) {
-    m_lineEdit->completionObject()->clear();
+    m_lineEdit->setCompletionObject(nullptr);
   }
 }
 
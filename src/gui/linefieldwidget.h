@@ -44,7 +44,6 @@ public:
 
   virtual QString text() const Q_DECL_OVERRIDE;
   virtual void setTextImpl(const QString& text) Q_DECL_OVERRIDE;
-  virtual void addCompletionObjectItem(const QString& text) Q_DECL_OVERRIDE;
 
 public Q_SLOTS:
   virtual void clearImpl() Q_DECL_OVERRIDE;
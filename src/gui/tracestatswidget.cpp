@@ -0,0 +1,131 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tracestatswidget.h"
+#include "../utils/tracer.h"
+
+#include <KLocalizedString>
+
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+#include <QIcon>
+
+using Tellico::GUI::TraceStatsWidget;
+
+namespace {
+  static const int TRACE_STATS_REFRESH_MSECS = 1000;
+
+  enum StatColumn {
+    NameColumn, CategoryColumn, CountColumn, TotalColumn, AverageColumn, MaximumColumn
+  };
+
+  // the statistics are kept in nanoseconds
+  inline double toMilliseconds(qint64 nsecs_) {
+    return qRound64(nsecs_ / 1000.0) / 1000.0;
+  }
+}
+
+TraceStatsWidget::TraceStatsWidget(QWidget* parent_) : QWidget(parent_) {
+  QBoxLayout* l = new QVBoxLayout(this);
+  l->setMargin(0);
+
+  m_treeWidget = new QTreeWidget(this);
+  m_treeWidget->setRootIsDecorated(false);
+  m_treeWidget->setAllColumnsShowFocus(true);
+  m_treeWidget->setSortingEnabled(true);
+  m_treeWidget->setHeaderLabels(QStringList() << i18n("Operation")
+                                              << i18n("Category")
+                                              << i18n("Count")
+                                              << i18n("Total (ms)")
+                                              << i18n("Average (ms)")
+                                              << i18n("Maximum (ms)"));
+  m_treeWidget->sortByColumn(TotalColumn, Qt::DescendingOrder);
+  m_treeWidget->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+  l->addWidget(m_treeWidget);
+
+  QHBoxLayout* hbox = new QHBoxLayout();
+  l->addLayout(hbox);
+  QLabel* label = new QLabel(this);
+  if(Tracer::isTracing()) {
+    label->setText(i18n("Trace events are also written to the file in TELLICO_TRACE_FILE."));
+  } else {
+    label->setText(i18n("Set TELLICO_TRACE_FILE to write trace events to a file."));
+  }
+  label->setWordWrap(true);
+  hbox->addWidget(label, 1);
+
+  QPushButton* resetButton = new QPushButton(i18n("&Reset"), this);
+  resetButton->setIcon(QIcon::fromTheme(QStringLiteral("edit-clear")));
+  connect(resetButton, &QAbstractButton::clicked, this, &TraceStatsWidget::slotReset);
+  hbox->addWidget(resetButton);
+
+  m_timer = new QTimer(this);
+  m_timer->setInterval(TRACE_STATS_REFRESH_MSECS);
+  connect(m_timer, &QTimer::timeout, this, &TraceStatsWidget::slotRefresh);
+}
+
+void TraceStatsWidget::showEvent(QShowEvent* event_) {
+  QWidget::showEvent(event_);
+  slotRefresh();
+  m_timer->start();
+}
+
+void TraceStatsWidget::hideEvent(QHideEvent* event_) {
+  // nothing to update if nobody is looking
+  m_timer->stop();
+  QWidget::hideEvent(event_);
+}
+
+void TraceStatsWidget::slotRefresh() {
+  // keep the sort order, but don't resort while the items are being added
+  m_treeWidget->setSortingEnabled(false);
+  m_treeWidget->clear();
+  foreach(const Tracer::Stat& stat, Tracer::stats()) {
+    QTreeWidgetItem* item = new QTreeWidgetItem(m_treeWidget);
+    item->setText(NameColumn, QString::fromUtf8(stat.name));
+    item->setText(CategoryColumn, QString::fromLatin1(stat.category));
+    // numbers are set as data so they sort numerically
+    item->setData(CountColumn, Qt::DisplayRole, stat.count);
+    // counters have no duration
+    if(stat.totalTime > 0) {
+      item->setData(TotalColumn, Qt::DisplayRole, toMilliseconds(stat.totalTime));
+      item->setData(AverageColumn, Qt::DisplayRole, toMilliseconds(stat.totalTime / qMax(Q_INT64_C(1), stat.count)));
+      item->setData(MaximumColumn, Qt::DisplayRole, toMilliseconds(stat.maxTime));
+    }
+    for(int col = CountColumn; col <= MaximumColumn; ++col) {
+      item->setTextAlignment(col, Qt::AlignRight | Qt::AlignVCenter);
+    }
+  }
+  m_treeWidget->setSortingEnabled(true);
+}
+
+void TraceStatsWidget::slotReset() {
+  Tracer::resetStats();
+  slotRefresh();
+}
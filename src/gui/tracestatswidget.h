@@ -0,0 +1,63 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_GUI_TRACESTATSWIDGET_H
+#define TELLICO_GUI_TRACESTATSWIDGET_H
+
+#include <QWidget>
+
+class QTreeWidget;
+class QTimer;
+
+namespace Tellico {
+  namespace GUI {
+
+/**
+ * Shows the timing statistics from the @ref Tracer, updated every second while
+ * the widget is visible.
+ *
+ * @author Robby Stephenson
+ */
+class TraceStatsWidget : public QWidget {
+Q_OBJECT
+
+public:
+  explicit TraceStatsWidget(QWidget* parent);
+
+protected:
+  virtual void showEvent(QShowEvent* event) Q_DECL_OVERRIDE;
+  virtual void hideEvent(QHideEvent* event) Q_DECL_OVERRIDE;
+
+private Q_SLOTS:
+  void slotRefresh();
+  void slotReset();
+
+private:
+  QTreeWidget* m_treeWidget;
+  QTimer* m_timer;
+};
+
+  } // end namespace
+} // end namespace
+#endif
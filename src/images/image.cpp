@@ -24,9 +24,11 @@
 
 #include "image.h"
 #include "../utils/string_utils.h"
+#include "../utils/tracer.h"
 #include "../tellico_debug.h"
 
 #include <QBuffer>
+#include <QFile>
 #include <QRegExp>
 #include <QImageReader>
 #include <QImageWriter>
@@ -43,6 +45,7 @@ Image::Image() : QImage(), m_linkOnly(false) {
 Image::Image(const Image& other) : QImage(other)
   , m_id(other.m_id)
   , m_format(other.m_format)
+  , m_data(other.m_data)
   , m_linkOnly(other.m_linkOnly) {
 }
 
@@ -51,6 +54,7 @@ Image& Image::operator=(const Image& other) {
   if(this != &other) {
     m_id = other.m_id;
     m_format = other.m_format;
+    m_data = other.m_data;
     m_linkOnly = other.m_linkOnly;
   }
   return *this;
@@ -59,12 +63,18 @@ Image& Image::operator=(const Image& other) {
 // I'm using the MD5 hash as the id. I consider it rather unlikely that two images in one
 // collection could ever have the same hash, and this lets me do a fast comparison of two images
 // simply by comparing their ids.
-Image::Image(const QString& filename_, const QString& id_) : QImage(filename_), m_id(idClean(id_)), m_linkOnly(false) {
+Image::Image(const QString& filename_, const QString& id_) : QImage(), m_id(idClean(id_)), m_linkOnly(false) {
+  TRACE_SCOPE("image", "decodeImage");
+  QFile file(filename_);
+  if(file.open(QIODevice::ReadOnly)) {
+    m_data = file.readAll();
+  }
   m_format = QImageReader::imageFormat(filename_);
+  loadFromData(m_data, m_format.isEmpty() ? nullptr : m_format.constData());
   if(isNull()) {
     // Tellico had an earlier bug where images were written in PNG format with a GIF extension
     // and for some reason, qt doesn't recognize the file then, so fall back and try to load as PNG
-    load(filename_, "PNG");
+    loadFromData(m_data, "PNG");
     if(!isNull()) {
       myWarning() << filename_ << "loaded as PNG image";
       m_format = "PNG";
@@ -80,9 +90,12 @@ Image::Image(const QImage& img_, const QString& format_) : QImage(img_), m_forma
 }
 
 Image::Image(const QByteArray& data_, const QString& format_, const QString& id_)
-    : QImage(QImage::fromData(data_)), m_id(idClean(id_)), m_format(format_.toLatin1()), m_linkOnly(false) {
+    : QImage(), m_id(idClean(id_)), m_format(format_.toLatin1()), m_data(data_), m_linkOnly(false) {
+  TRACE_SCOPE("image", "decodeImage");
+  loadFromData(data_);
   if(isNull()) {
     m_id.clear();
+    m_data.clear();
   }
 }
 
@@ -90,6 +103,9 @@ Image::~Image() {
 }
 
 QByteArray Image::byteArray() const {
+  if(!m_data.isEmpty()) {
+    return m_data;
+  }
   return byteArray(*this, outputFormat(m_format));
 }
 
@@ -147,10 +163,25 @@ void Image::setID(const QString& id_) {
   m_id = m_linkOnly ? id_ : idClean(id_);
 }
 
+void Image::setFormat(const QByteArray& format_) {
+  // the original data is only useful when it matches the format
+  if(qstricmp(format_.constData(), m_format.constData()) != 0) {
+    m_data.clear();
+  }
+  m_format = format_;
+}
+
 void Image::calculateID() {
   // the id will eventually be used as a filename
+  // it's always computed from the encoded image rather than the original data, so that
+  // an image added again gets the same id as it did in earlier versions
   if(!isNull()) {
-    m_id = calculateID(byteArray(), QLatin1String(m_format));
+    const QByteArray ba = byteArray(*this, outputFormat(m_format));
+    m_id = calculateID(ba, QLatin1String(m_format));
+    // images created from a QImage have no original data
+    if(m_data.isEmpty()) {
+      m_data = ba;
+    }
   }
 }
 
@@ -55,6 +55,10 @@ public:
 
   const QString& id() const { return m_id; };
   const QByteArray& format() const { return m_format; };
+  /**
+   * Returns the encoded image data. The original data is returned when it is known,
+   * so writing the image does not re-encode it.
+   */
   QByteArray byteArray() const;
   bool isNull() const;
   bool linkOnly() const { return m_linkOnly; }
@@ -79,11 +83,17 @@ private:
   Image(const QByteArray& data, const QString& format, const QString& id);
 
   void setID(const QString& id);
-  void setFormat(const QByteArray& format_) { m_format = format_; }
+  void setFormat(const QByteArray& format);
   void calculateID();
+  bool hasEncodedData() const { return !m_data.isEmpty(); }
+  // once the image is in a directory, the data can be read from the file instead
+  void releaseEncodedData() { m_data.clear(); }
 
   QString m_id;
   QByteArray m_format;
+  // the original encoded data, kept to avoid encoding the image again
+  // it's released once the image has been written to an image directory
+  QByteArray m_data;
   bool m_linkOnly : 1;
 
   static QList<QByteArray> s_outputFormats;
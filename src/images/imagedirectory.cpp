@@ -92,7 +92,19 @@ Tellico::Data::Image* ImageDirectory::imageById(const QString& id_) {
   return img;
 }
 
+QByteArray ImageDirectory::imageData(const QString& id_) {
+  QFile file(path() + id_);
+  if(!file.open(QIODevice::ReadOnly)) {
+    return QByteArray();
+  }
+  return file.readAll();
+}
+
 bool ImageDirectory::writeImage(const Data::Image& img_) {
+  return writeImageData(img_.id(), img_.byteArray());
+}
+
+bool ImageDirectory::writeImageData(const QString& id_, const QByteArray& data_) {
   const QString path = this->path(); // virtual function, so don't assume m_path is correct
   if(!m_pathExists) {
     if(path.isEmpty()) {
@@ -101,7 +113,7 @@ bool ImageDirectory::writeImage(const Data::Image& img_) {
         m_dir = new QTemporaryDir(); // default is to auto-delete, aka autoRemove()
         ImageDirectory::setPath(m_dir->path());
       }
-      return writeImage(img_);
+      return writeImageData(id_, data_);
     }
     QDir dir(path);
     if(dir.mkdir(path)) {
@@ -112,8 +124,8 @@ bool ImageDirectory::writeImage(const Data::Image& img_) {
     m_pathExists = true;
   }
   QUrl target = QUrl::fromLocalFile(path);
-  target.setPath(target.path() + img_.id());
-  return FileHandler::writeDataURL(target, img_.byteArray(), true /* force */);
+  target.setPath(target.path() + id_);
+  return FileHandler::writeDataURL(target, data_, true /* force */);
 }
 
 bool ImageDirectory::removeImage(const QString& id_) {
@@ -209,3 +221,15 @@ Tellico::Data::Image* ImageZipArchive::imageById(const QString& id_) {
   }
   return img;
 }
+
+QByteArray ImageZipArchive::imageData(const QString& id_) {
+  // unlike imageById(), the image is still available afterwards
+  if(!hasImage(id_)) {
+    return QByteArray();
+  }
+  const KArchiveEntry* file = m_imgDir->entry(id_);
+  if(!file || !file->isFile()) {
+    return QByteArray();
+  }
+  return static_cast<const KArchiveFile*>(file)->data();
+}
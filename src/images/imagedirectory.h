@@ -28,6 +28,7 @@
 #include "../utils/stringset.h"
 
 #include <QString>
+#include <QByteArray>
 
 class QTemporaryDir;
 
@@ -46,6 +47,8 @@ public:
 
   virtual bool hasImage(const QString& id) = 0;
   virtual Data::Image* imageById(const QString& id) = 0;
+  // returns the encoded image data, without decoding the image
+  virtual QByteArray imageData(const QString& id) = 0;
 
 private:
   Q_DISABLE_COPY(ImageStorage)
@@ -62,7 +65,9 @@ public:
 
   bool hasImage(const QString& id) Q_DECL_OVERRIDE;
   Data::Image* imageById(const QString& id) Q_DECL_OVERRIDE;
+  QByteArray imageData(const QString& id) Q_DECL_OVERRIDE;
   bool writeImage(const Data::Image& image);
+  bool writeImageData(const QString& id, const QByteArray& data);
   bool removeImage(const QString& id);
 
 private:
@@ -97,6 +102,7 @@ public:
 
   bool hasImage(const QString& id) Q_DECL_OVERRIDE;
   Data::Image* imageById(const QString& id) Q_DECL_OVERRIDE;
+  QByteArray imageData(const QString& id) Q_DECL_OVERRIDE;
 
 private:
   Q_DISABLE_COPY(ImageZipArchive)
@@ -37,21 +37,29 @@
 #include <QCache>
 #include <QFileInfo>
 #include <QDir>
+#include <QThread>
 
 #define RELEASE_IMAGES
 
 using Tellico::ImageFactory;
 
+namespace {
+  // limits on the number of background image downloads running at once
+  static const int MAX_IMAGE_REQUESTS = 6;
+  static const int MAX_IMAGE_REQUESTS_PER_HOST = 2;
+}
+
 // this image info map is primarily for big images that don't fit
 // in the cache, so that don't have to be continually reloaded to get info
 QHash<QString, Tellico::Data::ImageInfo> ImageFactory::s_imageInfoMap;
+QReadWriteLock ImageFactory::s_imageInfoLock;
 Tellico::StringSet ImageFactory::s_imagesToRelease;
 
 Tellico::ImageFactory* ImageFactory::factory = nullptr;
 
 class ImageFactory::Private {
 public:
-  Private() {}
+  Private() : deferRequests(false) {}
 
   QHash<QString, Data::Image*> imageDict;
   QCache<QString, Data::Image> imageCache;
@@ -61,6 +69,20 @@ public:
   TemporaryImageDirectory tempImageDir; // kept in tmp directory
   ImageZipArchive imageZipArchive;
   StringSet nullImages;
+
+  struct ImageRequest {
+    QUrl url;
+    QUrl referrer;
+    bool quiet;
+  };
+  // background image downloads, keyed by the url
+  QList<ImageRequest> queuedRequests;
+  StringSet queuedRequestUrls;
+  QHash<QString, ImageJob*> runningRequests;
+  QHash<QString, int> hostRequestCount;
+  QHash<QString, QString> requestedImageIds;
+  StringSet failedRequestUrls;
+  bool deferRequests;
 };
 
 ImageFactory::ImageFactory() : QObject(), d(new Private()) {
@@ -120,6 +142,9 @@ Tellico::ImageFactory::CacheDir ImageFactory::cacheDir() {
 
 QString ImageFactory::addImage(const QUrl& url_, bool quiet_, const QUrl& refer_, bool link_) {
   Q_ASSERT(factory && "ImageFactory is not initialized!");
+  if(factory->d->deferRequests && !link_) {
+    return requestImage(url_, quiet_, refer_);
+  }
   return factory->addImageImpl(url_, quiet_, refer_, link_).id();
 }
 
@@ -127,6 +152,17 @@ const Tellico::Data::Image& ImageFactory::addImageImpl(const QUrl& url_, bool qu
   if(url_.isEmpty() || !url_.isValid() || d->nullImages.contains(url_.url())) {
     return Data::Image::null;
   }
+  if(!link_) {
+    // reuse an image already downloaded in the background. A request which is still
+    // pending is left alone, since something is waiting for it to finish
+    const QString id = d->requestedImageIds.value(url_.url());
+    if(!id.isEmpty()) {
+      const Data::Image& img = imageById(id);
+      if(!img.isNull()) {
+        return img;
+      }
+    }
+  }
   ImageJob* job = new ImageJob(url_, QString(), quiet_);
   job->setLinkOnly(link_);
   job->setReferrer(refer_);
@@ -147,7 +183,7 @@ const Tellico::Data::Image& ImageFactory::addImageImpl(const QUrl& url_, bool qu
   // hold the image in memory since it probably isn't written locally to disk yet
   if(!d->imageDict.contains(img.id())) {
     d->imageDict.insert(img.id(), new Data::Image(img));
-    s_imageInfoMap.insert(img.id(), Data::ImageInfo(img));
+    cacheImageInfo(Data::ImageInfo(img));
   }
   return img;
 }
@@ -176,7 +212,7 @@ const Tellico::Data::Image& ImageFactory::addImageImpl(const QImage& image_, con
     return Data::Image::null;
   }
   d->imageDict.insert(img->id(), img);
-  s_imageInfoMap.insert(img->id(), Data::ImageInfo(*img));
+  cacheImageInfo(Data::ImageInfo(*img));
   return *img;
 }
 
@@ -215,7 +251,7 @@ const Tellico::Data::Image& ImageFactory::addImageImpl(const QByteArray& data_,
 //          << ", id = "<< img->id();
 
   d->imageDict.insert(img->id(), img);
-  s_imageInfoMap.insert(img->id(), Data::ImageInfo(*img));
+  cacheImageInfo(Data::ImageInfo(*img));
   return *img;
 }
 
@@ -240,8 +276,12 @@ const Tellico::Data::Image& ImageFactory::addCachedImageImpl(const QString& id_,
     myWarning() << "image not found:" << id_;
     return Data::Image::null;
   }
+  // the encoded data can be read from the directory again, only the zip archive has to keep it
+  if(dir_ != ZipArchive) {
+    img->releaseEncodedData();
+  }
 
-  s_imageInfoMap.insert(img->id(), Data::ImageInfo(*img));
+  cacheImageInfo(Data::ImageInfo(*img));
 
   // if byteCount() is greater than maxCost, then trying and failing to insert it would
   // mean the image gets deleted
@@ -265,6 +305,76 @@ const Tellico::Data::Image& ImageFactory::addCachedImageImpl(const QString& id_,
   return *img;
 }
 
+QString ImageFactory::requestImage(const QUrl& url_, bool quiet_, const QUrl& refer_) {
+  if(!factory || url_.isEmpty() || !url_.isValid()) {
+    return QString();
+  }
+  const QString u = url_.url();
+  if(factory->d->nullImages.contains(u) || factory->d->failedRequestUrls.has(u)) {
+    return QString();
+  }
+  const QString id = factory->d->requestedImageIds.value(u);
+  if(!id.isEmpty()) {
+    return id;
+  }
+  if(!isImageRequestPending(url_)) {
+    Private::ImageRequest request;
+    request.url = url_;
+    request.referrer = refer_;
+    request.quiet = quiet_;
+    factory->d->queuedRequests.append(request);
+    factory->d->queuedRequestUrls.add(u);
+    factory->startImageRequests();
+  }
+  return u;
+}
+
+QString ImageFactory::requestedImageId(const QString& placeholder_) {
+  if(!factory || placeholder_.isEmpty()) {
+    return placeholder_;
+  }
+  QHash<QString, QString>::ConstIterator it = factory->d->requestedImageIds.constFind(placeholder_);
+  if(it != factory->d->requestedImageIds.constEnd()) {
+    return it.value();
+  }
+  return factory->d->failedRequestUrls.has(placeholder_) ? QString() : placeholder_;
+}
+
+void ImageFactory::setDeferImageRequests(bool defer_) {
+  Q_ASSERT(factory && "ImageFactory is not initialized!");
+  factory->d->deferRequests = defer_;
+}
+
+bool ImageFactory::isImageRequestPending(const QUrl& url_) {
+  if(!factory) {
+    return false;
+  }
+  const QString u = url_.url();
+  return factory->d->queuedRequestUrls.has(u) || factory->d->runningRequests.contains(u);
+}
+
+void ImageFactory::startImageRequests() {
+  int i = 0;
+  while(i < d->queuedRequests.count() && d->runningRequests.count() < MAX_IMAGE_REQUESTS) {
+    const Private::ImageRequest request = d->queuedRequests.at(i);
+    const QString host = request.url.host();
+    if(d->hostRequestCount.value(host) >= MAX_IMAGE_REQUESTS_PER_HOST) {
+      ++i;
+      continue;
+    }
+    d->queuedRequests.removeAt(i);
+    const QString u = request.url.url();
+    d->queuedRequestUrls.remove(u);
+
+    ImageJob* job = new ImageJob(request.url, QString() /* id, use calculated one */, request.quiet);
+    job->setReferrer(request.referrer);
+    connect(job, &ImageJob::result,
+            this, &ImageFactory::slotImageRequestResult);
+    d->runningRequests.insert(u, job);
+    ++d->hostRequestCount[host];
+  }
+}
+
 bool ImageFactory::writeCachedImage(const QString& id_, CacheDir dir_, bool force_ /*=false*/) {
   if(id_.isEmpty()) {
     return false;
@@ -282,8 +392,11 @@ bool ImageFactory::writeCachedImage(const QString& id_, CacheDir dir_, bool forc
     if(factory->d->imageDict.contains(id_)) {
       Data::Image* img = factory->d->imageDict.take(id_);
       Q_ASSERT(img);
+      // the file has the encoded data now
+      img->releaseEncodedData();
       // imageCache.insert will delete the image by itself if the cost exceeds the cache size
       if(factory->d->imageCache.insert(img->id(), img, img->byteCount())) {
+        QWriteLocker locker(&s_imageInfoLock);
         s_imageInfoMap.remove(id_);
       }
     }
@@ -300,15 +413,58 @@ bool ImageFactory::writeCachedImage(const QString& id_, ImageDirectory* imgDir_,
   // only write if it doesn't exist
   bool success = (!force_ && exists);
   if(!success) {
-    const Data::Image& img = imageById(id_);
-    if(!img.isNull()) {
+    // copy the encoded data rather than decoding the image just to write it again
+    const QByteArray data = imageData(id_);
+    if(!data.isEmpty()) {
 //      myLog() << "writing image";
-      success = imgDir_->writeImage(img);
+      success = imgDir_->writeImageData(id_, data);
     }
   }
   return success;
 }
 
+QByteArray ImageFactory::imageData(const QString& id_) {
+  Q_ASSERT(factory && "ImageFactory is not initialized!");
+  if(id_.isEmpty() || !factory || factory->d->nullImages.contains(id_)) {
+    return QByteArray();
+  }
+
+  const Data::Image* img = factory->d->imageCache.object(id_);
+  if(!img) {
+    img = factory->d->imageDict.value(id_);
+  }
+  if(img && img->hasEncodedData()) {
+    return img->byteArray();
+  }
+
+  // linked images have to be loaded from the url
+  const bool linkOnly = isLinkOnly(id_);
+  if(!linkOnly) {
+    QList<ImageStorage*> storages;
+    storages << &factory->d->tempImageDir
+             << &factory->d->imageZipArchive
+             << &factory->d->dataImageDir
+             << &factory->d->localImageDir;
+    foreach(ImageStorage* storage, storages) {
+      if(storage->hasImage(id_)) {
+        const QByteArray data = storage->imageData(id_);
+        if(!data.isEmpty()) {
+          return data;
+        }
+      }
+    }
+  }
+
+  // the image is still in memory, but the encoded data was released
+  if(img) {
+    return img->byteArray();
+  }
+
+  // fall back to loading the image, which handles all the other possible locations
+  const Data::Image& img2 = imageById(id_);
+  return img2.isNull() ? QByteArray() : img2.byteArray();
+}
+
 const Tellico::Data::Image& ImageFactory::imageById(const QString& id_) {
   Q_ASSERT(factory && "ImageFactory is not initialized!");
   if(id_.isEmpty() || !factory || factory->d->nullImages.contains(id_)) {
@@ -335,12 +491,17 @@ const Tellico::Data::Image& ImageFactory::imageById(const QString& id_) {
     return *img;
   }
 
+  // a placeholder for an image being downloaded in the background, don't load it here
+  if(factory->d->queuedRequestUrls.has(id_) || factory->d->runningRequests.contains(id_)) {
+    return Data::Image::null;
+  }
+
   // if the image is link only, we need to load it
   // but can't call imageInfo() since that might recurse into imageById()
   // also, the image info cache might not have it so check if the
   // id is a valid absolute url
   // yeah, it's probably slow
-  if((s_imageInfoMap.contains(id_) && s_imageInfoMap[id_].linkOnly) || !QUrl(id_).isRelative()) {
+  if(isLinkOnly(id_) || !QUrl(id_).isRelative()) {
     QUrl u(id_);
     if(u.isValid()) {
       return factory->addImageImpl(u, true, QUrl(), true);
@@ -481,7 +642,7 @@ void ImageFactory::requestImageById(const QString& id_) {
   const QUrl u(id_);
   // what does it mean when the Id is an absolute Url and yet the image is not link only?
   // Probably a heritage image id before the bugs were fixed.
-  const bool linkOnly = (s_imageInfoMap.contains(id_) && s_imageInfoMap[id_].linkOnly);
+  const bool linkOnly = isLinkOnly(id_);
   if(linkOnly || !u.isRelative()) {
     if(u.isValid()) {
       factory->requestImageByUrlImpl(u, true /* quiet */, QUrl() /* referrer */, linkOnly);
@@ -501,10 +662,18 @@ void ImageFactory::requestImageByUrlImpl(const QUrl& url_, bool quiet_, const QU
 }
 
 Tellico::Data::ImageInfo ImageFactory::imageInfo(const QString& id_) {
-  if(s_imageInfoMap.contains(id_)) {
-    return s_imageInfoMap[id_];
+  {
+    QReadLocker locker(&s_imageInfoLock);
+    QHash<QString, Data::ImageInfo>::ConstIterator it = s_imageInfoMap.constFind(id_);
+    if(it != s_imageInfoMap.constEnd()) {
+      return it.value();
+    }
   }
 
+  // images are only loaded on the main thread
+  if(!factory || QThread::currentThread() != factory->thread()) {
+    return Data::ImageInfo();
+  }
   const Data::Image& img = imageById(id_);
   if(img.isNull()) {
     return Data::ImageInfo();
@@ -513,16 +682,23 @@ Tellico::Data::ImageInfo ImageFactory::imageInfo(const QString& id_) {
 }
 
 void ImageFactory::cacheImageInfo(const Tellico::Data::ImageInfo& info) {
+  QWriteLocker locker(&s_imageInfoLock);
   s_imageInfoMap.insert(info.id, info);
 }
 
 bool ImageFactory::hasImageInfo(const QString& id_) {
+  QReadLocker locker(&s_imageInfoLock);
   return s_imageInfoMap.contains(id_);
 }
 
+bool ImageFactory::isLinkOnly(const QString& id_) {
+  QReadLocker locker(&s_imageInfoLock);
+  QHash<QString, Data::ImageInfo>::ConstIterator it = s_imageInfoMap.constFind(id_);
+  return it != s_imageInfoMap.constEnd() && it.value().linkOnly;
+}
+
 bool ImageFactory::validImage(const QString& id_) {
-  // don't try s_imageInfoMap[id_] cause it inserts an empty image info
-  return s_imageInfoMap.contains(id_) || factory->hasImageInMemory(id_) || !imageById(id_).isNull();
+  return hasImageInfo(id_) || factory->hasImageInMemory(id_) || !imageById(id_).isNull();
 }
 
 QPixmap ImageFactory::pixmap(const QString& id_, int width_, int height_) {
@@ -565,9 +741,14 @@ void ImageFactory::clean(bool purgeTempDirectory_) {
   s_imagesToRelease.clear();
   qDeleteAll(factory->d->imageDict);
   factory->d->imageDict.clear();
-  s_imageInfoMap.clear();
+  {
+    QWriteLocker locker(&s_imageInfoLock);
+    s_imageInfoMap.clear();
+  }
   factory->d->imageCache.clear();
   factory->d->pixmapCache.clear();
+  factory->d->requestedImageIds.clear();
+  factory->d->failedRequestUrls.clear();
   if(purgeTempDirectory_) {
     factory->d->tempImageDir.purge();
     // just to make sure all the image locations clean themselves up
@@ -730,9 +911,42 @@ void ImageFactory::slotImageJobResult(KJob* job_) {
   // hold the image in memory since it probably isn't written locally to disk yet
   if(!d->imageDict.contains(img.id())) {
     d->imageDict.insert(img.id(), new Data::Image(img));
-    s_imageInfoMap.insert(img.id(), Data::ImageInfo(img));
+    cacheImageInfo(Data::ImageInfo(img));
   }
   emit factory->imageAvailable(img.id());
 }
 
+void ImageFactory::slotImageRequestResult(KJob* job_) {
+  ImageJob* imageJob = qobject_cast<ImageJob*>(job_);
+  Q_ASSERT(imageJob);
+  if(!imageJob) {
+    myWarning() << "No image job";
+    return;
+  }
+  const QString u = imageJob->url().url();
+  d->runningRequests.remove(u);
+  const QString host = imageJob->url().host();
+  if(--d->hostRequestCount[host] < 1) {
+    d->hostRequestCount.remove(host);
+  }
+
+  QString id;
+  const Data::Image& img = imageJob->image();
+  if(img.isNull()) {
+    // the url is not added to the null images since a synchronous request
+    // might still succeed, with a different referrer for example
+    d->failedRequestUrls.add(u);
+  } else {
+    id = img.id();
+    if(!d->imageDict.contains(id)) {
+      d->imageDict.insert(id, new Data::Image(img));
+      cacheImageInfo(Data::ImageInfo(img));
+    }
+    d->requestedImageIds.insert(u, id);
+    emit imageAvailable(id);
+  }
+  emit imageRequestFinished(u, id);
+  startImageRequests();
+}
+
 #undef RELEASE_IMAGES
@@ -32,6 +32,7 @@
 #include <QColor>
 #include <QHash>
 #include <QPixmap>
+#include <QReadWriteLock>
 
 class KZip;
 class KJob;
@@ -55,6 +56,15 @@ public:
 };
 
 /**
+ * The ImageFactory loads, caches, and writes the images for the collection.
+ *
+ * Images are only loaded on the main thread, since the caches hand out references to
+ * images which might be deleted when the cache is full. The image info cache is the
+ * exception: @ref imageInfo, @ref hasImageInfo, and @ref cacheImageInfo may be called
+ * from any thread. Off the main thread, imageInfo() only returns the info which is
+ * already cached, and the width and height of the info should be read without loading
+ * the image.
+ *
  * @author Robby Stephenson
  */
 class ImageFactory : public QObject {
@@ -90,7 +100,8 @@ public:
    *
    * @param url The URL of the image, anything KIO can handle
    * @param quiet If any error should not be reported.
-   * @return The image id, empty if null
+   * @return The image id, empty if null. While image requests are deferred, the
+   *         placeholder from @ref requestImage is returned instead.
    */
   static QString addImage(const QUrl& url, bool quiet=false,
                           const QUrl& referrer = QUrl(), bool linkOnly=false);
@@ -118,6 +129,26 @@ public:
    */
   static QString addImage(const QByteArray& data, const QString& format, const QString& id);
 
+  /**
+   * Requests an image to be downloaded in the background. Only a few images are downloaded
+   * at once, and fewer from any single host. If the image is already available, its id is
+   * returned. Otherwise, the url is returned as a placeholder until
+   * imageRequestFinished() is emitted. An empty string means the image can't be loaded.
+   */
+  static QString requestImage(const QUrl& url, bool quiet=false, const QUrl& referrer = QUrl());
+  static bool isImageRequestPending(const QUrl& url);
+  /**
+   * Returns the image id for a placeholder returned by @ref requestImage, once the request
+   * has finished. The placeholder itself is returned while the request is pending, or if
+   * it was never requested. An empty string means the image could not be loaded.
+   */
+  static QString requestedImageId(const QString& placeholder);
+  /**
+   * While deferred, adding an image from a url only requests it in the background, and
+   * returns the placeholder. Used when fetching entries which the user is waiting to see.
+   */
+  static void setDeferImageRequests(bool defer);
+
   static bool writeCachedImage(const QString& id, CacheDir dir, bool force = false);
   static bool writeCachedImage(const QString& id, ImageDirectory* dir, bool force = false);
 
@@ -129,6 +160,11 @@ public:
    * @return The image reference
    */
   static const Data::Image& imageById(const QString& id);
+  /**
+   * Returns the encoded data for an image, reading it straight from where the image
+   * is stored so that the image does not get decoded, if possible.
+   */
+  static QByteArray imageData(const QString& id);
   static bool hasLocalImage(const QString& id);
   bool hasImageInMemory(const QString& id) const;
   // just used for testing
@@ -170,10 +206,13 @@ public:
 
 Q_SIGNALS:
   void imageAvailable(const QString& id);
+  // id is empty if the image could not be loaded
+  void imageRequestFinished(const QString& url, const QString& id);
   void imageLocationMismatch();
 
 private Q_SLOTS:
   void slotImageJobResult(KJob* job);
+  void slotImageRequestResult(KJob* job);
 
 private:
   /**
@@ -211,10 +250,15 @@ private:
   const Data::Image& addImageImpl(const QByteArray& data, const QString& format, const QString& id);
 
   const Data::Image& addCachedImageImpl(const QString& id, CacheDir dir);
+  void startImageRequests();
 
   static ImageFactory* factory;
 
+  static bool isLinkOnly(const QString& id);
+
   static QHash<QString, Data::ImageInfo> s_imageInfoMap;
+  // guards the image info map, which background threads may read
+  static QReadWriteLock s_imageInfoLock;
   static StringSet s_imagesToRelease;
 
   ImageFactory();
@@ -71,6 +71,7 @@
 #include "gui/statusbar.h"
 #include "gui/tabwidget.h"
 #include "gui/dockwidget.h"
+#include "gui/tracestatswidget.h"
 #include "utils/cursorsaver.h"
 #include "utils/guiproxy.h"
 #include "tellico_debug.h"
@@ -226,6 +227,8 @@ void MainWindow::slotInit() {
   initConnections();
   connect(ImageFactory::self(), &ImageFactory::imageLocationMismatch,
           this, &MainWindow::slotImageLocationMismatch);
+  connect(ImageFactory::self(), &ImageFactory::imageRequestFinished,
+          Controller::self(), &Controller::slotImageRequestFinished);
   // Init DBUS
   NewStuff::Manager::self();
 }
@@ -562,6 +565,12 @@ void MainWindow::initActions() {
   m_mergeEntry->setToolTip(i18n("Merge the selected entries"));
   m_mergeEntry->setEnabled(false); // gets enabled when more than 1 entry is selected
 
+  action = actionCollection()->addAction(QStringLiteral("coll_find_duplicates"),
+                                         Controller::self(), SLOT(slotFindDuplicates()));
+  action->setText(i18n("&Find Duplicate Entries"));
+  action->setIcon(QIcon::fromTheme(QStringLiteral("edit-find")));
+  action->setToolTip(i18n("Select the duplicate entries in the collection"));
+
   m_checkOutEntry = actionCollection()->addAction(QStringLiteral("coll_checkout"), Controller::self(), SLOT(slotCheckOut()));
   m_checkOutEntry->setText(i18n("Check-&out..."));
   m_checkOutEntry->setIcon(QIcon::fromTheme(QStringLiteral("arrow-up-double")));
@@ -742,6 +751,7 @@ void MainWindow::initDocument() {
 
   connect(Kernel::self()->commandHistory(), &QUndoStack::cleanChanged,
           doc, &Data::Document::slotSetClean);
+  doc->setCommandHistory(Kernel::self()->commandHistory());
 }
 
 void MainWindow::initView() {
@@ -802,6 +812,14 @@ void MainWindow::initView() {
   addDockWidget(Qt::LeftDockWidgetArea, m_groupViewDock);
   actionCollection()->addAction(QStringLiteral("toggle_group_widget"), m_groupViewDock->toggleViewAction());
 
+  // the performance statistics are only of interest when looking for something slow
+  m_traceDock = new GUI::DockWidget(i18n("Performance Statistics"), this);
+  m_traceDock->setObjectName(QStringLiteral("trace_dock"));
+  m_traceDock->setWidget(new GUI::TraceStatsWidget(m_traceDock));
+  addDockWidget(Qt::BottomDockWidgetArea, m_traceDock);
+  m_traceDock->hide();
+  actionCollection()->addAction(QStringLiteral("toggle_trace_widget"), m_traceDock->toggleViewAction());
+
   EntrySelectionModel* proxySelect = new EntrySelectionModel(m_iconView->model(),
                                                              m_detailedView->selectionModel(),
                                                              this);
@@ -1539,8 +1557,20 @@ void MainWindow::slotHandleConfigChange() {
     nocaps != Config::noCapitalizationList() ||
     suffixes != Config::nameSuffixList() ||
     prefixes != Config::surnamePrefixList()) {
-    // invalidate all groups
-    Data::Document::self()->collection()->invalidateGroups();
+    // invalidate the groups of any field which gets formatted
+    Data::CollPtr coll = Data::Document::self()->collection();
+    QStringList formattedFields;
+    foreach(Data::FieldPtr field, coll->fields()) {
+      if(field->formatType() != FieldFormat::FormatNone) {
+        formattedFields << field->name();
+      }
+    }
+    if(!coll->peopleFields().isEmpty()) {
+      formattedFields << Data::Collection::s_peopleGroupName;
+    }
+    if(!formattedFields.isEmpty()) {
+      coll->invalidateGroups(formattedFields);
+    }
     // refreshing the title causes the group view to refresh
     Controller::self()->slotRefreshField(Data::Document::self()->collection()->fieldByName(QStringLiteral("title")));
   }
@@ -2372,6 +2402,7 @@ void MainWindow::slotToggleMenuBarVisibility() {
 void MainWindow::slotToggleLayoutLock(bool lock_) {
   m_groupViewDock->setLocked(lock_);
   m_collectionViewDock->setLocked(lock_);
+  m_traceDock->setLocked(lock_);
 }
 
 void MainWindow::slotResetLayout() {
@@ -2382,6 +2413,10 @@ void MainWindow::slotResetLayout() {
   m_dummyWindow->removeDockWidget(m_collectionViewDock);
   m_dummyWindow->addDockWidget(Qt::TopDockWidgetArea, m_collectionViewDock);
   m_collectionViewDock->show();
+
+  removeDockWidget(m_traceDock);
+  addDockWidget(Qt::BottomDockWidgetArea, m_traceDock);
+  m_traceDock->hide();
 }
 
 void MainWindow::guiFactoryReset() {
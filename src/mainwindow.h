@@ -489,6 +489,7 @@ private:
   QMainWindow* m_dummyWindow;
   GUI::DockWidget* m_groupViewDock;
   GUI::DockWidget* m_collectionViewDock;
+  GUI::DockWidget* m_traceDock;
 
   Tellico::StatusBar* m_statusBar;
 
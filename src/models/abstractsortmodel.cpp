@@ -23,6 +23,7 @@
  ***************************************************************************/
 
 #include "abstractsortmodel.h"
+#include "../utils/tracer.h"
 
 using Tellico::AbstractSortModel;
 
@@ -74,5 +75,6 @@ void AbstractSortModel::sort(int col_, Qt::SortOrder order_) {
     m_sortColumn = col_;
   }
   m_sortOrder = order_;
+  TRACE_SCOPE("model", "sort");
   QSortFilterProxyModel::sort(col_, order_);
 }
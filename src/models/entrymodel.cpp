@@ -117,6 +117,11 @@ QVariant EntryModel::data(const QModelIndex& index_, int role_) const {
       if(!entry) {
         return QVariant();
       }
+      // the view asks for the rest of the column soon enough, so format it all in one pass
+      if(!m_formattedColumns.contains(field->name())) {
+        Data::Entry::formatFieldColumn(m_entries, field);
+        m_formattedColumns.insert(field->name());
+      }
       value = entry->formattedField(field);
       return value.isEmpty() ? QVariant() : value;
 
@@ -259,6 +264,7 @@ void EntryModel::clear() {
   m_entries.clear();
   m_fields.clear();
   m_saveStates.clear();
+  m_formattedColumns.clear();
   endResetModel();
 }
 
@@ -286,16 +292,19 @@ void EntryModel::setEntries(const Tellico::Data::EntryList& entries_) {
   Q_ASSERT(!m_fields.isEmpty() || entries_.isEmpty());
   beginResetModel();
   m_entries = entries_;
+  m_formattedColumns.clear();
   endResetModel();
 }
 
 void EntryModel::addEntries(const Tellico::Data::EntryList& entries_) {
   beginInsertRows(QModelIndex(), m_entries.count(), m_entries.count() + entries_.count() - 1);
   m_entries += entries_;
+  m_formattedColumns.clear();
   endInsertRows();
 }
 
 void EntryModel::modifyEntries(const Tellico::Data::EntryList& entries_) {
+  m_formattedColumns.clear();
   foreach(Data::EntryPtr entry, entries_) {
     QModelIndex index = indexFromEntry(entry);
     if(index.isValid()) {
@@ -353,6 +362,7 @@ void EntryModel::modifyField(Data::FieldPtr oldField_, Data::FieldPtr newField_)
   for(int i = 0; i < m_fields.count(); ++i) {
     if(m_fields.at(i)->name() == oldField_->name()) {
       m_fields.replace(i, newField_);
+      m_formattedColumns.remove(newField_->name());
       emit headerDataChanged(Qt::Horizontal, i, i);
       break;
     }
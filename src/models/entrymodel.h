@@ -31,6 +31,7 @@
 #include <QIcon>
 #include <QAbstractItemModel>
 #include <QMultiHash>
+#include <QSet>
 
 namespace Tellico {
 
@@ -85,6 +86,8 @@ private:
 
   // maps ids of requested images into entries
   mutable QMultiHash<QString, Data::EntryPtr> m_requestedImages;
+  // names of the fields whose values have been formatted for all the entries at once
+  mutable QSet<QString> m_formattedColumns;
 };
 
 } // end namespace
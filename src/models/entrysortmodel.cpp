@@ -27,6 +27,7 @@
 #include "fieldcomparison.h"
 #include "../field.h"
 #include "../entry.h"
+#include "../utils/tracer.h"
 
 using Tellico::EntrySortModel;
 
@@ -39,6 +40,7 @@ EntrySortModel::EntrySortModel(QObject* parent) : AbstractSortModel(parent) {
 void EntrySortModel::setFilter(Tellico::FilterPtr filter_) {
   if(m_filter != filter_ || (m_filter && *m_filter != *filter_)) {
     m_filter = filter_;
+    TRACE_SCOPE("model", "filter");
     invalidateFilter();
   }
 }
@@ -33,6 +33,22 @@
 
 #include <QDateTime>
 
+#include <algorithm>
+
+class Tellico::FieldComparison::ValueLessThan {
+public:
+  ValueLessThan(FieldComparison* comp_, const QStringList& values_) : m_comp(comp_), m_values(values_) {}
+  bool operator()(int id1_, int id2_) const {
+    const int res = m_comp->compare(m_values.at(id1_), m_values.at(id2_));
+    // equal values are ordered by index, so the order is total and doesn't depend on the sort algorithm
+    return res < 0 || (res == 0 && id1_ < id2_);
+  }
+
+private:
+  FieldComparison* m_comp;
+  const QStringList& m_values;
+};
+
 Tellico::FieldComparison* Tellico::FieldComparison::create(Data::FieldPtr field_) {
   if(!field_) {
     myWarning() << "No field for creating a field comparison";
@@ -47,12 +63,50 @@ Tellico::FieldComparison* Tellico::FieldComparison::create(Data::FieldPtr field_
 }
 
 Tellico::FieldComparison::FieldComparison(Data::FieldPtr field_) : m_field(field_) {
+  if(m_field) {
+    m_fieldNames << m_field->name();
+  }
 }
 
 int Tellico::FieldComparison::compare(Data::EntryPtr entry1_, Data::EntryPtr entry2_) {
+  Data::CollPtr coll = entry1_->collection();
+  if(coll && coll == entry2_->collection()) {
+    Data::CollectionSnapshot::Ptr snapshot = coll->snapshot(m_fieldNames);
+    Data::CollectionSnapshot::ColumnPtr column = snapshot->column(m_field->name());
+    const int row1 = snapshot->row(entry1_->id());
+    const int row2 = snapshot->row(entry2_->id());
+    // an entry copy has the same id, but is not the entry in the snapshot
+    if(column && row1 > -1 && row2 > -1 &&
+       snapshot->entry(row1) == entry1_ && snapshot->entry(row2) == entry2_) {
+      if(column != m_rankedColumn) {
+        rankValues(column);
+      }
+      return m_ranks.at(column->valueId(row1)) - m_ranks.at(column->valueId(row2));
+    }
+  }
   return compare(entry1_->formattedField(m_field), entry2_->formattedField(m_field));
 }
 
+void Tellico::FieldComparison::rankValues(Data::CollectionSnapshot::ColumnPtr column_) {
+  const QStringList& values = column_->values();
+  QVector<int> order(values.count());
+  for(int i = 0; i < order.count(); ++i) {
+    order[i] = i;
+  }
+  // std::sort, like std::stable_sort, needs compare() to be consistent, equal values only get the same rank below
+  std::sort(order.begin(), order.end(), ValueLessThan(this, values));
+
+  m_ranks.resize(values.count());
+  int rank = 0;
+  for(int i = 0; i < order.count(); ++i) {
+    if(i > 0 && compare(values.at(order.at(i-1)), values.at(order.at(i))) != 0) {
+      ++rank;
+    }
+    m_ranks[order.at(i)] = rank;
+  }
+  m_rankedColumn = column_;
+}
+
 Tellico::ValueComparison::ValueComparison(Data::FieldPtr field, StringComparison* comp)
     : FieldComparison(field)
     , m_stringComparison(comp) {
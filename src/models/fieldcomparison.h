@@ -26,8 +26,10 @@
 #define TELLICO_FIELDCOMPARISON_H
 
 #include "../datavectors.h"
+#include "../collectionsnapshot.h"
 
 #include <QStringList>
+#include <QVector>
 
 namespace Tellico {
 
@@ -40,6 +42,11 @@ public:
 
   Data::FieldPtr field() const { return m_field; }
 
+  /**
+   * Compares the formatted values of two entries. When both entries are in the same
+   * collection, the distinct values in the collection snapshot are ranked once, and
+   * each comparison after that only compares two ranks.
+   */
   virtual int compare(Data::EntryPtr entry1, Data::EntryPtr entry2);
 
   static FieldComparison* create(Data::FieldPtr field);
@@ -49,7 +56,15 @@ protected:
 
 private:
   Q_DISABLE_COPY(FieldComparison)
+  class ValueLessThan;
+
+  void rankValues(Data::CollectionSnapshot::ColumnPtr column);
+
   Data::FieldPtr m_field;
+  QStringList m_fieldNames;
+  // the rank of each value id in the column, equal values share a rank
+  Data::CollectionSnapshot::ColumnPtr m_rankedColumn;
+  QVector<int> m_ranks;
 };
 
 class ValueComparison : public FieldComparison {
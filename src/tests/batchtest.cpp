@@ -0,0 +1,104 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#undef QT_NO_CAST_FROM_ASCII
+
+#include "batchtest.h"
+#include "../batchrunner.h"
+#include "../document.h"
+#include "../collection.h"
+#include "../images/imagefactory.h"
+#include "../utils/datafileregistry.h"
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFile>
+
+QTEST_GUILESS_MAIN( BatchTest )
+
+void BatchTest::initTestCase() {
+  // since we use the bibtex mapping file
+  Tellico::DataFileRegistry::self()->addDataLocation(QFINDTESTDATA("../translators/bibtex-translation.xml"));
+  Tellico::ImageFactory::init();
+}
+
+void BatchTest::cleanupTestCase() {
+  Tellico::ImageFactory::clean(true);
+}
+
+void BatchTest::testCommands() {
+  Tellico::BatchRunner runner;
+  QVERIFY(runner.setCommands(QStringList()));
+  QVERIFY(runner.setCommands(QStringList() << "open" << "file.tc" << "export" << "csv" << "file.csv"));
+  QVERIFY(runner.setCommands(QStringList() << "FILTER" << "title" << "contains" << "text"));
+
+  QVERIFY(!runner.setCommands(QStringList() << "print" << "file.tc"));
+  QVERIFY(!runner.errorString().isEmpty());
+  // missing the file name
+  QVERIFY(!runner.setCommands(QStringList() << "open" << "file.tc" << "export" << "csv"));
+
+  QVERIFY(runner.setCommands(QStringList() << "export" << "pdf" << "file.pdf"));
+  QVERIFY(!runner.run());
+}
+
+void BatchTest::testPipeline() {
+  const QString bibFile = QFINDTESTDATA("data/test.bib");
+
+  Tellico::BatchRunner runner;
+  QVERIFY(runner.setCommands(QStringList() << "import" << "bibtex" << bibFile));
+  QVERIFY(runner.run());
+
+  Tellico::Data::CollPtr coll = Tellico::Data::Document::self()->collection();
+  QVERIFY(coll);
+  QCOMPARE(coll->type(), Tellico::Data::Collection::Bibtex);
+  int articleCount = 0;
+  foreach(Tellico::Data::EntryPtr entry, coll->entries()) {
+    if(entry->field("entry-type") == QLatin1String("article")) {
+      ++articleCount;
+    }
+  }
+  QVERIFY(articleCount > 0);
+  QVERIFY(articleCount < coll->entryCount());
+
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+  const QString csvFile = tempDir.path() + "/articles.csv";
+  const QString tcFile = tempDir.path() + "/articles.tc";
+
+  QVERIFY(runner.setCommands(QStringList() << "filter" << "entry-type" << "equals" << "article"
+                                           << "export" << "csv" << csvFile
+                                           << "save" << tcFile));
+  QVERIFY(runner.run());
+  QCOMPARE(Tellico::Data::Document::self()->collection()->entryCount(), articleCount);
+  QVERIFY(QFile::exists(csvFile));
+  QVERIFY(QFile(csvFile).size() > 0);
+
+  // an unknown field stops the pipeline
+  QVERIFY(runner.setCommands(QStringList() << "filter" << "nofield" << "equals" << "article"));
+  QVERIFY(!runner.run());
+
+  QVERIFY(runner.setCommands(QStringList() << "open" << tcFile));
+  QVERIFY(runner.run());
+  QCOMPARE(Tellico::Data::Document::self()->collection()->entryCount(), articleCount);
+}
@@ -102,6 +102,39 @@ void BibtexTest::testImport() {
   }
 }
 
+void BibtexTest::testImportLarge() {
+  // enough entries for the importer to read the nodes on several threads
+  QString text = QStringLiteral("@string{acm = \"ACM\"}\n");
+  const int count = 1500;
+  for(int i = 0; i < count; ++i) {
+    text += QStringLiteral("@article{key%1,\n"
+                           "  author = {J{\\\"o}rg M{\\\"u}ller and Jane Doe},\n"
+                           "  title = {Title {NUMBER} %1},\n"
+                           "  journal = acm,\n"
+                           "  year = %2\n"
+                           "}\n").arg(i).arg(1900 + i % 100);
+  }
+
+  Tellico::Import::BibtexImporter importer(text);
+  Tellico::Data::CollPtr tmpColl(new Tellico::Data::BibtexCollection(true));
+  importer.setCurrentCollection(tmpColl);
+  Tellico::Data::CollPtr coll = importer.collection();
+
+  QVERIFY(coll);
+  QCOMPARE(coll->entryCount(), count);
+  // entries keep the order of the file
+  QCOMPARE(coll->entries().first()->field("bibtex-key"), QL1("key0"));
+  QCOMPARE(coll->entries().last()->field("bibtex-key"), QL1("key1499"));
+
+  Tellico::Data::EntryPtr entry = coll->entries().at(1234);
+  QCOMPARE(entry->field("bibtex-key"), QL1("key1234"));
+  QCOMPARE(entry->field("entry-type"), QL1("article"));
+  QCOMPARE(entry->field("author"), QString::fromUtf8("Jörg Müller; Jane Doe"));
+  QCOMPARE(entry->field("title"), QL1("Title NUMBER 1234"));
+  QCOMPARE(entry->field("journal"), QL1("acm"));
+  QCOMPARE(entry->field("year"), QL1("1934"));
+}
+
 void BibtexTest::testDuplicateKeys() {
   Tellico::Data::CollPtr coll(new Tellico::Data::BibtexCollection(true));
   Tellico::Data::BibtexCollection* bColl = static_cast<Tellico::Data::BibtexCollection*>(coll.data());
@@ -131,6 +164,33 @@ void BibtexTest::testDuplicateKeys() {
   entry2->setField(QStringLiteral("bibtex-key"), QStringLiteral("title2"));
   dupes = bColl->duplicateBibtexKeys();
   QCOMPARE(dupes.count(), 0);
+
+  // the key index follows edits, removals, and assignment for undo
+  QCOMPARE(bColl->entryByBibtexKey(QStringLiteral("title1")), entry1);
+  QCOMPARE(bColl->entryByBibtexKey(QStringLiteral("title2")), entry2);
+  QVERIFY(!bColl->entryByBibtexKey(QStringLiteral("nokey")));
+
+  Tellico::Data::Entry oldEntry3(*entry3);
+  entry3->setField(QStringLiteral("bibtex-key"), QStringLiteral("title1"));
+  QCOMPARE(bColl->duplicateBibtexKeys().count(), 2);
+  QVERIFY(!bColl->entryByBibtexKey(QStringLiteral("title3")));
+  // the first entry with the key is found, not the last one to get it
+  QCOMPARE(bColl->entryByBibtexKey(QStringLiteral("title1")), entry1);
+
+  const Tellico::Data::ID id3 = entry3->id();
+  *entry3 = oldEntry3;
+  entry3->setId(id3);
+  QCOMPARE(bColl->duplicateBibtexKeys().count(), 0);
+  QCOMPARE(bColl->entryByBibtexKey(QStringLiteral("title3")), entry3);
+
+  // a copy is not in the collection, so changing it does not touch the index
+  Tellico::Data::EntryPtr copy(new Tellico::Data::Entry(*entry1));
+  copy->setField(QStringLiteral("bibtex-key"), QStringLiteral("copy"));
+  QVERIFY(!bColl->entryByBibtexKey(QStringLiteral("copy")));
+  QCOMPARE(bColl->entryByBibtexKey(QStringLiteral("title1")), entry1);
+
+  coll->removeEntries(Tellico::Data::EntryList() << entry1);
+  QVERIFY(!bColl->entryByBibtexKey(QStringLiteral("title1")));
 }
 
 void BibtexTest::testMapping() {
@@ -140,3 +200,59 @@ void BibtexTest::testMapping() {
   QCOMPARE(Tellico::BibtexHandler::exportText(QString::fromUtf8("…"), QStringList()), QStringLiteral("{{\\ldots}}"));
   QCOMPARE(Tellico::BibtexHandler::exportText(QString::fromUtf8("°"), QStringList()), QStringLiteral("{$^{\\circ}$}"));
 }
+
+void BibtexTest::testImportText() {
+  QFETCH(QString, latex);
+  QFETCH(QString, text);
+
+  QByteArray input = latex.toUtf8();
+  QCOMPARE(Tellico::BibtexHandler::importText(input.data()), text);
+}
+
+void BibtexTest::testImportText_data() {
+  QTest::addColumn<QString>("latex");
+  QTest::addColumn<QString>("text");
+
+  QTest::newRow("plain") << QL1("plain text") << QL1("plain text");
+  QTest::newRow("accent") << QL1("Caf{\\'e} and caf\\'{e}") << QString::fromUtf8("Café and café");
+  QTest::newRow("umlaut") << QL1("{\\\"A}rger") << QString::fromUtf8("Ärger");
+  // the longest match wins
+  QTest::newRow("dashes") << QL1("a---b--c") << QString::fromUtf8("a—b–c");
+  QTest::newRow("capitals") << QL1("{NASA} and {T}he {\\\"A}") << QString::fromUtf8("NASA and The Ä");
+  QTest::newRow("lower braces") << QL1("{nasa} {N}") << QL1("{nasa} N");
+}
+
+void BibtexTest::testCleanText() {
+  QString text = QL1("\\emph{Caf\\'{e}} {Society}");
+  QCOMPARE(Tellico::BibtexHandler::cleanText(text), QString::fromUtf8("Café Society"));
+
+  text = QL1("no latex");
+  QCOMPARE(Tellico::BibtexHandler::cleanText(text), QL1("no latex"));
+
+  // a backslash with no following brace is left alone
+  text = QL1("50\\% off");
+  QCOMPARE(Tellico::BibtexHandler::cleanText(text), QL1("50% off"));
+  text = QL1("a \\b c");
+  QCOMPARE(Tellico::BibtexHandler::cleanText(text), QL1("a \\b c"));
+}
+
+void BibtexTest::testPreparedText() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BibtexCollection(true));
+  QVERIFY(coll->preparesText());
+  Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+  coll->addEntries(entry);
+
+  Tellico::Data::FieldPtr field = coll->fieldByName(QStringLiteral("note"));
+  QVERIFY(field);
+  QCOMPARE(field->formatType(), Tellico::FieldFormat::FormatNone);
+
+  entry->setField(field, QL1("Caf\\'{e} {NASA}"));
+  QCOMPARE(entry->formattedField(field), QString::fromUtf8("Café NASA"));
+  // the raw value is untouched
+  QCOMPARE(entry->field(field), QL1("Caf\\'{e} {NASA}"));
+  // the cached value is dropped when the field changes
+  entry->setField(field, QL1("\\emph{new} note"));
+  QCOMPARE(entry->formattedField(field), QL1("new note"));
+  QCOMPARE(entry->formattedField(field, Tellico::FieldFormat::AsIsFormat), QL1("\\emph{new} note"));
+}
+
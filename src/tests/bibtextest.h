@@ -33,8 +33,13 @@ Q_OBJECT
 private Q_SLOTS:
   void initTestCase();
   void testImport();
+  void testImportLarge();
   void testDuplicateKeys();
   void testMapping();
+  void testImportText();
+  void testImportText_data();
+  void testCleanText();
+  void testPreparedText();
 };
 
 #endif
@@ -27,6 +27,7 @@
 #include "../collection.h"
 #include "../field.h"
 #include "../entry.h"
+#include "../entrygroup.h"
 #include "../collectionfactory.h"
 #include "../collections/collectioninitializer.h"
 #include "../collections/bookcollection.h"
@@ -41,11 +42,48 @@
 
 #include <QTest>
 #include <QStandardPaths>
+#include <QThreadPool>
 
 QTEST_GUILESS_MAIN( CollectionTest )
 
 Q_DECLARE_METATYPE(Tellico::EntryComparison::MatchValue)
 
+namespace {
+  class FormatReader : public QRunnable {
+  public:
+    FormatReader(const Tellico::Data::EntryList& entries_, QStringList* values_)
+        : m_entries(entries_), m_values(values_) {}
+
+    virtual void run() Q_DECL_OVERRIDE {
+      foreach(Tellico::Data::EntryPtr entry, m_entries) {
+        *m_values << entry->formattedField(QStringLiteral("title"))
+                  << entry->formattedField(QStringLiteral("author"));
+      }
+    }
+
+  private:
+    const Tellico::Data::EntryList m_entries;
+    QStringList* m_values;
+  };
+
+  class SnapshotReader : public QRunnable {
+  public:
+    SnapshotReader(Tellico::Data::CollectionSnapshot::Ptr snapshot_, QStringList* values_)
+        : m_snapshot(snapshot_), m_values(values_) {}
+
+    virtual void run() Q_DECL_OVERRIDE {
+      Tellico::Data::CollectionSnapshot::ColumnPtr column = m_snapshot->column(QStringLiteral("publisher"));
+      for(int row = 0; row < m_snapshot->count(); ++row) {
+        *m_values << column->value(row);
+      }
+    }
+
+  private:
+    const Tellico::Data::CollectionSnapshot::Ptr m_snapshot;
+    QStringList* m_values;
+  };
+}
+
 class TestResolver : public Tellico::MergeConflictResolver {
 public:
   TestResolver(Tellico::MergeConflictResolver::Result ret) : m_ret(ret) {};
@@ -704,3 +742,274 @@ void CollectionTest::testGamePlatform() {
     QCOMPARE(i, pGuess);
   }
 }
+
+void CollectionTest::testGroupDicts() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(QStringLiteral("title"), QStringLiteral("title1"));
+  entry1->setField(QStringLiteral("author"), QStringLiteral("John Doe"));
+  entry1->setField(QStringLiteral("publisher"), QStringLiteral("Publisher"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(QStringLiteral("title"), QStringLiteral("title2"));
+  entry2->setField(QStringLiteral("author"), QStringLiteral("Jane Doe"));
+  entry2->setField(QStringLiteral("publisher"), QStringLiteral("Publisher"));
+  coll->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+
+  Tellico::Data::EntryGroupDict* authorDict = coll->entryGroupDictByName(QStringLiteral("author"));
+  QVERIFY(authorDict);
+  QCOMPARE(authorDict->count(), 2);
+  QVERIFY(coll->isEntryGroupDictPopulated(QStringLiteral("author")));
+  Tellico::Data::EntryGroupDict* pubDict = coll->entryGroupDictByName(QStringLiteral("publisher"));
+  QVERIFY(pubDict);
+  QCOMPARE(pubDict->count(), 1);
+  QCOMPARE(entry1->groups().count(), 2);
+
+  // only the publisher groups get invalidated
+  coll->invalidateGroups(QStringList() << QStringLiteral("publisher"));
+  QVERIFY(coll->isEntryGroupDictPopulated(QStringLiteral("author")));
+  QVERIFY(!coll->isEntryGroupDictPopulated(QStringLiteral("publisher")));
+  QCOMPARE(entry1->groups().count(), 1);
+  QCOMPARE(entry1->groups().at(0)->fieldName(), QStringLiteral("author"));
+
+  // now populate the publisher groups from the event loop
+  coll->requestEntryGroupDict(QStringLiteral("publisher"));
+  QVERIFY(!coll->isEntryGroupDictPopulated(QStringLiteral("publisher")));
+  QTRY_VERIFY(coll->isEntryGroupDictPopulated(QStringLiteral("publisher")));
+  QCOMPARE(pubDict->count(), 1);
+  QCOMPARE(pubDict->value(QStringLiteral("Publisher"))->count(), 2);
+  QCOMPARE(entry2->groups().count(), 2);
+
+  // invalidating everything clears all the groups
+  coll->invalidateGroups();
+  QVERIFY(!coll->isEntryGroupDictPopulated(QStringLiteral("author")));
+  QVERIFY(entry1->groups().isEmpty());
+}
+
+void CollectionTest::testPeopleGroup() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  QVERIFY(coll->peopleFields().count() > 1);
+  QVERIFY(coll->entryGroups().contains(Tellico::Data::Collection::s_peopleGroupName));
+
+  Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+  entry->setField(QStringLiteral("author"), QStringLiteral("John Doe; Jane Doe"));
+  entry->setField(QStringLiteral("editor"), QStringLiteral("John Doe"));
+  coll->addEntries(entry);
+
+  Tellico::Data::FieldPtr author = coll->fieldByName(QStringLiteral("author"));
+  QCOMPARE(entry->formattedFieldList(author), QStringList() << QStringLiteral("Doe, John") << QStringLiteral("Doe, Jane"));
+
+  QStringList people = entry->groupNamesByFieldName(Tellico::Data::Collection::s_peopleGroupName);
+  QCOMPARE(QSet<QString>::fromList(people), QSet<QString>() << QStringLiteral("Doe, John") << QStringLiteral("Doe, Jane"));
+
+  // changing a people field has to update the cached names
+  entry->setField(QStringLiteral("editor"), QStringLiteral("Mary Smith"));
+  people = entry->groupNamesByFieldName(Tellico::Data::Collection::s_peopleGroupName);
+  QCOMPARE(people.count(), 3);
+  QVERIFY(people.contains(QStringLiteral("Smith, Mary")));
+
+  // an entry with no people is in the empty people group
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(QStringLiteral("title"), QStringLiteral("title"));
+  coll->addEntries(entry2);
+  QCOMPARE(entry2->groupNamesByFieldName(Tellico::Data::Collection::s_peopleGroupName), QStringList(QString()));
+  QCOMPARE(entry2->groupNamesByFieldName(QStringLiteral("author")), QStringList(QString()));
+
+  Tellico::Data::EntryGroupDict* dict = coll->entryGroupDictByName(Tellico::Data::Collection::s_peopleGroupName);
+  QVERIFY(dict);
+  QCOMPARE(dict->count(), 4);
+  QVERIFY(dict->contains(QStringLiteral("Smith, Mary")));
+  QVERIFY(dict->contains(QString()));
+}
+
+void CollectionTest::testFormatColumn() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(QStringLiteral("title"), QStringLiteral("the great book"));
+  entry1->setField(QStringLiteral("author"), QStringLiteral("john doe; Jane Doe"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(QStringLiteral("title"), QStringLiteral("Another Book"));
+  Tellico::Data::EntryPtr entry3(new Tellico::Data::Entry(coll));
+  entry3->setField(QStringLiteral("author"), QStringLiteral("Mary Smith"));
+  Tellico::Data::EntryList entries;
+  entries << entry1 << entry2 << entry3;
+  coll->addEntries(entries);
+
+  // copies of the entries get formatted one at a time
+  Tellico::Data::EntryList copies;
+  foreach(Tellico::Data::EntryPtr entry, entries) {
+    Tellico::Data::EntryPtr copy(new Tellico::Data::Entry(*entry));
+    copy->invalidateFormattedFieldValue();
+    copies << copy;
+  }
+
+  foreach(const QString& fieldName, QStringList() << QStringLiteral("title") << QStringLiteral("author")) {
+    Tellico::Data::FieldPtr field = coll->fieldByName(fieldName);
+    QVERIFY(field);
+    Tellico::Data::Entry::formatFieldColumn(entries, field);
+    for(int i = 0; i < entries.count(); ++i) {
+      QCOMPARE(entries.at(i)->formattedField(field), copies.at(i)->formattedField(field));
+    }
+  }
+  QCOMPARE(entry1->formattedField(QStringLiteral("author")), copies.at(0)->formattedField(QStringLiteral("author")));
+  QVERIFY(entry2->formattedField(QStringLiteral("author")).isEmpty());
+
+  // a modified value is not left stale in the cache
+  entry1->setField(QStringLiteral("title"), QStringLiteral("A New Title"));
+  Tellico::Data::Entry::formatFieldColumn(entries, coll->fieldByName(QStringLiteral("title")));
+  QVERIFY(entry1->formattedField(QStringLiteral("title")).contains(QStringLiteral("New Title")));
+}
+
+void CollectionTest::testValueIndex() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(QStringLiteral("author"), QStringLiteral("John Doe; Jane Doe"));
+  entry1->setField(QStringLiteral("publisher"), QStringLiteral("Publisher"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(QStringLiteral("author"), QStringLiteral("jane doe"));
+  entry2->setField(QStringLiteral("publisher"), QStringLiteral("Publisher"));
+  coll->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+
+  QCOMPARE(coll->valuesByFieldName(QStringLiteral("author")),
+           QStringList() << QStringLiteral("Jane Doe") << QStringLiteral("jane doe") << QStringLiteral("John Doe"));
+  QCOMPARE(coll->valuesByFieldName(QStringLiteral("publisher")), QStringList(QStringLiteral("Publisher")));
+  QCOMPARE(coll->valuesByPrefix(QStringLiteral("author"), QStringLiteral("ja")),
+           QStringList() << QStringLiteral("Jane Doe") << QStringLiteral("jane doe"));
+  QCOMPARE(coll->valuesByPrefix(QStringLiteral("author"), QStringLiteral("JOHN")), QStringList(QStringLiteral("John Doe")));
+  QVERIFY(coll->valuesByPrefix(QStringLiteral("author"), QStringLiteral("x")).isEmpty());
+
+  // a shared value stays in the index until the last entry drops it
+  const uint revision = coll->valuesRevision();
+  entry1->setField(QStringLiteral("publisher"), QStringLiteral("Other"));
+  QVERIFY(coll->valuesRevision() != revision);
+  QCOMPARE(coll->valuesByFieldName(QStringLiteral("publisher")),
+           QStringList() << QStringLiteral("Other") << QStringLiteral("Publisher"));
+  entry2->setField(QStringLiteral("publisher"), QString());
+  QCOMPARE(coll->valuesByFieldName(QStringLiteral("publisher")), QStringList(QStringLiteral("Other")));
+
+  // an entry copy is not in the collection, so its values are not indexed
+  Tellico::Data::EntryPtr entryCopy(new Tellico::Data::Entry(*entry1));
+  entryCopy->setField(QStringLiteral("publisher"), QStringLiteral("Copy"));
+  QCOMPARE(coll->valuesByFieldName(QStringLiteral("publisher")), QStringList(QStringLiteral("Other")));
+
+  // assigning values, as undo does, updates the index
+  const Tellico::Data::ID id = entry1->id();
+  *entry1 = *entryCopy;
+  entry1->setId(id);
+  QCOMPARE(coll->valuesByFieldName(QStringLiteral("publisher")), QStringList(QStringLiteral("Copy")));
+
+  coll->removeEntries(Tellico::Data::EntryList() << entry1);
+  QVERIFY(coll->valuesByFieldName(QStringLiteral("publisher")).isEmpty());
+  QCOMPARE(coll->valuesByFieldName(QStringLiteral("author")), QStringList(QStringLiteral("jane doe")));
+
+  Tellico::Data::EntryPtr entry3(new Tellico::Data::Entry(coll));
+  entry3->setField(QStringLiteral("author"), QStringLiteral("Mary Smith"));
+  coll->addEntries(entry3);
+  QCOMPARE(coll->valuesByPrefix(QStringLiteral("author"), QStringLiteral("m")), QStringList(QStringLiteral("Mary Smith")));
+}
+
+void CollectionTest::testSnapshot() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryPtr entry1(new Tellico::Data::Entry(coll));
+  entry1->setField(QStringLiteral("publisher"), QStringLiteral("Publisher"));
+  entry1->setField(QStringLiteral("pages"), QStringLiteral("100"));
+  Tellico::Data::EntryPtr entry2(new Tellico::Data::Entry(coll));
+  entry2->setField(QStringLiteral("publisher"), QStringLiteral("Publisher"));
+  coll->addEntries(Tellico::Data::EntryList() << entry1 << entry2);
+
+  Tellico::Data::CollectionSnapshot::Ptr snapshot = coll->snapshot(QStringList() << QStringLiteral("publisher")
+                                                                                 << QStringLiteral("nope"));
+  QCOMPARE(snapshot->count(), 2);
+  QCOMPARE(snapshot->fieldNames(), QStringList(QStringLiteral("publisher")));
+  QCOMPARE(snapshot->row(entry2->id()), 1);
+  QCOMPARE(snapshot->entry(1), entry2);
+  Tellico::Data::CollectionSnapshot::ColumnPtr publishers = snapshot->column(QStringLiteral("publisher"));
+  QVERIFY(publishers);
+  QCOMPARE(publishers->values(), QStringList(QStringLiteral("Publisher")));
+  QCOMPARE(publishers->valueId(0), publishers->valueId(1));
+  // nothing changed, so the same snapshot comes back
+  QCOMPARE(coll->snapshot(QStringList(QStringLiteral("publisher"))), snapshot);
+
+  // asking for another field keeps the first column
+  Tellico::Data::CollectionSnapshot::Ptr snapshot2 = coll->snapshot(QStringList(QStringLiteral("pages")));
+  QVERIFY(snapshot2 != snapshot);
+  QVERIFY(snapshot2->hasColumn(QStringLiteral("publisher")));
+  QCOMPARE(snapshot2->column(QStringLiteral("pages"))->value(0), QStringLiteral("100"));
+  QCOMPARE(snapshot2->column(QStringLiteral("pages"))->value(1), QString());
+
+  // a modified entry is read again, and the old snapshot does not change
+  entry2->setField(QStringLiteral("publisher"), QStringLiteral("Other"));
+  Tellico::Data::EntryPtr entry3(new Tellico::Data::Entry(coll));
+  entry3->setField(QStringLiteral("publisher"), QStringLiteral("Third"));
+  coll->addEntries(entry3);
+  Tellico::Data::CollectionSnapshot::Ptr snapshot3 = coll->snapshot(QStringList(QStringLiteral("publisher")));
+  QCOMPARE(snapshot3->count(), 3);
+  QCOMPARE(snapshot3->column(QStringLiteral("publisher"))->value(1), QStringLiteral("Other"));
+  QCOMPARE(snapshot3->column(QStringLiteral("publisher"))->value(2), QStringLiteral("Third"));
+  QCOMPARE(snapshot2->column(QStringLiteral("publisher"))->value(1), QStringLiteral("Publisher"));
+  QCOMPARE(snapshot2->count(), 2);
+
+  // an entry copy is not in the collection
+  Tellico::Data::EntryPtr entryCopy(new Tellico::Data::Entry(*entry1));
+  entryCopy->setField(QStringLiteral("publisher"), QStringLiteral("Copy"));
+  QCOMPARE(coll->snapshot(QStringList(QStringLiteral("publisher"))), snapshot3);
+
+  // assigning values, as undo does, updates the row
+  const Tellico::Data::ID id = entry1->id();
+  *entry1 = *entryCopy;
+  entry1->setId(id);
+  Tellico::Data::CollectionSnapshot::Ptr snapshot4 = coll->snapshot(QStringList(QStringLiteral("publisher")));
+  QCOMPARE(snapshot4->column(QStringLiteral("publisher"))->value(snapshot4->row(id)), QStringLiteral("Copy"));
+
+  coll->removeEntries(Tellico::Data::EntryList() << entry2);
+  Tellico::Data::CollectionSnapshot::Ptr snapshot5 = coll->snapshot(QStringList(QStringLiteral("publisher")));
+  QCOMPARE(snapshot5->count(), 2);
+  QCOMPARE(snapshot5->row(entry2->id()), -1);
+  QCOMPARE(snapshot5->column(QStringLiteral("publisher"))->value(snapshot5->row(entry3->id())), QStringLiteral("Third"));
+}
+
+void CollectionTest::testConcurrentReads() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryList entries;
+  for(int i = 0; i < 200; ++i) {
+    Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+    entry->setField(QStringLiteral("title"), QStringLiteral("the title %1").arg(i));
+    entry->setField(QStringLiteral("author"), QStringLiteral("john q. doe %1").arg(i));
+    entry->setField(QStringLiteral("publisher"), QStringLiteral("Publisher"));
+    entries << entry;
+  }
+  coll->addEntries(entries);
+
+  QStringList expected;
+  foreach(Tellico::Data::EntryPtr entry, entries) {
+    Tellico::Data::EntryPtr entryCopy(new Tellico::Data::Entry(*entry));
+    entryCopy->invalidateFormattedFieldValue();
+    expected << entryCopy->formattedField(QStringLiteral("title"))
+             << entryCopy->formattedField(QStringLiteral("author"));
+  }
+
+  // every thread fills in the same entry caches at the same time
+  QList<QStringList> results;
+  for(int i = 0; i < 4; ++i) {
+    results << QStringList();
+  }
+  QThreadPool pool;
+  for(int i = 0; i < results.count(); ++i) {
+    pool.start(new FormatReader(entries, &results[i]));
+  }
+  pool.waitForDone();
+  foreach(const QStringList& values, results) {
+    QCOMPARE(values, expected);
+  }
+
+  // a snapshot does not change while the entries are being edited
+  Tellico::Data::CollectionSnapshot::Ptr snapshot = coll->snapshot(QStringList(QStringLiteral("publisher")));
+  QStringList snapshotValues;
+  pool.start(new SnapshotReader(snapshot, &snapshotValues));
+  foreach(Tellico::Data::EntryPtr entry, entries) {
+    entry->setField(QStringLiteral("publisher"), QStringLiteral("Other"));
+  }
+  pool.waitForDone();
+  QCOMPARE(snapshotValues.count(), entries.count());
+  QCOMPARE(snapshotValues.toSet().count(), 1);
+  QCOMPARE(snapshotValues.first(), QStringLiteral("Publisher"));
+}
@@ -53,6 +53,12 @@ private Q_SLOTS:
   void testMatchScore();
   void testMatchScore_data();
   void testGamePlatform();
+  void testGroupDicts();
+  void testPeopleGroup();
+  void testFormatColumn();
+  void testValueIndex();
+  void testSnapshot();
+  void testConcurrentReads();
 
 private:
   Tellico::Data::CollPtr m_coll;
@@ -28,6 +28,9 @@
 #include "../translators/csvexporter.h"
 
 #include <QTest>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QFile>
 
 QTEST_MAIN( CsvTest )
 
@@ -86,3 +89,41 @@ void CsvTest::testEntry() {
   output.chop(1);
   QCOMPARE(output, QStringLiteral("\"title, with comma\""));
 }
+
+void CsvTest::testWriteText() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::Collection(true));
+  for(int i = 0; i < 100; ++i) {
+    Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+    entry->setField(QStringLiteral("title"), QString::fromUtf8("Title \"%1\", with Ünïcödé").arg(i));
+    coll->addEntries(entry);
+  }
+
+  Tellico::Export::CSVExporter exporter(coll);
+  exporter.setEntries(coll->entries());
+  exporter.setFields(Tellico::Data::FieldList() << coll->fieldByName(QStringLiteral("title")));
+  const QString text = exporter.text();
+  QCOMPARE(text.count(QLatin1Char('\n')), 101);
+
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  // streaming to a device gives the same text
+  QFile streamFile(dir.path() + QStringLiteral("/stream.csv"));
+  QVERIFY(streamFile.open(QIODevice::WriteOnly));
+  QTextStream ts(&streamFile);
+  ts.setCodec("UTF-8");
+  QVERIFY(exporter.writeText(ts));
+  ts.flush();
+  streamFile.close();
+  QVERIFY(streamFile.open(QIODevice::ReadOnly));
+  QCOMPARE(QString::fromUtf8(streamFile.readAll()), text);
+
+  // and so does writing the file through exec()
+  const QUrl url = QUrl::fromLocalFile(dir.path() + QStringLiteral("/exec.csv"));
+  exporter.setURL(url);
+  exporter.setOptions(Tellico::Export::ExportUTF8 | Tellico::Export::ExportForce);
+  QVERIFY(exporter.exec());
+  QFile execFile(url.toLocalFile());
+  QVERIFY(execFile.open(QIODevice::ReadOnly));
+  QCOMPARE(QString::fromUtf8(execFile.readAll()), text);
+}
@@ -37,6 +37,7 @@ private Q_SLOTS:
   void testAll();
   void testAll_data();
   void testEntry();
+  void testWriteText();
 };
 
 #endif
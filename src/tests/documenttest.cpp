@@ -30,7 +30,12 @@
 #include "../images/image.h"
 #include "../config/tellico_config.h"
 #include "../collections/bookcollection.h"
+#include "../collections/videocollection.h"
 #include "../collectionfactory.h"
+#include "../translators/tellicoimporter.h"
+#include "../translators/tellicojournal.h"
+#include "../translators/tellicocache.h"
+#include "../entry.h"
 
 #include <QTest>
 #include <QTemporaryDir>
@@ -42,6 +47,7 @@ void DocumentTest::initTestCase() {
   Tellico::ImageFactory::init();
   // test case is a book file
   Tellico::RegisterCollection<Tellico::Data::BookCollection> registerBook(Tellico::Data::Collection::Book, "book");
+  Tellico::RegisterCollection<Tellico::Data::VideoCollection> registerVideo(Tellico::Data::Collection::Video, "video");
 }
 
 void DocumentTest::cleanupTestCase() {
@@ -139,3 +145,137 @@ void DocumentTest::testImageLocalDirectory() {
   tempDir.remove();
   QVERIFY(!QDir(tempDirName).exists());
 }
+
+void DocumentTest::testJournal() {
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+  QString fileName = tempDir.path() + "/movies-many.tc";
+  QVERIFY(QFile::copy(QFINDTESTDATA("data/movies-many.tc"), fileName));
+  const QUrl url = QUrl::fromLocalFile(fileName);
+  const QString journalName = Tellico::Data::Document::journalURL(url).toLocalFile();
+
+  Tellico::Data::Document* doc = Tellico::Data::Document::self();
+  QVERIFY(doc->openDocument(url));
+  Tellico::Data::CollPtr coll = doc->collection();
+  QVERIFY(coll);
+  QCOMPARE(coll->entryCount(), 82);
+
+  QFile file(fileName);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray original = file.readAll();
+  file.close();
+
+  Tellico::Data::EntryPtr entry = coll->entries().at(0);
+  const Tellico::Data::ID id = entry->id();
+  const QString originalTitle = entry->field(QStringLiteral("title"));
+  QVERIFY(entry->setField(QStringLiteral("title"), QStringLiteral("Journal Title")));
+  doc->setEntriesModified(Tellico::Data::EntryList() << entry);
+
+  // a single modified entry only gets written to the journal
+  QVERIFY(doc->saveDocument(url));
+  QVERIFY(QFile::exists(journalName));
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QCOMPARE(file.readAll(), original);
+  file.close();
+
+  // the journal gets applied when the file is opened again
+  QVERIFY(doc->openDocument(url));
+  entry = doc->collection()->entryById(id);
+  QVERIFY(entry);
+  QCOMPARE(entry->field(QStringLiteral("title")), QStringLiteral("Journal Title"));
+
+  // and when the file is imported
+  Tellico::Import::TellicoImporter importer(url, false);
+  Tellico::Data::CollPtr importedColl = importer.collection();
+  QVERIFY(importedColl);
+  QCOMPARE(importer.journalEntryIds(), QList<Tellico::Data::ID>() << id);
+  // the hash computed for checking the journal is kept for writing it again
+  QVERIFY(!importer.journalFileHash().isEmpty());
+  QCOMPARE(importer.journalFileHash(), Tellico::TellicoJournal::fileHash(url));
+  entry = importedColl->entryById(id);
+  QVERIFY(entry);
+  QCOMPARE(entry->field(QStringLiteral("title")), QStringLiteral("Journal Title"));
+
+  // other modifications require writing the complete file, which removes the journal
+  doc->setModified(true);
+  QVERIFY(doc->saveDocument(url));
+  QVERIFY(!QFile::exists(journalName));
+  QVERIFY(doc->openDocument(url));
+  entry = doc->collection()->entryById(id);
+  QVERIFY(entry);
+  QCOMPARE(entry->field(QStringLiteral("title")), QStringLiteral("Journal Title"));
+
+  // a journal for a different version of the file is ignored
+  QVERIFY(entry->setField(QStringLiteral("title"), QStringLiteral("Second Title")));
+  doc->setEntriesModified(Tellico::Data::EntryList() << entry);
+  QVERIFY(doc->saveDocument(url));
+  QVERIFY(QFile::exists(journalName));
+  QVERIFY(QFile::remove(fileName));
+  QVERIFY(QFile::copy(QFINDTESTDATA("data/movies-many.tc"), fileName));
+  QVERIFY(doc->openDocument(url));
+  entry = doc->collection()->entryById(id);
+  QVERIFY(entry);
+  QCOMPARE(entry->field(QStringLiteral("title")), originalTitle);
+}
+
+void DocumentTest::testCache() {
+  QTemporaryDir tempDir;
+  QVERIFY(tempDir.isValid());
+  QString fileName = tempDir.path() + "/movies-many.tc";
+  QVERIFY(QFile::copy(QFINDTESTDATA("data/movies-many.tc"), fileName));
+  const QUrl url = QUrl::fromLocalFile(fileName);
+  const QString cacheName = Tellico::TellicoCache::cacheURL(url).toLocalFile();
+
+  Tellico::Config::setCacheFiles(true);
+  Tellico::Data::Document* doc = Tellico::Data::Document::self();
+  QVERIFY(doc->openDocument(url));
+  // the cache is written once the event loop runs again
+  QTest::qWait(100);
+  QVERIFY(QFile::exists(cacheName));
+  QVERIFY(Tellico::TellicoCache(url).isCurrent());
+
+  Tellico::Import::TellicoImporter cachedImporter(url);
+  Tellico::Data::CollPtr cachedColl = cachedImporter.collection();
+  QVERIFY(cachedColl);
+  QVERIFY(cachedImporter.loadedFromCache());
+
+  Tellico::Config::setCacheFiles(false);
+  Tellico::Import::TellicoImporter xmlImporter(url);
+  Tellico::Data::CollPtr xmlColl = xmlImporter.collection();
+  QVERIFY(xmlColl);
+  QVERIFY(!xmlImporter.loadedFromCache());
+  Tellico::Config::setCacheFiles(true);
+
+  QCOMPARE(cachedColl->type(), xmlColl->type());
+  QCOMPARE(cachedColl->title(), xmlColl->title());
+  QCOMPARE(cachedColl->fieldNames(), xmlColl->fieldNames());
+  QCOMPARE(cachedColl->entryCount(), xmlColl->entryCount());
+  QCOMPARE(cachedColl->filters().count(), xmlColl->filters().count());
+  QCOMPARE(cachedColl->borrowers().count(), xmlColl->borrowers().count());
+  foreach(Tellico::Data::EntryPtr xmlEntry, xmlColl->entries()) {
+    Tellico::Data::EntryPtr cachedEntry = cachedColl->entryById(xmlEntry->id());
+    QVERIFY(cachedEntry);
+    foreach(Tellico::Data::FieldPtr field, xmlColl->fields()) {
+      QCOMPARE(cachedEntry->field(field->name()), xmlEntry->field(field));
+    }
+  }
+
+  // rewriting the file, even with the same contents, makes the cache stale
+  QTest::qWait(1000);
+  QFile file(fileName);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray data = file.readAll();
+  file.close();
+  QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  file.write(data);
+  file.close();
+  QVERIFY(!Tellico::TellicoCache(url).isCurrent());
+  Tellico::Import::TellicoImporter staleImporter(url);
+  QVERIFY(staleImporter.collection());
+  QVERIFY(!staleImporter.loadedFromCache());
+
+  // a complete save writes the cache again
+  doc->setModified(true);
+  QVERIFY(doc->saveDocument(url));
+  QVERIFY(Tellico::TellicoCache(url).isCurrent());
+}
@@ -35,6 +35,8 @@ private Q_SLOTS:
   void cleanupTestCase();
 
   void testImageLocalDirectory();
+  void testJournal();
+  void testCache();
 };
 
 #endif
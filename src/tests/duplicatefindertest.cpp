@@ -0,0 +1,160 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#undef QT_NO_CAST_FROM_ASCII
+
+#include "duplicatefindertest.h"
+
+#include "../duplicatefinder.h"
+#include "../entry.h"
+#include "../collections/bookcollection.h"
+#include "../collections/collectioninitializer.h"
+
+#include <QTest>
+#include <QSignalSpy>
+
+QTEST_GUILESS_MAIN( DuplicateFinderTest )
+
+void DuplicateFinderTest::initTestCase() {
+  qRegisterMetaType<Tellico::Data::EntryList>();
+  // the finder searches a copy of the collection, so the collection types are needed
+  Tellico::CollectionInitializer ci;
+}
+
+void DuplicateFinderTest::testBlockingKeys() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+  entry->setField(QStringLiteral("title"), QStringLiteral("Children of Dúne"));
+  entry->setField(QStringLiteral("isbn"), QStringLiteral("978-0-441-17271-9"));
+  entry->setField(QStringLiteral("lccn"), QStringLiteral("89-456"));
+
+  const QStringList keys = Tellico::DuplicateFinder::blockingKeys(entry);
+  QVERIFY(keys.contains(QStringLiteral("isbn:0441172717")));
+  QVERIFY(keys.contains(QStringLiteral("lccn:89000456")));
+  QVERIFY(keys.contains(QStringLiteral("title:children of")));
+  QVERIFY(keys.contains(QStringLiteral("title:of dune")));
+  QCOMPARE(keys.count(), 4);
+
+  entry->setField(QStringLiteral("title"), QStringLiteral("Dune!"));
+  entry->setField(QStringLiteral("isbn"), QString());
+  entry->setField(QStringLiteral("lccn"), QString());
+  QCOMPARE(Tellico::DuplicateFinder::blockingKeys(entry), QStringList() << QStringLiteral("title:dune"));
+
+  entry->setField(QStringLiteral("title"), QString());
+  QVERIFY(Tellico::DuplicateFinder::blockingKeys(entry).isEmpty());
+}
+
+void DuplicateFinderTest::testFindDuplicates() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+
+  Tellico::Data::EntryPtr dune1(new Tellico::Data::Entry(coll));
+  dune1->setField(QStringLiteral("title"), QStringLiteral("Dune"));
+  dune1->setField(QStringLiteral("author"), QStringLiteral("Frank Herbert"));
+  Tellico::Data::EntryPtr dune2(new Tellico::Data::Entry(coll));
+  dune2->setField(QStringLiteral("title"), QStringLiteral("Dune"));
+  dune2->setField(QStringLiteral("author"), QStringLiteral("Frank Herbert"));
+
+  // same book by isbn, even though the titles don't match
+  Tellico::Data::EntryPtr messiah1(new Tellico::Data::Entry(coll));
+  messiah1->setField(QStringLiteral("title"), QStringLiteral("Dune Messiah"));
+  messiah1->setField(QStringLiteral("isbn"), QStringLiteral("0-441-17269-5"));
+  Tellico::Data::EntryPtr messiah2(new Tellico::Data::Entry(coll));
+  messiah2->setField(QStringLiteral("title"), QStringLiteral("Messiah"));
+  messiah2->setField(QStringLiteral("isbn"), QStringLiteral("9780441172696"));
+
+  Tellico::Data::EntryPtr other(new Tellico::Data::Entry(coll));
+  other->setField(QStringLiteral("title"), QStringLiteral("Foundation"));
+  other->setField(QStringLiteral("author"), QStringLiteral("Isaac Asimov"));
+
+  coll->addEntries(Tellico::Data::EntryList() << dune1 << other << messiah1 << dune2 << messiah2);
+
+  Tellico::DuplicateFinder finder(coll);
+  QSignalSpy foundSpy(&finder, SIGNAL(signalDuplicates(Tellico::Data::EntryList)));
+  QSignalSpy finishedSpy(&finder, SIGNAL(signalFinished()));
+  finder.start();
+  QVERIFY(finder.isRunning());
+  QVERIFY(finishedSpy.wait(10000));
+  QVERIFY(!finder.isRunning());
+  QCOMPARE(foundSpy.count(), 2);
+
+  QList<Tellico::Data::EntryList> sets = finder.duplicates();
+  QCOMPARE(sets.count(), 2);
+  if(!sets.at(0).contains(dune1)) {
+    sets.swap(0, 1);
+  }
+  QCOMPARE(sets.at(0).count(), 2);
+  QVERIFY(sets.at(0).contains(dune1));
+  QVERIFY(sets.at(0).contains(dune2));
+  QCOMPARE(sets.at(1).count(), 2);
+  QVERIFY(sets.at(1).contains(messiah1));
+  QVERIFY(sets.at(1).contains(messiah2));
+
+  // removed entries are no longer reported
+  coll->removeEntries(Tellico::Data::EntryList() << dune2);
+  QCOMPARE(finder.duplicates().count(), 1);
+}
+
+void DuplicateFinderTest::testEditDuringSearch() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryPtr messiah1(new Tellico::Data::Entry(coll));
+  messiah1->setField(QStringLiteral("title"), QStringLiteral("Dune Messiah"));
+  messiah1->setField(QStringLiteral("isbn"), QStringLiteral("0-441-17269-5"));
+  Tellico::Data::EntryPtr messiah2(new Tellico::Data::Entry(coll));
+  messiah2->setField(QStringLiteral("title"), QStringLiteral("Messiah"));
+  messiah2->setField(QStringLiteral("isbn"), QStringLiteral("9780441172696"));
+  coll->addEntries(Tellico::Data::EntryList() << messiah1 << messiah2);
+
+  // the search uses the fields and values from when it started
+  Tellico::DuplicateFinder finder(coll);
+  QSignalSpy finishedSpy(&finder, SIGNAL(signalFinished()));
+  finder.start();
+  QVERIFY(coll->removeField(QStringLiteral("isbn")));
+  messiah2->setField(QStringLiteral("title"), QStringLiteral("Foundation"));
+  QVERIFY(finishedSpy.wait(10000));
+
+  const QList<Tellico::Data::EntryList> sets = finder.duplicates();
+  QCOMPARE(sets.count(), 1);
+  QCOMPARE(sets.at(0).count(), 2);
+}
+
+void DuplicateFinderTest::testCancel() {
+  Tellico::Data::CollPtr coll(new Tellico::Data::BookCollection(true));
+  Tellico::Data::EntryList entries;
+  for(int i = 0; i < 1000; ++i) {
+    Tellico::Data::EntryPtr entry(new Tellico::Data::Entry(coll));
+    entry->setField(QStringLiteral("title"), QStringLiteral("Title %1").arg(i % 10));
+    entries << entry;
+  }
+  coll->addEntries(entries);
+
+  Tellico::DuplicateFinder finder(coll);
+  QSignalSpy finishedSpy(&finder, SIGNAL(signalFinished()));
+  finder.start();
+  finder.slotCancel();
+  QVERIFY(!finder.isRunning());
+  QCOMPARE(finishedSpy.count(), 1);
+  // any jobs still queued should not finish a second time
+  QTest::qWait(100);
+  QCOMPARE(finishedSpy.count(), 1);
+}
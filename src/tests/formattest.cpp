@@ -30,9 +30,26 @@
 #include "../config/tellico_config.h"
 
 #include <QTest>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSet>
 
 QTEST_GUILESS_MAIN( FormatTest )
 
+namespace {
+  class TitleFormatter : public QRunnable {
+  public:
+    TitleFormatter(QStringList* results_) : m_results(results_) {}
+    virtual void run() Q_DECL_OVERRIDE {
+      for(int i = 0; i < 2000; ++i) {
+        *m_results << Tellico::FieldFormat::title(QStringLiteral("the title"), Tellico::FieldFormat::FormatAuto);
+      }
+    }
+  private:
+    QStringList* m_results;
+  };
+}
+
 void FormatTest::initTestCase() {
   Tellico::Config::setArticlesString(QStringLiteral("the,l'"));
   Tellico::Config::setNoCapitalizationString(QStringLiteral("the,of,et,de"));
@@ -141,6 +158,82 @@ void FormatTest::testSplit() {
   QCOMPARE(Tellico::FieldFormat::splitTable(list.join(Tellico::FieldFormat::rowDelimiterString())), list);
 }
 
+void FormatTest::testFormatList() {
+  QStringList names = QStringList() << QStringLiteral("john doe") << QString() << QStringLiteral("jane q. smith, jr.");
+  QStringList formatted = Tellico::FieldFormat::formatList(names, Tellico::FieldFormat::FormatName,
+                                                          Tellico::FieldFormat::ForceFormat);
+  QCOMPARE(formatted.count(), names.count());
+  for(int i = 0; i < names.count(); ++i) {
+    QCOMPARE(formatted.at(i), Tellico::FieldFormat::format(names.at(i), Tellico::FieldFormat::FormatName,
+                                                           Tellico::FieldFormat::ForceFormat));
+  }
+}
+
+void FormatTest::testConfigChange() {
+  // the cached word lists have to follow the config
+  QCOMPARE(Tellico::FieldFormat::capitalize(QStringLiteral("lord of the rings")), QStringLiteral("Lord of the Rings"));
+  Tellico::Config::setNoCapitalizationString(QStringLiteral("the"));
+  QCOMPARE(Tellico::FieldFormat::capitalize(QStringLiteral("lord of the rings")), QStringLiteral("Lord Of the Rings"));
+  Tellico::Config::setNoCapitalizationString(QStringLiteral("the,of,et,de"));
+  QCOMPARE(Tellico::FieldFormat::capitalize(QStringLiteral("lord of the rings")), QStringLiteral("Lord of the Rings"));
+}
+
+void FormatTest::testConcurrentConfigChange() {
+  // the article list changes on the main thread while the title is formatted on others
+  QList<QStringList> results;
+  for(int i = 0; i < 4; ++i) {
+    results << QStringList();
+  }
+  QThreadPool pool;
+  for(int i = 0; i < results.count(); ++i) {
+    pool.start(new TitleFormatter(&results[i]));
+  }
+  for(int i = 0; !pool.waitForDone(0); ++i) {
+    Tellico::Config::setArticlesString(i % 2 == 0 ? QStringLiteral("a,l'") : QStringLiteral("the,l'"));
+    QCOMPARE(Tellico::FieldFormat::title(QStringLiteral("the title"), Tellico::FieldFormat::FormatAuto),
+             i % 2 == 0 ? QStringLiteral("the title") : QStringLiteral("title, the"));
+  }
+  Tellico::Config::setArticlesString(QStringLiteral("the,l'"));
+
+  // every title is formatted with one list or the other
+  const QSet<QString> allowed = QSet<QString>() << QStringLiteral("the title") << QStringLiteral("title, the");
+  foreach(const QStringList& values, results) {
+    QCOMPARE(values.count(), 2000);
+    QVERIFY(values.toSet().subtract(allowed).isEmpty());
+  }
+  QCOMPARE(Tellico::FieldFormat::title(QStringLiteral("the title"), Tellico::FieldFormat::FormatAuto),
+           QStringLiteral("title, the"));
+}
+
+void FormatTest::testSplitValue() {
+  QFETCH(QString, value);
+
+  // the hand-written splitter has to match the regexp split exactly
+  const QRegExp rx(QStringLiteral("\\s*;\\s*"));
+  QCOMPARE(Tellico::FieldFormat::splitValue(value), value.split(rx));
+  QCOMPARE(Tellico::FieldFormat::splitValue(value, Tellico::FieldFormat::RegExpSplit, QString::SkipEmptyParts),
+           value.split(rx, QString::SkipEmptyParts));
+  QString fixed = value;
+  fixed.replace(rx, Tellico::FieldFormat::delimiterString());
+  QCOMPARE(Tellico::FieldFormat::fixupValue(value), fixed);
+}
+
+void FormatTest::testSplitValue_data() {
+  QTest::addColumn<QString>("value");
+
+  QTest::newRow("single") << "one";
+  QTest::newRow("simple") << "one; two; three";
+  QTest::newRow("no space") << "one;two;three";
+  QTest::newRow("spaces") << "one  ;  two\t; three ";
+  QTest::newRow("inner space") << "one two ;three four";
+  QTest::newRow("leading") << " one; two";
+  QTest::newRow("empty parts") << "one;; ;two";
+  QTest::newRow("trailing") << "one; ";
+  QTest::newRow("only delimiter") << ";";
+  QTest::newRow("only spaces") << " ; ";
+  QTest::newRow("newline") << "one\n;\ntwo";
+}
+
 void FormatTest::testStripArticles() {
   QFETCH(QString, articles);
   QFETCH(QString, string);
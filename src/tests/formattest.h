@@ -39,6 +39,11 @@ private Q_SLOTS:
   void testName();
   void testName_data();
   void testSplit();
+  void testFormatList();
+  void testConfigChange();
+  void testConcurrentConfigChange();
+  void testSplitValue();
+  void testSplitValue_data();
   void testStripArticles();
   void testStripArticles_data();
 };
@@ -38,6 +38,7 @@
 #include <QTest>
 #include <QRegExp>
 #include <QTemporaryDir>
+#include <QFile>
 
 QTEST_GUILESS_MAIN( HtmlExporterTest )
 
@@ -186,6 +187,22 @@ void HtmlExporterTest::testReportHtml() {
   QVERIFY(!output2.isEmpty());
   // the rating pic image needs to be an absolute local path, starting with "/"
   QVERIFY(output2.contains(QRegExp(QStringLiteral("src=\"/[^\"]+stars3.png"))));
+
+  // the report is streamed to the file rather than built as a string first
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  Tellico::Export::HTMLExporter exporter3(coll);
+  exporter3.setXSLTFile(QFINDTESTDATA("../../xslt/report-templates/Column_View.xsl"));
+  exporter3.setEntries(coll->entries());
+  exporter3.setParseDOM(false);
+  exporter3.setOptions(exporter3.options() | Tellico::Export::ExportForce);
+  exporter3.setURL(QUrl::fromLocalFile(dir.path() + QStringLiteral("/report.html")));
+  QVERIFY(exporter3.exec());
+  QFile f(dir.path() + QStringLiteral("/report.html"));
+  QVERIFY(f.open(QIODevice::ReadOnly));
+  const QString output3 = QString::fromUtf8(f.readAll());
+  QVERIFY(output3.contains(QStringLiteral("My Title")));
+  QVERIFY(output3.contains(rx));
 }
 
 void HtmlExporterTest::testDirectoryNames() {
@@ -27,8 +27,11 @@
 #include "imagetest.h"
 
 #include "../images/imagefactory.h"
+#include "../images/image.h"
 
 #include <QTest>
+#include <QFile>
+#include <QSignalSpy>
 
 QTEST_GUILESS_MAIN( ImageTest )
 
@@ -42,3 +45,81 @@ void ImageTest::testLinkOnly() {
   QString id = Tellico::ImageFactory::addImage(u, false, QUrl(), true);
   QCOMPARE(id, u.url());
 }
+
+void ImageTest::testImageData() {
+  const QString fileName = QFINDTESTDATA("data/BlueSquare.jpg");
+  QFile file(fileName);
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray original = file.readAll();
+  file.close();
+
+  const QString id = Tellico::ImageFactory::addImage(QUrl::fromLocalFile(fileName), true);
+  QVERIFY(!id.isEmpty());
+  // the original data is kept rather than encoding the image again
+  QCOMPARE(Tellico::ImageFactory::imageById(id).byteArray(), original);
+  QCOMPARE(Tellico::ImageFactory::imageData(id), original);
+
+  // writing the image to a directory copies the original data
+  QVERIFY(Tellico::ImageFactory::writeCachedImage(id, Tellico::ImageFactory::TempDir));
+  QFile written(Tellico::ImageFactory::tempDir() + id);
+  QVERIFY(written.open(QIODevice::ReadOnly));
+  QCOMPARE(written.readAll(), original);
+  written.close();
+
+  // the image in memory releases its data, which is read from the directory instead
+  QCOMPARE(Tellico::ImageFactory::imageData(id), original);
+  QVERIFY(!Tellico::ImageFactory::imageById(id).isNull());
+}
+
+void ImageTest::testRequestImage() {
+  const QUrl u = QUrl::fromLocalFile(QFINDTESTDATA("../../icons/tellico.png"));
+  QSignalSpy spy(Tellico::ImageFactory::self(), SIGNAL(imageRequestFinished(QString, QString)));
+
+  // the url is the placeholder until the image is loaded
+  QCOMPARE(Tellico::ImageFactory::requestImage(u), u.url());
+  QVERIFY(Tellico::ImageFactory::isImageRequestPending(u));
+  // requesting the same url again does not start another download
+  QCOMPARE(Tellico::ImageFactory::requestImage(u), u.url());
+
+  QVERIFY(spy.wait());
+  QCOMPARE(spy.count(), 1);
+  QCOMPARE(spy.at(0).at(0).toString(), u.url());
+  const QString id = spy.at(0).at(1).toString();
+  QCOMPARE(id, QStringLiteral("dde5bf2cbd90fad8635a26dfb362e0ff.png"));
+  QVERIFY(!Tellico::ImageFactory::isImageRequestPending(u));
+
+  // now the id is known, and the synchronous call reuses the image
+  QCOMPARE(Tellico::ImageFactory::requestImage(u), id);
+  QCOMPARE(Tellico::ImageFactory::addImage(u, true), id);
+  QCOMPARE(spy.count(), 1);
+
+  // images that can't be loaded give an empty id
+  const QUrl bad = QUrl::fromLocalFile(QFINDTESTDATA("imagetest.cpp"));
+  QCOMPARE(Tellico::ImageFactory::requestImage(bad), bad.url());
+  QVERIFY(spy.wait());
+  QCOMPARE(spy.at(1).at(1).toString(), QString());
+  QCOMPARE(Tellico::ImageFactory::requestImage(bad), QString());
+}
+
+void ImageTest::testDeferImageRequests() {
+  const QUrl u = QUrl::fromLocalFile(QFINDTESTDATA("../../icons/album.png"));
+  QSignalSpy spy(Tellico::ImageFactory::self(), SIGNAL(imageRequestFinished(QString, QString)));
+
+  // while deferred, adding an image only requests it, and gives the url as a placeholder
+  Tellico::ImageFactory::setDeferImageRequests(true);
+  const QString placeholder = Tellico::ImageFactory::addImage(u, true);
+  Tellico::ImageFactory::setDeferImageRequests(false);
+  QCOMPARE(placeholder, u.url());
+  QVERIFY(Tellico::ImageFactory::isImageRequestPending(u));
+  QCOMPARE(Tellico::ImageFactory::requestedImageId(placeholder), placeholder);
+  // the placeholder is not loaded as a linked image in the meantime
+  QVERIFY(Tellico::ImageFactory::imageById(placeholder).isNull());
+  QVERIFY(!Tellico::ImageFactory::isImageRequestPending(QUrl()));
+
+  QVERIFY(spy.wait());
+  QCOMPARE(spy.count(), 1);
+  const QString id = spy.at(0).at(1).toString();
+  QVERIFY(!id.isEmpty());
+  QCOMPARE(Tellico::ImageFactory::requestedImageId(placeholder), id);
+  QVERIFY(!Tellico::ImageFactory::imageById(id).isNull());
+}
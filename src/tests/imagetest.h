@@ -33,6 +33,9 @@ Q_OBJECT
 private Q_SLOTS:
   void initTestCase();
   void testLinkOnly();
+  void testImageData();
+  void testRequestImage();
+  void testDeferImageRequests();
 };
 
 #endif
@@ -24,6 +24,7 @@
 
 #include "iso6937test.h"
 #include "../utils/iso6937converter.h"
+#include "../utils/iso5426converter.h"
 
 #include <QTest>
 
@@ -225,3 +226,56 @@ void Iso6937Test::testAccent_data() {
   QTest::newRow("e3") << QU8("ª") << QByteArray::fromHex("e3");
   QTest::newRow("ff") << QU8("\u00ad") << QByteArray::fromHex("ff");
 }
+
+// accented characters falling on either side of the blocks of ASCII text
+void Iso6937Test::testLongText() {
+  const QByteArray ascii("The quick brown fox jumps over the lazy dog");
+  QByteArray input;
+  QString output;
+  for(int i = 0; i < 20; ++i) {
+    input += ascii.left(i) + QByteArray::fromHex("c265") + ascii;
+    output += QString::fromLatin1(ascii.left(i)) + QU8("é") + QString::fromLatin1(ascii);
+  }
+  // a trailing diacritic has nothing to combine with
+  input += QByteArray::fromHex("c2");
+  output += Tellico::Iso6937Converter::toUtf8(QByteArray::fromHex("c2"));
+
+  QCOMPARE(Tellico::Iso6937Converter::toUtf8(input), output);
+  QCOMPARE(Tellico::Iso6937Converter::toUtf8(QByteArray()), QString());
+}
+
+void Iso6937Test::testBenchmark() {
+  QFETCH(QByteArray, input);
+  QFETCH(bool, iso5426);
+
+  // roughly the size of a result page of MARC records
+  QByteArray text;
+  while(text.size() < 100000) {
+    text += input;
+  }
+
+  if(iso5426) {
+    QBENCHMARK {
+      Tellico::Iso5426Converter::toUtf8(text);
+    }
+  } else {
+    QBENCHMARK {
+      Tellico::Iso6937Converter::toUtf8(text);
+    }
+  }
+}
+
+void Iso6937Test::testBenchmark_data() {
+  QTest::addColumn<QByteArray>("input");
+  QTest::addColumn<bool>("iso5426");
+
+  const QByteArray ascii("Stephenson, Robby. Tellico: collection management. 2019. ");
+  // the diaeresis and the acute accent are the same in both character sets
+  const QByteArray accents = QByteArray("No") + QByteArray::fromHex("c865") + QByteArray("l Arnaud, M")
+                           + QByteArray::fromHex("c261") + QByteArray("laga. ");
+
+  QTest::newRow("iso6937 ascii") << ascii << false;
+  QTest::newRow("iso6937 accents") << accents << false;
+  QTest::newRow("iso5426 ascii") << ascii << true;
+  QTest::newRow("iso5426 accents") << accents << true;
+}
@@ -35,6 +35,9 @@ private Q_SLOTS:
   void testAscii_data();
   void testAccent();
   void testAccent_data();
+  void testLongText();
+  void testBenchmark();
+  void testBenchmark_data();
 };
 
 #endif
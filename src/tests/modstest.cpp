@@ -27,6 +27,7 @@
 #include "modstest.h"
 
 #include "../translators/xsltimporter.h"
+#include "../translators/tellicoimporter.h"
 #include "../translators/xslthandler.cpp"
 #include "../collections/bookcollection.h"
 #include "../collectionfactory.h"
@@ -86,3 +87,41 @@ void ModsTest::testDNBMARCXML() {
   QCOMPARE(coll->type(), Tellico::Data::Collection::Book);
   QCOMPARE(coll->entryCount(), 25);
 }
+
+// chaining the stylesheets on the parsed documents should give the same result as the text path
+void ModsTest::testTransformDocument() {
+  Tellico::XSLTHandler marcHandler(QUrl::fromLocalFile(QFINDTESTDATA("../../xslt/MARC21slim2MODS3.xsl")));
+  QVERIFY(marcHandler.isValid());
+  Tellico::XSLTHandler modsHandler(QUrl::fromLocalFile(QFINDTESTDATA("../../xslt/mods2tellico.xsl")));
+  QVERIFY(modsHandler.isValid());
+
+  QFile f(QFINDTESTDATA("data/dnb-marcxml.xml"));
+  QVERIFY(f.open(QIODevice::ReadOnly));
+  const QByteArray data = f.readAll();
+
+  xmlDocPtr modsDoc = marcHandler.transform(data);
+  QVERIFY(modsDoc);
+  xmlDocPtr tellicoDoc = modsHandler.transform(modsDoc);
+  xmlFreeDoc(modsDoc);
+  QVERIFY(tellicoDoc);
+
+  Tellico::Import::TellicoImporter docImporter(tellicoDoc);
+  Tellico::Data::CollPtr docColl = docImporter.collection();
+  QVERIFY(docColl);
+
+  Tellico::Import::TellicoImporter textImporter(modsHandler.applyStylesheet(marcHandler.applyStylesheet(QString::fromUtf8(data))));
+  Tellico::Data::CollPtr textColl = textImporter.collection();
+  QVERIFY(textColl);
+
+  QCOMPARE(docColl->type(), Tellico::Data::Collection::Book);
+  QCOMPARE(docColl->entryCount(), 25);
+  QCOMPARE(docColl->entryCount(), textColl->entryCount());
+  QCOMPARE(docColl->fieldNames(), textColl->fieldNames());
+  for(int i = 0; i < docColl->entryCount(); ++i) {
+    Tellico::Data::EntryPtr docEntry = docColl->entries().at(i);
+    Tellico::Data::EntryPtr textEntry = textColl->entries().at(i);
+    foreach(const QString& name, docColl->fieldNames()) {
+      QCOMPARE(docEntry->field(name), textEntry->field(name));
+    }
+  }
+}
@@ -0,0 +1,138 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tracertest.h"
+#include "../utils/tracer.h"
+
+#include <QTest>
+#include <QFile>
+#include <QThread>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+
+QTEST_GUILESS_MAIN( TracerTest )
+
+namespace {
+  Tellico::Tracer::Stat findStat(const QByteArray& name_) {
+    foreach(const Tellico::Tracer::Stat& stat, Tellico::Tracer::stats()) {
+      if(stat.name == name_) {
+        return stat;
+      }
+    }
+    Tellico::Tracer::Stat stat;
+    stat.count = 0;
+    stat.totalTime = 0;
+    stat.maxTime = 0;
+    return stat;
+  }
+}
+
+void TracerTest::initTestCase() {
+  QVERIFY(m_tempDir.isValid());
+  // the trace file is opened the first time the tracer is used
+  qputenv("TELLICO_TRACE_FILE", QFile::encodeName(m_tempDir.path() + QStringLiteral("/trace.json")));
+  QVERIFY(Tellico::Tracer::isTracing());
+}
+
+void TracerTest::testScope() {
+  for(int i = 0; i < 3; ++i) {
+    TRACE_SCOPE("test", "scope");
+    QThread::msleep(5);
+  }
+  Tellico::Tracer::Stat stat = findStat("scope");
+  QCOMPARE(stat.category, QByteArray("test"));
+  QCOMPARE(stat.count, Q_INT64_C(3));
+  QVERIFY(stat.totalTime >= Q_INT64_C(15000000));
+  QVERIFY(stat.maxTime >= Q_INT64_C(5000000));
+  QVERIFY(stat.maxTime <= stat.totalTime);
+}
+
+void TracerTest::testCount() {
+  Tellico::Tracer::count("test", "counter");
+  Tellico::Tracer::count("test", "counter", 10);
+  Tellico::Tracer::Stat stat = findStat("counter");
+  QCOMPARE(stat.count, Q_INT64_C(11));
+  QCOMPARE(stat.totalTime, Q_INT64_C(0));
+}
+
+void TracerTest::testAsync() {
+  int id1, id2;
+  Tellico::Tracer::beginAsync("test", "async", &id1);
+  Tellico::Tracer::beginAsync("test", "async", &id2);
+  QThread::msleep(5);
+  Tellico::Tracer::endAsync(&id1);
+  Tellico::Tracer::endAsync(&id2);
+  // ending twice does nothing
+  Tellico::Tracer::endAsync(&id2);
+  Tellico::Tracer::Stat stat = findStat("async");
+  QCOMPARE(stat.count, Q_INT64_C(2));
+  QVERIFY(stat.totalTime >= Q_INT64_C(10000000));
+}
+
+void TracerTest::testReset() {
+  QVERIFY(!Tellico::Tracer::stats().isEmpty());
+  Tellico::Tracer::resetStats();
+  QVERIFY(Tellico::Tracer::stats().isEmpty());
+  {
+    TRACE_SCOPE("test", "afterReset");
+  }
+  QCOMPARE(Tellico::Tracer::stats().count(), 1);
+}
+
+void TracerTest::testTraceFile() {
+  QFile file(m_tempDir.path() + QStringLiteral("/trace.json"));
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  // the closing bracket is only written when the program exits
+  const QByteArray data = file.readAll() + "\n]";
+  QJsonParseError error;
+  const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+  QCOMPARE(error.error, QJsonParseError::NoError);
+  QVERIFY(doc.isArray());
+
+  int scopes = 0, counters = 0, asyncBegins = 0, asyncEnds = 0;
+  foreach(const QJsonValue& value, doc.array()) {
+    const QJsonObject event = value.toObject();
+    QCOMPARE(event.value(QStringLiteral("cat")).toString(), QStringLiteral("test"));
+    QVERIFY(event.contains(QStringLiteral("ts")));
+    QVERIFY(event.contains(QStringLiteral("pid")));
+    QVERIFY(event.contains(QStringLiteral("tid")));
+    const QString phase = event.value(QStringLiteral("ph")).toString();
+    if(phase == QLatin1String("X")) {
+      QVERIFY(event.contains(QStringLiteral("dur")));
+      ++scopes;
+    } else if(phase == QLatin1String("C")) {
+      QVERIFY(event.value(QStringLiteral("args")).toObject().contains(QStringLiteral("value")));
+      ++counters;
+    } else if(phase == QLatin1String("b")) {
+      ++asyncBegins;
+    } else if(phase == QLatin1String("e")) {
+      ++asyncEnds;
+    }
+  }
+  QCOMPARE(scopes, 4);
+  QCOMPARE(counters, 2);
+  QCOMPARE(asyncBegins, 2);
+  QCOMPARE(asyncEnds, 2);
+}
@@ -27,12 +27,15 @@
 #include "z3950fetchertest.h"
 
 #include "../fetch/z3950fetcher.h"
+#include "../fetch/z3950connection.h"
 #include "../collections/bookcollection.h"
 #include "../collectionfactory.h"
 #include "../entry.h"
 #include "../utils/datafileregistry.h"
 
 #include <QTest>
+#include <QProcess>
+#include <QStandardPaths>
 
 QTEST_GUILESS_MAIN( Z3950FetcherTest )
 
@@ -119,3 +122,41 @@ void Z3950FetcherTest::testBibsysIsbn() {
   QCOMPARE(entry->field(QStringLiteral("title")), QString::fromUtf8("Grønn"));
   QCOMPARE(entry->field(QStringLiteral("isbn")), QStringLiteral("82-42-40477-1"));
 }
+
+// runs against a local test server from yaz
+void Z3950FetcherTest::testConnectionPool() {
+  const QString ztest = QStandardPaths::findExecutable(QStringLiteral("yaz-ztest"));
+  if(ztest.isEmpty()) {
+    QSKIP("This test requires yaz-ztest", SkipAll);
+  }
+  const QString host = QStringLiteral("localhost");
+  const int port = 21210;
+  const QString dbName = QStringLiteral("Default");
+
+  QProcess server;
+  server.start(ztest, QStringList() << QStringLiteral("tcp:%1:%2").arg(host).arg(port));
+  QVERIFY(server.waitForStarted());
+  // give the server a moment to start listening
+  QTest::qWait(500);
+
+  Tellico::Fetch::FetchRequest request(Tellico::Data::Collection::Book, Tellico::Fetch::Title,
+                                       QStringLiteral("computer"));
+  QCOMPARE(Tellico::Fetch::Z3950Connection::pooledConnectionCount(host, port, dbName), 0);
+
+  Tellico::Fetch::Fetcher::Ptr fetcher1(new Tellico::Fetch::Z3950Fetcher(this, host, port, dbName, QStringLiteral("usmarc")));
+  DO_FETCH(fetcher1, request);
+  // the connection is kept open after the search is done
+  QCOMPARE(Tellico::Fetch::Z3950Connection::pooledConnectionCount(host, port, dbName), 1);
+
+  // a second fetcher for the same server takes the open connection rather than making another
+  Tellico::Fetch::Fetcher::Ptr fetcher2(new Tellico::Fetch::Z3950Fetcher(this, host, port, dbName, QStringLiteral("usmarc")));
+  DO_FETCH(fetcher2, request);
+  QCOMPARE(Tellico::Fetch::Z3950Connection::pooledConnectionCount(host, port, dbName), 1);
+
+  // and so does a second search from the same fetcher
+  DO_FETCH(fetcher2, request);
+  QCOMPARE(Tellico::Fetch::Z3950Connection::pooledConnectionCount(host, port, dbName), 1);
+
+  server.kill();
+  server.waitForFinished();
+}
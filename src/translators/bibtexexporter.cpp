@@ -26,7 +26,6 @@
 
 #include "bibtexexporter.h"
 #include "../collections/bibtexcollection.h"
-#include "../core/filehandler.h"
 #include "../utils/bibtexhandler.h"
 #include "../utils/stringset.h"
 #include "../fieldformat.h"
@@ -42,6 +41,7 @@
 #include <QLabel>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include <QTextStream>
 
 using namespace Tellico;
 using Tellico::Export::BibtexExporter;
@@ -66,14 +66,27 @@ QString BibtexExporter::fileFilter() const {
 }
 
 bool BibtexExporter::exec() {
-  const QString text = this->text();
-  return text.isEmpty() ? false : FileHandler::writeTextURL(url(), text, options() & ExportUTF8, options() & Export::ExportForce);
+  Data::CollPtr c = collection();
+  if(!c || c->type() != Data::Collection::Bibtex) {
+    return false;
+  }
+  return writeTextURL();
 }
 
 QString BibtexExporter::text() {
+  QString text;
+  QTextStream ts(&text);
+  if(!writeText(ts)) {
+    return QString();
+  }
+  ts.flush();
+  return text;
+}
+
+bool BibtexExporter::writeText(QTextStream& ts_) {
   Data::CollPtr c = collection();
   if(!c || c->type() != Data::Collection::Bibtex) {
-    return QString();
+    return false;
   }
   const Data::BibtexCollection* coll = static_cast<const Data::BibtexCollection*>(c.data());
 
@@ -107,34 +120,34 @@ QString BibtexExporter::text() {
   if(typeField.isEmpty() || keyField.isEmpty()) {
     myWarning() << "the collection must have fields defining "
                    "the entry-type and the key of the entry";
-    return QString();
+    return false;
   }
   if(fields.isEmpty()) {
     myWarning() << "no bibtex field mapping exists in the collection.";
-    return QString();
+    return false;
   }
 
-  QString text = QLatin1String("@comment{Generated by Tellico ")
-               + QLatin1String(TELLICO_VERSION)
-               + QLatin1String("}\n\n");
+  ts_ << QLatin1String("@comment{Generated by Tellico ")
+      << QLatin1String(TELLICO_VERSION)
+      << QLatin1String("}\n\n");
 
   const QStringList macros = coll->macroList().keys();
 
   if(!coll->preamble().isEmpty()) {
-    text += QLatin1String("@preamble{")
-            + BibtexHandler::exportText(coll->preamble(), macros)
-            + QLatin1String("}\n\n");
+    ts_ << QLatin1String("@preamble{")
+        << BibtexHandler::exportText(coll->preamble(), macros)
+        << QLatin1String("}\n\n");
   }
 
   if(!m_expandMacros) {
     QMap<QString, QString>::ConstIterator macroIt;
     for(macroIt = coll->macroList().constBegin(); macroIt != coll->macroList().constEnd(); ++macroIt) {
       if(!macroIt.value().isEmpty()) {
-        text += QLatin1String("@string{")
-                + macroIt.key()
-                + QLatin1String("=")
-                + BibtexHandler::exportText(macroIt.value(), macros)
-                + QLatin1String("}\n\n");
+        ts_ << QLatin1String("@string{")
+            << macroIt.key()
+            << QLatin1String("=")
+            << BibtexHandler::exportText(macroIt.value(), macros)
+            << QLatin1String("}\n\n");
       }
     }
   }
@@ -184,7 +197,7 @@ QString BibtexExporter::text() {
     key = newKey;
     usedKeys.add(key);
 
-    writeEntryText(text, fields, *entryIt, type, key);
+    writeEntryText(ts_, fields, *entryIt, type, key);
   }
 
   // now write out crossrefs
@@ -202,9 +215,9 @@ QString BibtexExporter::text() {
     key = newKey;
     usedKeys.add(key);
 
-    writeEntryText(text, fields, *entryIt, entryIt->field(typeField), key);
+    writeEntryText(ts_, fields, *entryIt, entryIt->field(typeField), key);
   }
-  return text;
+  return true;
 }
 
 QWidget* BibtexExporter::widget(QWidget* parent_) {
@@ -293,14 +306,14 @@ void BibtexExporter::saveOptions(KSharedConfigPtr config_) {
   }
 }
 
-void BibtexExporter::writeEntryText(QString& text_, const Tellico::Data::FieldList& fields_, const Tellico::Data::Entry& entry_,
+void BibtexExporter::writeEntryText(QTextStream& ts_, const Tellico::Data::FieldList& fields_, const Tellico::Data::Entry& entry_,
                                     const QString& type_, const QString& key_) {
   const QStringList macros = static_cast<const Data::BibtexCollection*>(collection().data())->macroList().keys();
   const QString bibtex = QStringLiteral("bibtex");
   const QString bibtexSep = QStringLiteral("bibtex-separator");
   QRegExp numberRx(QLatin1String("^\\d+$"));
 
-  text_ += QLatin1Char('@') + type_ + QLatin1Char('{') + key_;
+  ts_ << QLatin1Char('@') << type_ << QLatin1Char('{') << key_;
 
   QString value;
   FieldFormat::Request format = (options() & Export::ExportFormatted ?
@@ -349,10 +362,10 @@ void BibtexExporter::writeEntryText(QString& text_, const Tellico::Data::FieldLi
         value.replace(QChar(0xA0), QLatin1Char('~'));
       }
     }
-    text_ += QLatin1String(",\n  ")
-           + fIt->property(bibtex)
-           + QLatin1String(" = ")
-           + value;
+    ts_ << QLatin1String(",\n  ")
+        << fIt->property(bibtex)
+        << QLatin1String(" = ")
+        << value;
   }
-  text_ += QLatin1String("\n}\n\n");
+  ts_ << QLatin1String("\n}\n\n");
 }
@@ -47,6 +47,7 @@ public:
   BibtexExporter(Data::CollPtr coll);
 
   virtual bool exec() Q_DECL_OVERRIDE;
+  virtual bool writeText(QTextStream& ts) Q_DECL_OVERRIDE;
   virtual QString formatString() const Q_DECL_OVERRIDE;
   virtual QString fileFilter() const Q_DECL_OVERRIDE;
   QString text();
@@ -56,7 +57,7 @@ public:
   virtual void saveOptions(KSharedConfigPtr) Q_DECL_OVERRIDE;
 
 private:
-  void writeEntryText(QString& text, const Data::FieldList& field, const Data::Entry& entry,
+  void writeEntryText(QTextStream& ts, const Data::FieldList& field, const Data::Entry& entry,
                       const QString& type, const QString& key);
 
   bool m_expandMacros;
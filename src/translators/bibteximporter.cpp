@@ -42,10 +42,123 @@
 #include <QButtonGroup>
 #include <QFile>
 #include <QApplication>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QAtomicInt>
+#include <QVector>
+#include <QPair>
 
 using namespace Tellico;
 using Tellico::Import::BibtexImporter;
 
+namespace {
+  // reading the nodes is only spread over several threads when there are enough of them
+  static const int BIBTEX_MIN_PARALLEL_NODES = 1000;
+  // more chunks than threads, so progress can be shown as they finish
+  static const int BIBTEX_CHUNKS_PER_THREAD = 8;
+  // how often to check on the reading threads, in milliseconds
+  static const int BIBTEX_READ_WAIT = 100;
+
+  // the values of a regular bibtex entry, as read from its AST node
+  struct BibtexValues {
+    QString type;
+    QString key;
+    QList<QPair<QString, QString> > fields;
+  };
+
+  bool isRegularNode(AST* node_) {
+    const bt_metatype type = bt_entry_metatype(node_);
+    return type != BTE_PREAMBLE && type != BTE_MACRODEF && type != BTE_COMMENT;
+  }
+
+  void readNode(AST* node_, BibtexValues& values_, const QRegExp& andRx_) {
+    // text is automatically put into lower-case by btparse
+    values_.type = QString::fromUtf8(bt_entry_type(node_));
+    values_.key = QString::fromUtf8(bt_entry_key(node_));
+
+    QString str;
+    char* name;
+    AST* field = nullptr;
+    while((field = bt_next_field(node_, field, &name))) {
+      str.clear();
+      AST* value = nullptr;
+      bt_nodetype type;
+      char* svalue;
+      bool end_macro = false;
+      while((value = bt_next_value(field, value, &type, &svalue))) {
+        switch(type) {
+          case BTAST_STRING:
+          case BTAST_NUMBER:
+            str += Tellico::BibtexHandler::importText(svalue).simplified();
+            end_macro = false;
+            break;
+          case BTAST_MACRO:
+            str += QString::fromUtf8(svalue) + QLatin1Char('#');
+            end_macro = true;
+            break;
+          default:
+            break;
+        }
+      }
+      if(end_macro) {
+        // remove last character '#'
+        str.truncate(str.length() - 1);
+      }
+      const QString fieldName = QString::fromUtf8(name);
+      if(fieldName == QLatin1String("author") || fieldName == QLatin1String("editor")) {
+        str.replace(andRx_, Tellico::FieldFormat::delimiterString());
+      }
+      values_.fields.append(qMakePair(fieldName, str));
+    }
+  }
+
+  // only the AST walking functions of btparse are used, they don't touch any global state
+  // the reader stops between nodes once the stop flag is set, and adds its count to the done counter when finished
+  class NodeReader : public QRunnable {
+  public:
+    NodeReader(const QList<AST*>& nodes_, BibtexValues* values_, int begin_, int end_,
+               const QAtomicInt* stop_ = nullptr, QAtomicInt* done_ = nullptr)
+        : m_nodes(nodes_), m_values(values_), m_begin(begin_), m_end(end_), m_stop(stop_), m_done(done_) {}
+
+    virtual void run() Q_DECL_OVERRIDE {
+      // QRegExp is not safe to share between threads
+      const QRegExp andRx(QLatin1String("\\sand\\s"));
+      for(int i = m_begin; i < m_end; ++i) {
+        if(m_stop && m_stop->loadAcquire()) {
+          return;
+        }
+        AST* node = m_nodes.at(i);
+        if(isRegularNode(node)) {
+          readNode(node, m_values[i], andRx);
+        }
+      }
+      if(m_done) {
+        m_done->fetchAndAddRelease(m_end - m_begin);
+      }
+    }
+
+  private:
+    const QList<AST*>& m_nodes;
+    BibtexValues* m_values;
+    const int m_begin;
+    const int m_end;
+    const QAtomicInt* m_stop;
+    QAtomicInt* m_done;
+  };
+
+  int nextBrace(const QString& text_, int from_) {
+    const QChar* data = text_.constData();
+    const int length = text_.length();
+    for(int i = from_; i < length; ++i) {
+      if(data[i] == QLatin1Char('{') || data[i] == QLatin1Char('}')) {
+        return i;
+      }
+    }
+    return -1;
+  }
+}
+
 int BibtexImporter::s_initCount = 0;
 
 BibtexImporter::BibtexImporter(const QList<QUrl>& urls_) : Importer(urls_)
@@ -146,7 +259,6 @@ Tellico::Data::CollPtr BibtexImporter::readCollection(const QString& text, int u
     return Data::CollPtr();
   }
 
-  QString str;
   const uint count = m_nodes.count();
   const uint stepSize = qMax(s_stepSize, count/100);
   const bool showProgress = options() & ImportProgress;
@@ -156,6 +268,39 @@ Tellico::Data::CollPtr BibtexImporter::readCollection(const QString& text, int u
     currentColl = ptr;
   }
 
+  // converting the LaTeX in the values is the slow part, and it doesn't need the collection,
+  // so read all the regular entries first, spread over the available cores
+  // the first half of the progress is for reading the values, the second for creating the entries
+  QVector<BibtexValues> values(m_nodes.count());
+  const int threadCount = QThread::idealThreadCount();
+  if(threadCount > 1 && m_nodes.count() >= BIBTEX_MIN_PARALLEL_NODES &&
+     BibtexHandler::initTranslationMaps()) {
+    QAtomicInt stop;
+    QAtomicInt done;
+    QThreadPool pool;
+    const int chunkCount = threadCount * BIBTEX_CHUNKS_PER_THREAD;
+    const int chunkSize = (m_nodes.count() + chunkCount - 1) / chunkCount;
+    for(int begin = 0; begin < m_nodes.count(); begin += chunkSize) {
+      pool.start(new NodeReader(m_nodes, values.data(), begin, qMin(begin + chunkSize, m_nodes.count()),
+                                &stop, &done));
+    }
+    // keep the event loop going, so the import can be cancelled
+    while(!pool.waitForDone(BIBTEX_READ_WAIT)) {
+      if(showProgress) {
+        emit signalProgress(this, urlCount*100 + 50*done.loadAcquire()/count);
+      }
+      qApp->processEvents();
+      if(m_cancelled) {
+        stop.storeRelease(1);
+        pool.clear();
+      }
+    }
+  } else {
+    NodeReader(m_nodes, values.data(), 0, m_nodes.count()).run();
+  }
+
+  Data::EntryList entries;
+  entries.reserve(m_nodes.count());
   uint j = 0;
   for(int i = 0; !m_cancelled && i < m_nodes.count(); ++i, ++j) {
     AST* node = m_nodes[i];
@@ -181,51 +326,15 @@ Tellico::Data::CollPtr BibtexImporter::readCollection(const QString& text, int u
       continue;
     }
 
-    // now we're parsing a regular entry
+    // now we're adding a regular entry
+    const BibtexValues& entryValues = values.at(i);
     Data::EntryPtr entry(new Data::Entry(ptr));
+    Data::BibtexCollection::setFieldValue(entry, QStringLiteral("entry-type"), entryValues.type, currentColl);
+    Data::BibtexCollection::setFieldValue(entry, QStringLiteral("key"), entryValues.key, currentColl);
 
-    str = QString::fromUtf8(bt_entry_type(node));
-//    myDebug() << "entry type: " << str;
-    // text is automatically put into lower-case by btparse
-    Data::BibtexCollection::setFieldValue(entry, QStringLiteral("entry-type"), str, currentColl);
-
-    str = QString::fromUtf8(bt_entry_key(node));
-//    myDebug() << "entry key: " << str;
-    Data::BibtexCollection::setFieldValue(entry, QStringLiteral("key"), str, currentColl);
-
-    char* name;
-    AST* field = nullptr;
-    while((field = bt_next_field(node, field, &name))) {
-//      myDebug() << "\tfound: " << name;
-//      str = QLatin1String(bt_get_text(field));
-      str.clear();
-      AST* value = nullptr;
-      bt_nodetype type;
-      char* svalue;
-      bool end_macro = false;
-      while((value = bt_next_value(field, value, &type, &svalue))) {
-        switch(type) {
-          case BTAST_STRING:
-          case BTAST_NUMBER:
-            str += BibtexHandler::importText(svalue).simplified();
-            end_macro = false;
-            break;
-          case BTAST_MACRO:
-            str += QString::fromUtf8(svalue) + QLatin1Char('#');
-            end_macro = true;
-            break;
-          default:
-            break;
-        }
-      }
-      if(end_macro) {
-        // remove last character '#'
-        str.truncate(str.length() - 1);
-      }
-      QString fieldName = QString::fromUtf8(name);
-      if(fieldName == QLatin1String("author") || fieldName == QLatin1String("editor")) {
-        str.replace(QRegExp(QLatin1String("\\sand\\s")),FieldFormat::delimiterString());
-      }
+    for(int k = 0; k < entryValues.fields.count(); ++k) {
+      const QString& fieldName = entryValues.fields.at(k).first;
+      const QString& str = entryValues.fields.at(k).second;
       // there's a 'key' field different from the citation key
       // http://nwalsh.com/tex/texhelp/bibtx-37.html
       // TODO account for this later
@@ -236,16 +345,18 @@ Tellico::Data::CollPtr BibtexImporter::readCollection(const QString& text, int u
       }
     }
 
-    ptr->addEntries(entry);
+    entries.append(entry);
 
     if(showProgress && j%stepSize == 0) {
-      emit signalProgress(this, urlCount*100 + 100*j/count);
+      emit signalProgress(this, urlCount*100 + 50 + 50*j/count);
       qApp->processEvents();
     }
   }
 
   if(m_cancelled) {
     ptr = nullptr;
+  } else {
+    ptr->addEntries(entries);
   }
 
   // clean-up
@@ -269,15 +380,15 @@ void BibtexImporter::parseText(const QString& text) {
 //  bt_set_stringopts(BTE_PREAMBLE, BTO_CONVERT | BTO_EXPAND);
 
   QString entry;
-  QRegExp rx(QLatin1String("[{}]"));
   QRegExp macroName(QLatin1String("@string\\s*\\{\\s*(.*)="), Qt::CaseInsensitive);
   macroName.setMinimal(true);
+  QByteArray filename = QFile::encodeName(url().fileName());
 
   int line = 1;
   bool needsCleanup = false;
   int brace = 0;
   int startpos = 0;
-  int pos = rx.indexIn(text, 0);
+  int pos = nextBrace(text, 0);
   while(pos > 0 && !m_cancelled) {
     if(text[pos] == QLatin1Char('{')) {
       ++brace;
@@ -288,7 +399,6 @@ void BibtexImporter::parseText(const QString& text) {
       entry = text.mid(startpos, pos-startpos+1);
       // All the downstream text processing on the AST node will assume utf-8
       QByteArray entryText = entry.toUtf8();
-      QByteArray filename = QFile::encodeName(url().fileName());
       AST* node = bt_parse_entry_s(entryText.data(),
                                    filename.data(),
                                    line, bt_options, &ok);
@@ -304,7 +414,7 @@ void BibtexImporter::parseText(const QString& text) {
       startpos = pos+1;
       line += entry.count(QLatin1Char('\n'));
     }
-    pos = rx.indexIn(text, pos+1);
+    pos = nextBrace(text, pos+1);
   }
   if(needsCleanup) {
     // clean up some structures
@@ -24,7 +24,6 @@
 
 #include "csvexporter.h"
 #include "../collection.h"
-#include "../core/filehandler.h"
 
 #include <KLocalizedString>
 #include <KConfigGroup>
@@ -36,6 +35,7 @@
 #include <QGridLayout>
 #include <QVBoxLayout>
 #include <QLabel>
+#include <QTextStream>
 
 using namespace Tellico;
 using Tellico::Export::CSVExporter;
@@ -84,24 +84,38 @@ bool CSVExporter::exec() {
     return false;
   }
 
-  return FileHandler::writeTextURL(url(), text(), options() & ExportUTF8, options() & Export::ExportForce);
+  return writeTextURL();
+}
+
+bool CSVExporter::writeText(QTextStream& ts_) {
+  if(!collection()) {
+    return false;
+  }
+
+  writeCSV(ts_);
+  return true;
 }
 
 QString CSVExporter::text() const {
   QString text;
+  QTextStream ts(&text);
+  writeCSV(ts);
+  ts.flush();
+  return text;
+}
 
+void CSVExporter::writeCSV(QTextStream& ts_) const {
   if(m_includeTitles) {
+    QStringList titles;
     foreach(Data::FieldPtr fIt, fields()) {
       QString title = fIt->title();
       // because of Microsoft Excel bug, http://support.microsoft.com/kb/323626
-      if(text.isEmpty() && title == QLatin1String("ID")) {
+      if(titles.isEmpty() && title == QLatin1String("ID")) {
         title = QStringLiteral("Id");
       }
-      text += escapeText(title) + m_delimiter;
+      titles += escapeText(title);
     }
-    // remove last delimiter
-    text.truncate(text.length() - m_delimiter.length());
-    text += QLatin1Char('\n');
+    ts_ << titles.join(m_delimiter) << QLatin1Char('\n');
   }
 
   FieldFormat::Request format = (options() & Export::ExportFormatted ?
@@ -111,6 +125,7 @@ QString CSVExporter::text() const {
   const bool replaceColDelimiter = (m_colDelimiter != FieldFormat::columnDelimiterString());
   const bool replaceRowDelimiter = (m_rowDelimiter != FieldFormat::rowDelimiterString());
 
+  // each row goes straight to the stream, only one entry is ever held at a time
   foreach(Data::EntryPtr entryIt, entries()) {
     QStringList values;
     foreach(Data::FieldPtr fIt, fields()) {
@@ -123,9 +138,8 @@ QString CSVExporter::text() const {
       }
       values += escapeText(value);
     }
-    text += values.join(m_delimiter) + QLatin1Char('\n');
+    ts_ << values.join(m_delimiter) << QLatin1Char('\n');
   }
-  return text;
 }
 
 QWidget* CSVExporter::widget(QWidget* parent_) {
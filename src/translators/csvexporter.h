@@ -45,6 +45,7 @@ public:
   CSVExporter(Data::CollPtr coll);
 
   virtual bool exec() Q_DECL_OVERRIDE;
+  virtual bool writeText(QTextStream& ts) Q_DECL_OVERRIDE;
   virtual QString formatString() const Q_DECL_OVERRIDE;
   virtual QString fileFilter() const Q_DECL_OVERRIDE;
   QString text() const;
@@ -55,6 +56,7 @@ public:
 
 private:
   QString& escapeText(QString& text) const;
+  void writeCSV(QTextStream& ts) const;
 
   bool m_includeTitles;
   QString m_delimiter;
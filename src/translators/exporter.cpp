@@ -24,10 +24,21 @@
 
 #include "exporter.h"
 #include "../collection.h"
+#include "../core/filehandler.h"
 #include "../tellico_debug.h"
 
 using Tellico::Export::Exporter;
 
+namespace {
+  class ExporterWriter : public Tellico::FileHandler::TextWriter {
+  public:
+    ExporterWriter(Exporter* exporter_) : m_exporter(exporter_) {}
+    virtual bool writeText(QTextStream& ts_) Q_DECL_OVERRIDE { return m_exporter->writeText(ts_); }
+  private:
+    Exporter* m_exporter;
+  };
+}
+
 Exporter::Exporter(Tellico::Data::CollPtr coll) : QObject(), m_options(Export::ExportUTF8), m_coll(coll) {
 }
 
@@ -48,3 +59,13 @@ Tellico::Data::CollPtr Exporter::collection() const {
 const Tellico::Data::FieldList& Exporter::fields() const {
   return m_fields.isEmpty() ? collection()->fields() : m_fields;
 }
+
+bool Exporter::writeText(QTextStream&) {
+  myDebug() << formatString() << "does not write text";
+  return false;
+}
+
+bool Exporter::writeTextURL(bool force_) {
+  ExporterWriter writer(this);
+  return FileHandler::writeTextURL(m_url, &writer, m_options & Export::ExportUTF8, force_ || (m_options & Export::ExportForce));
+}
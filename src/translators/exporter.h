@@ -38,6 +38,7 @@ class KConfig;
 
 class QWidget;
 class QString;
+class QTextStream;
 
 namespace Tellico {
   namespace Export {
@@ -81,6 +82,13 @@ public:
    * Do the export
    */
   virtual bool exec() = 0;
+  /**
+   * Writes the export to a text stream as it is generated, one entry at a time
+   * where the format allows, so that large collections can be written to a file
+   * or a pipe without building the whole output in memory. Only text formats
+   * support it, the default implementation returns false.
+   */
+  virtual bool writeText(QTextStream& ts);
   /**
    * If changing options in the exporter should cause member variables to reset, implement
    * that here
@@ -91,6 +99,14 @@ public:
   virtual void readOptions(KSharedConfigPtr) {}
   virtual void saveOptions(KSharedConfigPtr) {}
 
+protected:
+  /**
+   * Streams the output of writeText() to the export url
+   *
+   * @param force Whether to overwrite an existing file without asking, when the exporter already asked
+   */
+  bool writeTextURL(bool force = false);
+
 private:
   long m_options;
   Data::CollPtr m_coll;
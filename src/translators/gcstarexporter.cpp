@@ -80,16 +80,17 @@ bool GCstarExporter::exec() {
           break;
         }
 
-        const Data::Image& img = ImageFactory::self()->imageById(entry->field(field));
-        if(img.isNull()) {
+        const QString id = entry->field(field);
+        const QByteArray data = ImageFactory::imageData(id);
+        if(data.isEmpty()) {
           break;
         }
 
         QUrl target = QUrl::fromLocalFile(imgDir);
         target = target.adjusted(QUrl::RemoveFilename);
-        target.setPath(target.path() + img.id());
+        target.setPath(target.path() + id);
 //        myDebug() << "Writing" << target.url();
-        success &= FileHandler::writeDataURL(target, img.byteArray(), true /* force */);
+        success &= FileHandler::writeDataURL(target, data, true /* force */);
       }
       if(showProgress && j%stepSize == 0) {
         item.setProgress(j);
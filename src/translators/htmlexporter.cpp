@@ -133,7 +133,7 @@ bool HTMLExporter::exec() {
   ProgressItem::Done done(this);
   ProgressManager::self()->setProgress(this, 20);
 
-  bool success = FileHandler::writeTextURL(url(), text(), options() & Export::ExportUTF8, force);
+  bool success = writeTextURL(force);
   if(m_parseDOM && !m_cancelled) {
     success &= copyFiles() && (!m_exportEntryFiles || writeEntryFiles());
   }
@@ -214,22 +214,81 @@ bool HTMLExporter::loadXSLTFile() {
 }
 
 QString HTMLExporter::text() {
+  QString text;
+  QTextStream ts(&text);
+  if(!writeText(ts)) {
+    return QString();
+  }
+  ts.flush();
+  return text;
+}
+
+bool HTMLExporter::writeText(QTextStream& ts_) {
+  GUI::CursorSaver cs;
+  const QByteArray xml = collectionXML();
+  if(xml.isEmpty()) {
+    return false;
+  }
+
+  if(!m_parseDOM) {
+    // nothing to fix up, so the transformed text goes straight to the stream
+    return m_handler->applyStylesheet(xml, ts_);
+  }
+
+  // the links in the output get rewritten, which needs the whole document parsed
+  QString outputText;
+  QTextStream outputStream(&outputText);
+  if(!m_handler->applyStylesheet(xml, outputStream)) {
+    return false;
+  }
+  outputStream.flush();
+#if 0
+  myDebug() << "Remove debug2 from htmlexporter.cpp";
+  QFile f2(QLatin1String("/tmp/test.html"));
+  if(f2.open(QIODevice::WriteOnly)) {
+    QTextStream t(&f2);
+    t << outputText;
+  }
+  f2.close();
+#endif
+
+  htmlDocPtr htmlDoc = htmlParseDoc(reinterpret_cast<xmlChar*>(outputText.toUtf8().data()), nullptr);
+  xmlNodePtr root = xmlDocGetRootElement(htmlDoc);
+  if(root == nullptr) {
+    myDebug() << "no root";
+    xmlFreeDoc(htmlDoc);
+    ts_ << outputText;
+    return true;
+  }
+  parseDOM(root);
+
+  xmlChar* c;
+  int bytes;
+  htmlDocDumpMemory(htmlDoc, &c, &bytes);
+  if(bytes > 0) {
+    ts_ << QString::fromUtf8(reinterpret_cast<const char*>(c), bytes);
+    xmlFree(c);
+  }
+  xmlFreeDoc(htmlDoc);
+  return true;
+}
+
+QByteArray HTMLExporter::collectionXML() {
   if((!m_handler || !m_handler->isValid()) && !loadXSLTFile()) {
     myWarning() << "error loading xslt file:" << m_xsltFile;
-    return QString();
+    return QByteArray();
   }
 
   Data::CollPtr coll = collection();
   if(!coll) {
     myDebug() << "no collection pointer!";
-    return QString();
+    return QByteArray();
   }
 
   if(m_groupBy.isEmpty()) {
     m_printGrouped = false; // can't group if no groups exist
   }
 
-  GUI::CursorSaver cs;
   writeImages(coll);
 
   // now grab the XML
@@ -249,41 +308,7 @@ QString HTMLExporter::text() {
   }
   f.close();
 #endif
-
-  const QString outputText = m_handler->applyStylesheet(output.toString());
-#if 0
-  myDebug() << "Remove debug2 from htmlexporter.cpp";
-  QFile f2(QLatin1String("/tmp/test.html"));
-  if(f2.open(QIODevice::WriteOnly)) {
-    QTextStream t(&f2);
-    t << outputText;
-//    t << "\n\n-------------------------------------------------------\n\n";
-//    t << Tellico::i18nReplace(outputText);
-  }
-  f2.close();
-#endif
-
-  if(!m_parseDOM) {
-    return outputText;
-  }
-
-  htmlDocPtr htmlDoc = htmlParseDoc(reinterpret_cast<xmlChar*>(outputText.toUtf8().data()), nullptr);
-  xmlNodePtr root = xmlDocGetRootElement(htmlDoc);
-  if(root == nullptr) {
-    myDebug() << "no root";
-    return outputText;
-  }
-  parseDOM(root);
-
-  xmlChar* c;
-  int bytes;
-  htmlDocDumpMemory(htmlDoc, &c, &bytes);
-  QString allText;
-  if(bytes > 0) {
-    allText = QString::fromUtf8(reinterpret_cast<const char*>(c), bytes);
-    xmlFree(c);
-  }
-  return allText;
+  return output.toByteArray();
 }
 
 void HTMLExporter::setFormattingOptions(Tellico::Data::CollPtr coll) {
@@ -465,11 +490,11 @@ void HTMLExporter::writeImages(Tellico::Data::CollPtr coll_) {
         // for link-only images, no need to write it out
         success = ImageFactory::imageInfo(id).linkOnly || ImageFactory::writeCachedImage(id, ImageFactory::TempDir);
       } else {
-        const Data::Image& img = ImageFactory::imageById(id);
+        const QByteArray data = ImageFactory::imageData(id);
         QUrl target = imgDir;
         target = target.adjusted(QUrl::StripTrailingSlash);
         target.setPath(target.path() + QLatin1Char('/') + (id));
-        success = !img.isNull() && FileHandler::writeDataURL(target, img.byteArray(), true);
+        success = !data.isEmpty() && FileHandler::writeDataURL(target, data, true);
       }
       if(!success) {
         myWarning() << "unable to write image file: "
@@ -62,6 +62,7 @@ public:
   ~HTMLExporter();
 
   virtual bool exec() Q_DECL_OVERRIDE;
+  virtual bool writeText(QTextStream& ts) Q_DECL_OVERRIDE;
   virtual void reset() Q_DECL_OVERRIDE;
   virtual QString formatString() const Q_DECL_OVERRIDE;
   virtual QString fileFilter() const Q_DECL_OVERRIDE;
@@ -90,6 +91,7 @@ public Q_SLOTS:
 
 private:
   void setFormattingOptions(Data::CollPtr coll);
+  QByteArray collectionXML();
   void writeImages(Data::CollPtr coll);
   bool writeEntryFiles();
   QUrl fileDir() const;
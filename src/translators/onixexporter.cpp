@@ -46,6 +46,7 @@
 #include <QCheckBox>
 #include <QGroupBox>
 #include <QTextStream>
+#include <QTemporaryFile>
 #include <QVBoxLayout>
 
 using Tellico::Export::ONIXExporter;
@@ -77,14 +78,25 @@ bool ONIXExporter::exec() {
     return false;
   }
 
-  QByteArray xml = text().toUtf8(); // encoded in utf-8
+  // the xml is streamed to a temporary file rather than held in memory
+  QTemporaryFile xmlFile;
+  if(!xmlFile.open()) {
+    return false;
+  }
+  QTextStream ts(&xmlFile);
+  ts.setCodec("UTF-8"); // encoded in utf-8
+  if(!writeText(ts)) {
+    return false;
+  }
+  ts.flush();
+  xmlFile.close();
 
   QByteArray data;
   QBuffer buf(&data);
 
   KZip zip(&buf);
   zip.open(QIODevice::WriteOnly);
-  zip.writeFile(QStringLiteral("onix.xml"), xml);
+  zip.addLocalFile(xmlFile.fileName(), QStringLiteral("onix.xml"));
 
   // use a dict for fast random access to keep track of which images were written to the file
   if(m_includeImages) { // for now, we're ignoring (options() & Export::ExportImages)
@@ -107,16 +119,26 @@ bool ONIXExporter::exec() {
 }
 
 QString ONIXExporter::text() {
+  QString text;
+  QTextStream ts(&text);
+  if(!writeText(ts)) {
+    return QString();
+  }
+  ts.flush();
+  return text;
+}
+
+bool ONIXExporter::writeText(QTextStream& ts_) {
   QString xsltFile = DataFileRegistry::self()->locate(m_xsltFile);
   if(xsltFile.isNull()) {
     myDebug() << "no xslt file for " << m_xsltFile;
-    return QString();
+    return false;
   }
 
   Data::CollPtr coll = collection();
   if(!coll) {
     myDebug() << "no collection pointer!";
-    return QString();
+    return false;
   }
 
   // notes about utf-8 encoding:
@@ -130,7 +152,7 @@ QString ONIXExporter::text() {
   QDomDocument dom = FileHandler::readXMLDocument(u, false);
   if(dom.isNull()) {
     myDebug() << "error loading xslt file: " << xsltFile;
-    return QString();
+    return false;
   }
 
   // the stylesheet prints utf-8 by default, if using locale encoding, need
@@ -165,7 +187,7 @@ QString ONIXExporter::text() {
   }
   f.close();
 #endif
-  return m_handler->applyStylesheet(output.toString());
+  return m_handler->applyStylesheet(output.toByteArray(), ts_);
 }
 
 QWidget* ONIXExporter::widget(QWidget* parent_) {
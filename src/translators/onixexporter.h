@@ -47,6 +47,7 @@ public:
   ~ONIXExporter();
 
   virtual bool exec() Q_DECL_OVERRIDE;
+  virtual bool writeText(QTextStream& ts) Q_DECL_OVERRIDE;
   virtual QString formatString() const Q_DECL_OVERRIDE;
   virtual QString fileFilter() const Q_DECL_OVERRIDE;
 
@@ -0,0 +1,445 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tellicocache.h"
+#include "../collectionfactory.h"
+#include "../collections/bibtexcollection.h"
+#include "../entry.h"
+#include "../field.h"
+#include "../filter.h"
+#include "../borrower.h"
+#include "../images/imagefactory.h"
+#include "../images/imageinfo.h"
+#include "../core/filehandler.h"
+#include "../utils/stringset.h"
+#include "../utils/tracer.h"
+#include "../tellico_debug.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+
+using Tellico::TellicoCache;
+
+namespace {
+  static const quint32 CACHE_MAGIC = 0x54434348; // "TCCH"
+  static const quint32 CACHE_END = 0x54434345; // "TCCE"
+  // increase whenever anything about the layout changes, older caches are ignored
+  static const quint32 CACHE_VERSION = 1;
+  static const QDataStream::Version CACHE_STREAM_VERSION = QDataStream::Qt_5_4;
+
+  inline qint64 modifiedTime(const QFileInfo& info_) {
+    return info_.lastModified().toMSecsSinceEpoch();
+  }
+}
+
+TellicoCache::TellicoCache(const QUrl& url_) : m_url(url_), m_headerSize(0), m_embeddedImages(false) {
+}
+
+TellicoCache::~TellicoCache() {
+}
+
+QUrl TellicoCache::cacheURL(const QUrl& url_) {
+  QUrl cache = url_.adjusted(QUrl::RemoveFilename);
+  cache.setPath(cache.path() + QLatin1Char('.') + url_.fileName() + QLatin1String(".cache"));
+  return cache;
+}
+
+void TellicoCache::remove(const QUrl& url_) {
+  if(url_.isLocalFile()) {
+    QFile::remove(cacheURL(url_).toLocalFile());
+  }
+}
+
+bool TellicoCache::isCurrent() {
+  if(m_headerSize > 0) {
+    return true;
+  }
+  if(!m_url.isLocalFile()) {
+    return false;
+  }
+  const QFileInfo dataInfo(m_url.toLocalFile());
+  if(!dataInfo.exists()) {
+    return false;
+  }
+
+  m_file.reset(new QFile(cacheURL(m_url).toLocalFile()));
+  if(!m_file->exists() || !m_file->open(QIODevice::ReadOnly)) {
+    m_file.reset();
+    return false;
+  }
+  const qint64 cacheSize = m_file->size();
+  uchar* mapped = m_file->map(0, cacheSize);
+  if(mapped) {
+    m_data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), cacheSize);
+  } else {
+    m_data = m_file->readAll();
+  }
+
+  QBuffer buffer(&m_data);
+  buffer.open(QIODevice::ReadOnly);
+  QDataStream in(&buffer);
+  in.setVersion(CACHE_STREAM_VERSION);
+
+  quint32 magic, version;
+  qint64 size, modified;
+  QByteArray hash;
+  in >> magic >> version;
+  if(in.status() != QDataStream::Ok || magic != CACHE_MAGIC || version != CACHE_VERSION) {
+    return false;
+  }
+  in >> size >> modified >> hash >> m_embeddedImages;
+  // the hash is only worth computing when the size and time already match
+  if(in.status() != QDataStream::Ok ||
+     size != dataInfo.size() ||
+     modified != modifiedTime(dataInfo) ||
+     hash != FileHandler::fileHash(dataInfo.absoluteFilePath())) {
+    myDebug() << "ignoring stale cache for" << m_url.toLocalFile();
+    return false;
+  }
+  m_headerSize = buffer.pos();
+  return true;
+}
+
+Tellico::Data::CollPtr TellicoCache::collection() {
+  if(!isCurrent()) {
+    return Data::CollPtr();
+  }
+  QBuffer buffer(&m_data);
+  buffer.open(QIODevice::ReadOnly);
+  buffer.seek(m_headerSize);
+  QDataStream in(&buffer);
+  in.setVersion(CACHE_STREAM_VERSION);
+
+  Data::CollPtr coll = readCollection(in);
+  // the strings have all been copied out of the mapped file
+  m_data.clear();
+  m_file.reset();
+  m_headerSize = 0;
+  if(!coll) {
+    myWarning() << "unable to read cache for" << m_url.toLocalFile();
+  }
+  return coll;
+}
+
+Tellico::Data::CollPtr TellicoCache::readCollection(QDataStream& in) {
+  qint32 collType;
+  QString collTitle;
+  in >> collType >> collTitle;
+  if(in.status() != QDataStream::Ok) {
+    return Data::CollPtr();
+  }
+  Data::CollPtr coll = CollectionFactory::collection(collType, false);
+  if(!coll) {
+    return Data::CollPtr();
+  }
+  coll->setTitle(collTitle);
+
+  quint32 fieldCount;
+  in >> fieldCount;
+  Data::FieldList fields;
+  for(quint32 i = 0; i < fieldCount && in.status() == QDataStream::Ok; ++i) {
+    QString name, title, category, description;
+    qint32 type, flags, formatType;
+    QStringList allowed;
+    Data::StringMap properties;
+    in >> name >> title >> category >> description >> type >> flags >> formatType >> allowed >> properties;
+    Data::FieldPtr field;
+    if(type == Data::Field::Choice) {
+      field = new Data::Field(name, title, allowed);
+    } else {
+      field = new Data::Field(name, title, static_cast<Data::Field::Type>(type));
+    }
+    field->setCategory(category);
+    field->setFlags(flags);
+    field->setFormatType(static_cast<FieldFormat::Type>(formatType));
+    field->setDescription(description);
+    field->setPropertyList(properties);
+    fields.append(field);
+  }
+  if(in.status() != QDataStream::Ok) {
+    return Data::CollPtr();
+  }
+  coll->addFields(fields);
+  // the field names in the entries are shared with the fields
+  QStringList fieldNames;
+  foreach(Data::FieldPtr field, fields) {
+    fieldNames << field->name();
+  }
+
+  if(coll->type() == Data::Collection::Bibtex) {
+    QString preamble;
+    Data::StringMap macros;
+    in >> preamble >> macros;
+    Data::BibtexCollection* c = static_cast<Data::BibtexCollection*>(coll.data());
+    c->setPreamble(preamble);
+    for(Data::StringMap::ConstIterator it = macros.constBegin(); it != macros.constEnd(); ++it) {
+      c->addMacro(it.key(), it.value());
+    }
+  }
+
+  // every distinct value is read once, and shared by all the entries which use it
+  quint32 stringCount;
+  in >> stringCount;
+  QVector<QString> strings;
+  strings.reserve(stringCount);
+  for(quint32 i = 0; i < stringCount && in.status() == QDataStream::Ok; ++i) {
+    QString s;
+    in >> s;
+    strings.append(s);
+  }
+
+  quint32 entryCount;
+  in >> entryCount;
+  Data::EntryList entries;
+  entries.reserve(entryCount);
+  for(quint32 i = 0; i < entryCount && in.status() == QDataStream::Ok; ++i) {
+    qint32 id;
+    quint32 valueCount;
+    in >> id >> valueCount;
+    QHash<QString, QString> values;
+    values.reserve(valueCount);
+    for(quint32 j = 0; j < valueCount; ++j) {
+      quint32 fieldIndex, stringIndex;
+      in >> fieldIndex >> stringIndex;
+      if(fieldIndex >= static_cast<quint32>(fieldNames.count()) ||
+         stringIndex >= static_cast<quint32>(strings.count())) {
+        myDebug() << "bad index in cache";
+        return Data::CollPtr();
+      }
+      values.insert(fieldNames.at(fieldIndex), strings.at(stringIndex));
+    }
+    Data::EntryPtr entry(new Data::Entry(coll, id));
+    entry->setFieldValues(values);
+    entries.append(entry);
+  }
+  if(in.status() != QDataStream::Ok) {
+    return Data::CollPtr();
+  }
+  coll->addEntries(entries);
+
+  quint32 imageCount;
+  in >> imageCount;
+  for(quint32 i = 0; i < imageCount && in.status() == QDataStream::Ok; ++i) {
+    QString id;
+    QByteArray format;
+    qint32 width, height;
+    bool linkOnly;
+    in >> id >> format >> width >> height >> linkOnly;
+    // anything already loaded is more current
+    if(!ImageFactory::hasImageInfo(id)) {
+      ImageFactory::cacheImageInfo(Data::ImageInfo(id, format, width, height, linkOnly));
+    }
+  }
+
+  quint32 filterCount;
+  in >> filterCount;
+  for(quint32 i = 0; i < filterCount && in.status() == QDataStream::Ok; ++i) {
+    QString name;
+    qint32 op;
+    quint32 ruleCount;
+    in >> name >> op >> ruleCount;
+    FilterPtr filter(new Filter(static_cast<Filter::FilterOp>(op)));
+    filter->setName(name);
+    for(quint32 j = 0; j < ruleCount && in.status() == QDataStream::Ok; ++j) {
+      QString fieldName, pattern;
+      qint32 function;
+      in >> fieldName >> pattern >> function;
+      filter->append(new FilterRule(fieldName, pattern, static_cast<FilterRule::Function>(function)));
+    }
+    if(!filter->isEmpty()) {
+      coll->addFilter(filter);
+    }
+  }
+
+  quint32 borrowerCount;
+  in >> borrowerCount;
+  for(quint32 i = 0; i < borrowerCount && in.status() == QDataStream::Ok; ++i) {
+    QString name, uid;
+    quint32 loanCount;
+    in >> name >> uid >> loanCount;
+    Data::BorrowerPtr borrower(new Data::Borrower(name, uid));
+    for(quint32 j = 0; j < loanCount && in.status() == QDataStream::Ok; ++j) {
+      qint32 entryId;
+      QString loanUid, note;
+      QDate loanDate, dueDate;
+      bool inCalendar;
+      in >> entryId >> loanUid >> loanDate >> dueDate >> note >> inCalendar;
+      Data::EntryPtr entry = coll->entryById(entryId);
+      if(!entry) {
+        continue;
+      }
+      Data::LoanPtr loan(new Data::Loan(entry, loanDate, dueDate, note));
+      loan->setUID(loanUid);
+      loan->setInCalendar(inCalendar);
+      borrower->addLoan(loan);
+    }
+    if(!borrower->isEmpty()) {
+      coll->addBorrower(borrower);
+    }
+  }
+
+  quint32 end;
+  in >> m_groupFieldHints >> end;
+  if(in.status() != QDataStream::Ok || end != CACHE_END) {
+    m_groupFieldHints.clear();
+    return Data::CollPtr();
+  }
+  return coll;
+}
+
+bool TellicoCache::write(Tellico::Data::CollPtr coll_, bool embeddedImages_) {
+  if(!coll_ || !m_url.isLocalFile()) {
+    return false;
+  }
+  TRACE_SCOPE("file", "writeCache");
+  const QFileInfo dataInfo(m_url.toLocalFile());
+  const QByteArray hash = FileHandler::fileHash(dataInfo.absoluteFilePath());
+  if(hash.isEmpty()) {
+    return false;
+  }
+
+  QSaveFile file(cacheURL(m_url).toLocalFile());
+  if(!file.open(QIODevice::WriteOnly)) {
+    myDebug() << "unable to write cache" << file.fileName();
+    return false;
+  }
+  QDataStream out(&file);
+  out.setVersion(CACHE_STREAM_VERSION);
+  out << CACHE_MAGIC << CACHE_VERSION
+      << dataInfo.size() << modifiedTime(dataInfo) << hash << embeddedImages_;
+
+  out << qint32(coll_->type()) << coll_->title();
+
+  const Data::FieldList fields = coll_->fields();
+  out << quint32(fields.count());
+  foreach(Data::FieldPtr field, fields) {
+    out << field->name() << field->title() << field->category() << field->description()
+        << qint32(field->type()) << qint32(field->flags()) << qint32(field->formatType())
+        << field->allowed() << field->propertyList();
+  }
+
+  if(coll_->type() == Data::Collection::Bibtex) {
+    const Data::BibtexCollection* c = static_cast<const Data::BibtexCollection*>(coll_.data());
+    out << c->preamble() << c->macroList();
+  }
+
+  // the values are numbered in a first pass, since all the strings come before the entries
+  QHash<QString, quint32> stringIndex;
+  QVector<QString> strings;
+  QVector<quint32> entryValues;
+  QVector<int> valueCounts;
+  StringSet imageIds;
+  foreach(Data::EntryPtr entry, coll_->entries()) {
+    int count = 0;
+    for(int i = 0; i < fields.count(); ++i) {
+      Data::FieldPtr field = fields.at(i);
+      // derived values are never stored
+      if(field->hasFlag(Data::Field::Derived)) {
+        continue;
+      }
+      const QString value = entry->field(field);
+      if(value.isEmpty()) {
+        continue;
+      }
+      QHash<QString, quint32>::ConstIterator it = stringIndex.constFind(value);
+      if(it == stringIndex.constEnd()) {
+        it = stringIndex.insert(value, strings.count());
+        strings.append(value);
+      }
+      entryValues << quint32(i) << it.value();
+      ++count;
+      if(field->type() == Data::Field::Image) {
+        imageIds.add(value);
+      }
+    }
+    valueCounts << count;
+  }
+
+  out << quint32(strings.count());
+  foreach(const QString& s, strings) {
+    out << s;
+  }
+
+  out << quint32(valueCounts.count());
+  int pos = 0;
+  int entryIndex = 0;
+  foreach(Data::EntryPtr entry, coll_->entries()) {
+    const int count = valueCounts.at(entryIndex++);
+    out << qint32(entry->id()) << quint32(count);
+    for(int i = 0; i < 2*count; ++i) {
+      out << entryValues.at(pos++);
+    }
+  }
+
+  QList<Data::ImageInfo> imageInfos;
+  foreach(const QString& id, imageIds) {
+    if(ImageFactory::hasImageInfo(id)) {
+      imageInfos << ImageFactory::imageInfo(id);
+    }
+  }
+  out << quint32(imageInfos.count());
+  foreach(const Data::ImageInfo& info, imageInfos) {
+    // don't load the image just to get the size
+    out << info.id << info.format << qint32(info.width(false)) << qint32(info.height(false))
+        << bool(info.linkOnly);
+  }
+
+  out << quint32(coll_->filters().count());
+  foreach(FilterPtr filter, coll_->filters()) {
+    out << filter->name() << qint32(filter->op()) << quint32(filter->count());
+    foreach(const FilterRule* rule, static_cast<const QList<FilterRule*>&>(*filter)) {
+      out << rule->fieldName() << rule->pattern() << qint32(rule->function());
+    }
+  }
+
+  out << quint32(coll_->borrowers().count());
+  foreach(Data::BorrowerPtr borrower, coll_->borrowers()) {
+    out << borrower->name() << borrower->uid() << quint32(borrower->loans().count());
+    foreach(Data::LoanPtr loan, borrower->loans()) {
+      Data::EntryPtr entry = loan->entry();
+      out << qint32(entry ? entry->id() : -1) << loan->uid() << loan->loanDate() << loan->dueDate()
+          << loan->note() << loan->inCalendar();
+    }
+  }
+
+  QStringList groupFields;
+  QStringList groupNames = coll_->fieldNames();
+  groupNames << Data::Collection::s_peopleGroupName;
+  foreach(const QString& name, groupNames) {
+    if(coll_->isEntryGroupDictPopulated(name)) {
+      groupFields << name;
+    }
+  }
+  out << groupFields << CACHE_END;
+
+  if(out.status() != QDataStream::Ok || !file.commit()) {
+    myDebug() << "unable to write cache" << file.fileName();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,113 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_TELLICOCACHE_H
+#define TELLICO_TELLICOCACHE_H
+
+#include "../datavectors.h"
+
+#include <QUrl>
+#include <QStringList>
+#include <QByteArray>
+#include <QScopedPointer>
+
+class QDataStream;
+class QFile;
+
+namespace Tellico {
+
+/**
+ * The TellicoCache reads and writes a compact binary copy of a collection, kept next to
+ * the data file. Reading the cache skips all the XML parsing and the checking of every
+ * value, so a file opens much faster the next time, as long as it has not changed.
+ *
+ * The cache is only used when the size, the modification time, and the hash of the data
+ * file all match what was recorded when the cache was written. Each distinct string is
+ * only stored once, and the entries refer to it by index. Image data is not cached, only
+ * the image info.
+ *
+ * @author Robby Stephenson
+ */
+class TellicoCache {
+public:
+  /**
+   * @param url The url of the data file, not the cache
+   */
+  explicit TellicoCache(const QUrl& url);
+  ~TellicoCache();
+
+  /**
+   * Returns the location of the cache for a data file
+   */
+  static QUrl cacheURL(const QUrl& url);
+  /**
+   * Removes the cache for a data file, if there is one
+   */
+  static void remove(const QUrl& url);
+
+  /**
+   * Returns true if the cache exists and was written for the current version of the
+   * data file. The cache file is memory-mapped, if possible.
+   */
+  bool isCurrent();
+  /**
+   * Returns true if the data file itself holds the image data, which is not cached.
+   */
+  bool hasEmbeddedImages() const { return m_embeddedImages; }
+  /**
+   * Reads the collection from the cache, along with the image info for the entries.
+   * A null pointer is returned if the cache is not current or can't be read.
+   */
+  Data::CollPtr collection();
+  /**
+   * Returns the names of the fields whose groups were populated when the cache was written,
+   * so they are likely to be needed again.
+   */
+  const QStringList& groupFieldHints() const { return m_groupFieldHints; }
+
+  /**
+   * Writes the cache for the collection, which must match the data file as it was just
+   * read or written.
+   *
+   * @param coll The collection
+   * @param embeddedImages Whether the data file itself holds the image data
+   * @return Whether the cache was written successfully
+   */
+  bool write(Data::CollPtr coll, bool embeddedImages);
+
+private:
+  Q_DISABLE_COPY(TellicoCache)
+  Data::CollPtr readCollection(QDataStream& in);
+
+  const QUrl m_url;
+  QScopedPointer<QFile> m_file;
+  // points to the mapped file, or holds all of it if the file could not be mapped
+  QByteArray m_data;
+  qint64 m_headerSize;
+  bool m_embeddedImages;
+  QStringList m_groupFieldHints;
+};
+
+} // end namespace
+#endif
@@ -25,6 +25,8 @@
 #include "tellicoimporter.h"
 #include "tellicoxmlhandler.h"
 #include "tellico_xml.h"
+#include "tellicocache.h"
+#include "tellicojournal.h"
 #include "../collectionfactory.h"
 #include "../entry.h"
 #include "../field.h"
@@ -34,6 +36,8 @@
 #include "../core/tellico_strings.h"
 #include "../utils/guiproxy.h"
 #include "../utils/tellico_utils.h"
+#include "../config/tellico_config.h"
+#include "../utils/tracer.h"
 #include "../tellico_debug.h"
 
 #include <KLocalizedString>
@@ -47,17 +51,74 @@
 
 using Tellico::Import::TellicoImporter;
 
+namespace {
+  inline QString fromXmlChar(const xmlChar* str_) {
+    return QString::fromUtf8(reinterpret_cast<const char*>(str_));
+  }
+
+  // feeds the nodes to the SAX handler, just as if the serialized document had been parsed
+  bool readNodes(xmlNodePtr node_, QXmlDefaultHandler& handler_) {
+    for(xmlNodePtr node = node_; node; node = node->next) {
+      if(node->type == XML_ELEMENT_NODE) {
+        const QString localName = fromXmlChar(node->name);
+        QString nsURI;
+        QString qName = localName;
+        if(node->ns) {
+          nsURI = fromXmlChar(node->ns->href);
+          if(node->ns->prefix) {
+            qName = fromXmlChar(node->ns->prefix) + QLatin1Char(':') + localName;
+          }
+        }
+        QXmlAttributes atts;
+        for(xmlAttrPtr attr = node->properties; attr; attr = attr->next) {
+          const QString attName = fromXmlChar(attr->name);
+          QString attNsURI;
+          QString attQName = attName;
+          if(attr->ns) {
+            attNsURI = fromXmlChar(attr->ns->href);
+            if(attr->ns->prefix) {
+              attQName = fromXmlChar(attr->ns->prefix) + QLatin1Char(':') + attName;
+            }
+          }
+          xmlChar* value = xmlNodeListGetString(node->doc, attr->children, 1);
+          atts.append(attQName, attNsURI, attName, fromXmlChar(value));
+          xmlFree(value);
+        }
+        if(!handler_.startElement(nsURI, localName, qName, atts) ||
+           !readNodes(node->children, handler_) ||
+           !handler_.endElement(nsURI, localName, qName)) {
+          return false;
+        }
+      } else if(node->type == XML_TEXT_NODE || node->type == XML_CDATA_SECTION_NODE) {
+        if(!handler_.characters(fromXmlChar(node->content))) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+}
+
 TellicoImporter::TellicoImporter(const QUrl& url_, bool loadAllImages_) : DataImporter(url_),
     m_loadAllImages(loadAllImages_), m_format(Unknown), m_modified(false),
-    m_cancelled(false), m_hasImages(false), m_buffer(nullptr), m_zip(nullptr), m_imgDir(nullptr) {
+    m_cancelled(false), m_hasImages(false), m_loadedFromCache(false), m_buffer(nullptr), m_zip(nullptr), m_imgDir(nullptr), m_doc(nullptr) {
 }
 
 TellicoImporter::TellicoImporter(const QString& text_) : DataImporter(text_),
     m_loadAllImages(true), m_format(Unknown), m_modified(false),
-    m_cancelled(false), m_hasImages(false), m_buffer(nullptr), m_zip(nullptr), m_imgDir(nullptr) {
+    m_cancelled(false), m_hasImages(false), m_loadedFromCache(false), m_buffer(nullptr), m_zip(nullptr), m_imgDir(nullptr), m_doc(nullptr) {
+}
+
+TellicoImporter::TellicoImporter(xmlDocPtr doc_) : DataImporter(QString()),
+    m_loadAllImages(true), m_format(Unknown), m_modified(false),
+    m_cancelled(false), m_hasImages(false), m_loadedFromCache(false), m_buffer(nullptr), m_zip(nullptr), m_imgDir(nullptr), m_doc(doc_) {
 }
 
 TellicoImporter::~TellicoImporter() {
+  if(m_doc) {
+    xmlFreeDoc(m_doc);
+    m_doc = nullptr;
+  }
   delete m_zip;
   m_zip = nullptr;
   delete m_buffer;
@@ -69,6 +130,14 @@ Tellico::Data::CollPtr TellicoImporter::collection() {
     return m_coll;
   }
 
+  if(m_doc) {
+    m_format = XML;
+    loadXMLDoc(m_doc);
+    xmlFreeDoc(m_doc);
+    m_doc = nullptr;
+    return m_coll;
+  }
+
   QByteArray s; // read first 5 characters
   if(source() == URL) {
     if(!fileRef().open()) {
@@ -97,15 +166,27 @@ Tellico::Data::CollPtr TellicoImporter::collection() {
   // if the first 5 characters are <?xml then treat it like text
   if(s[0] == '<' && s[1] == '?' && s[2] == 'x' && s[3] == 'm' && s[4] == 'l') {
     m_format = XML;
-    loadXMLData(source() == URL ? fileRef().file()->readAll() : data(), true);
+    if(!loadCache()) {
+      loadXMLData(source() == URL ? fileRef().file()->readAll() : data(), true);
+    }
   } else {
     m_format = Zip;
     loadZipData();
   }
-  return thisPtr ? m_coll : Data::CollPtr();
+  if(!thisPtr) {
+    return Data::CollPtr();
+  }
+  // every reader of the file has to see the changes saved to the journal
+  if(m_coll && source() == URL && !m_cancelled) {
+    TellicoJournal journal(url());
+    m_journalEntryIds = journal.apply(m_coll);
+    m_journalFileHash = journal.appliedFileHash();
+  }
+  return m_coll;
 }
 
 void TellicoImporter::loadXMLData(const QByteArray& data_, bool loadImages_) {
+  TRACE_SCOPE("file", "parseXML");
   const bool showProgress = options() & ImportProgress;
 
   TellicoXMLHandler handler;
@@ -158,6 +239,24 @@ void TellicoImporter::loadXMLData(const QByteArray& data_, bool loadImages_) {
   }
 }
 
+void TellicoImporter::loadXMLDoc(xmlDocPtr doc_) {
+  TellicoXMLHandler handler;
+  handler.setLoadImages(true);
+  handler.setShowImageLoadErrors(options() & ImportShowImageErrors);
+
+  xmlNodePtr root = xmlDocGetRootElement(doc_);
+  if(!root || !readNodes(root, handler)) {
+    m_format = Error;
+    const QString error = handler.errorString();
+    myDebug() << error;
+    setStatusMessage(error);
+    return;
+  }
+
+  m_hasImages = handler.hasImages();
+  m_coll = handler.collection();
+}
+
 void TellicoImporter::loadZipData() {
   delete m_buffer;
   delete m_zip;
@@ -209,12 +308,14 @@ void TellicoImporter::loadZipData() {
     return;
   }
 
-  const QByteArray xmlData = static_cast<const KArchiveFile*>(entry)->data();
   // hack to account for processEvents and deletion
   QPointer<TellicoImporter> thisPtr(this);
-  loadXMLData(xmlData, false);
-  if(!thisPtr) {
-    return;
+  if(!loadCache()) {
+    const QByteArray xmlData = static_cast<const KArchiveFile*>(entry)->data();
+    loadXMLData(xmlData, false);
+    if(!thisPtr) {
+      return;
+    }
   }
   if(!m_coll) {
     m_format = Error;
@@ -274,6 +375,26 @@ void TellicoImporter::loadZipData() {
   }
 }
 
+bool TellicoImporter::loadCache() {
+  if(source() != URL || !url().isLocalFile() || !Config::cacheFiles()) {
+    return false;
+  }
+  TRACE_SCOPE("file", "readCache");
+  TellicoCache cache(url());
+  // the image data is not cached, so the file has to be read anyway
+  if(!cache.isCurrent() || (m_format == XML && cache.hasEmbeddedImages())) {
+    return false;
+  }
+  Data::CollPtr coll = cache.collection();
+  if(!coll) {
+    return false;
+  }
+  m_coll = coll;
+  m_groupFieldHints = cache.groupFieldHints();
+  m_loadedFromCache = true;
+  return true;
+}
+
 bool TellicoImporter::hasImages() const {
   return m_hasImages;
 }
@@ -29,6 +29,9 @@
 #include "../datavectors.h"
 #include "../utils/stringset.h"
 
+// for xmlDocPtr
+#include <libxml/tree.h>
+
 class QBuffer;
 class KZip;
 class KArchiveDirectory;
@@ -55,6 +58,12 @@ public:
    * @param text The text
    */
   explicit TellicoImporter(const QString& text);
+  /**
+   * Reads the collection straight from a parsed document, such as the result of an XSLT
+   * transformation, without serializing it and parsing it again. The importer takes
+   * ownership of the document.
+   */
+  explicit TellicoImporter(xmlDocPtr doc);
   virtual ~TellicoImporter();
 
   /**
@@ -73,6 +82,24 @@ public:
 
   bool hasImages() const;
   bool loadImage(const QString& id_);
+  /**
+   * Returns true if the collection was read from the cache instead of the data file itself.
+   * The cache is only read for local files, when enabled in the configuration.
+   */
+  bool loadedFromCache() const { return m_loadedFromCache; }
+  /**
+   * Returns the names of the fields which were grouped when the cache was written.
+   */
+  const QStringList& groupFieldHints() const { return m_groupFieldHints; }
+  /**
+   * Returns the IDs of the entries whose values were read from the journal, which holds
+   * the entries saved since the file was last written completely.
+   */
+  const QList<Data::ID>& journalEntryIds() const { return m_journalEntryIds; }
+  /**
+   * Returns the hash of the data file, if it was computed to check the journal.
+   */
+  const QByteArray& journalFileHash() const { return m_journalFileHash; }
 
   // take ownership of zip object with images
   KZip* takeImages();
@@ -84,7 +111,9 @@ public Q_SLOTS:
 
 private:
   void loadXMLData(const QByteArray& data, bool loadImages);
+  void loadXMLDoc(xmlDocPtr doc);
   void loadZipData();
+  bool loadCache();
 
   Data::CollPtr m_coll;
   bool m_loadAllImages;
@@ -93,11 +122,16 @@ private:
   bool m_modified;
   bool m_cancelled;
   bool m_hasImages;
+  bool m_loadedFromCache;
   StringSet m_images;
+  QStringList m_groupFieldHints;
+  QList<Data::ID> m_journalEntryIds;
+  QByteArray m_journalFileHash;
 
   QBuffer* m_buffer;
   KZip* m_zip;
   const KArchiveDirectory* m_imgDir;
+  xmlDocPtr m_doc;
 };
 
   } // end namespace
@@ -0,0 +1,144 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tellicojournal.h"
+#include "tellicoimporter.h"
+#include "../collection.h"
+#include "../entry.h"
+#include "../field.h"
+#include "../core/filehandler.h"
+#include "../tellico_debug.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+
+using Tellico::TellicoJournal;
+
+namespace {
+  // the journal starts with a single line identifying the data file, followed by the XML
+  static const char* JOURNAL_MAGIC = "TellicoJournal";
+  static const int JOURNAL_VERSION = 2;
+
+  inline qint64 modifiedTime(const QFileInfo& info_) {
+    return info_.lastModified().toMSecsSinceEpoch();
+  }
+}
+
+TellicoJournal::TellicoJournal(const QUrl& url_) : m_url(url_) {
+}
+
+QUrl TellicoJournal::journalURL(const QUrl& url_) {
+  QUrl journal = url_.adjusted(QUrl::RemoveFilename);
+  journal.setPath(journal.path() + QLatin1Char('.') + url_.fileName() + QLatin1String(".journal"));
+  return journal;
+}
+
+void TellicoJournal::remove(const QUrl& url_) {
+  if(url_.isLocalFile()) {
+    QFile::remove(journalURL(url_).toLocalFile());
+  }
+}
+
+QByteArray TellicoJournal::fileHash(const QUrl& url_) {
+  return url_.isLocalFile() ? FileHandler::fileHash(url_.toLocalFile()).toHex() : QByteArray();
+}
+
+bool TellicoJournal::write(const QByteArray& text_, const QByteArray& hash_) {
+  if(text_.isEmpty() || hash_.isEmpty() || !m_url.isLocalFile()) {
+    return false;
+  }
+  const QFileInfo dataInfo(m_url.toLocalFile());
+  if(!dataInfo.exists()) {
+    return false;
+  }
+
+  QByteArray header(JOURNAL_MAGIC);
+  header += ' ' + QByteArray::number(JOURNAL_VERSION)
+          + ' ' + QByteArray::number(dataInfo.size())
+          + ' ' + QByteArray::number(modifiedTime(dataInfo))
+          + ' ' + hash_ + '\n';
+
+  QSaveFile file(journalURL(m_url).toLocalFile());
+  if(!file.open(QIODevice::WriteOnly)) {
+    myDebug() << "unable to write journal" << file.fileName();
+    return false;
+  }
+  file.write(header);
+  file.write(text_);
+  return file.commit();
+}
+
+QList<Tellico::Data::ID> TellicoJournal::apply(Tellico::Data::CollPtr coll_) {
+  QList<Data::ID> ids;
+  if(!coll_ || !m_url.isLocalFile()) {
+    return ids;
+  }
+  QFile file(journalURL(m_url).toLocalFile());
+  if(!file.exists() || !file.open(QIODevice::ReadOnly)) {
+    return ids;
+  }
+
+  // the header has the magic, the version, and the size, the time, and the hash of the data file
+  const QList<QByteArray> header = file.readLine().trimmed().split(' ');
+  if(header.count() != 5 || header.at(0) != JOURNAL_MAGIC || header.at(1).toInt() != JOURNAL_VERSION) {
+    myDebug() << "ignoring unknown journal" << file.fileName();
+    return ids;
+  }
+  // the hash is only worth computing when the size and time already match
+  const QFileInfo dataInfo(m_url.toLocalFile());
+  if(header.at(2).toLongLong() != dataInfo.size() || header.at(3).toLongLong() != modifiedTime(dataInfo)) {
+    // the file was written by something else after the journal
+    myDebug() << "ignoring stale journal" << file.fileName();
+    return ids;
+  }
+  const QByteArray hash = FileHandler::fileHash(dataInfo.absoluteFilePath()).toHex();
+  if(header.at(4) != hash) {
+    myDebug() << "ignoring stale journal" << file.fileName();
+    return ids;
+  }
+
+  Import::TellicoImporter importer(QString::fromUtf8(file.readAll()));
+  Data::CollPtr journalColl = importer.collection();
+  if(!journalColl || journalColl->type() != coll_->type()) {
+    myWarning() << "unable to read journal" << file.fileName();
+    return ids;
+  }
+  foreach(Data::EntryPtr journalEntry, journalColl->entries()) {
+    Data::EntryPtr entry = coll_->entryById(journalEntry->id());
+    if(!entry) {
+      continue;
+    }
+    foreach(Data::FieldPtr field, coll_->fields()) {
+      if(journalColl->hasField(field->name())) {
+        entry->setField(field->name(), journalEntry->field(field->name()), false);
+      }
+    }
+    ids << entry->id();
+  }
+  // the document keeps the hash for writing the journal again
+  m_fileHash = hash;
+  return ids;
+}
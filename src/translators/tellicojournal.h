@@ -0,0 +1,96 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_TELLICOJOURNAL_H
+#define TELLICO_TELLICOJOURNAL_H
+
+#include "../datavectors.h"
+
+#include <QUrl>
+#include <QByteArray>
+
+namespace Tellico {
+
+/**
+ * The TellicoJournal holds the entries which were modified since the data file was last
+ * written completely. The journal is kept next to the data file, and saving a few changed
+ * entries to it is much faster than rewriting a large file.
+ *
+ * The journal records the size, the modification time, and the hash of the data file it
+ * belongs to, and it is only applied to that exact file. Hashing a large file takes a while,
+ * so the hash is computed once by the document and passed to every write of the journal.
+ * The @ref Import::TellicoImporter applies the journal whenever the data file is read, so
+ * importing or merging the file includes the journaled changes, too.
+ *
+ * @author Robby Stephenson
+ */
+class TellicoJournal {
+public:
+  /**
+   * @param url The url of the data file, not the journal
+   */
+  explicit TellicoJournal(const QUrl& url);
+
+  /**
+   * Returns the location of the journal for a data file
+   */
+  static QUrl journalURL(const QUrl& url);
+  /**
+   * Removes the journal for a data file, if there is one
+   */
+  static void remove(const QUrl& url);
+  /**
+   * Returns the hash of the data file, as recorded in the journal. The whole file is read.
+   */
+  static QByteArray fileHash(const QUrl& url);
+
+  /**
+   * Writes the modified entries to the journal, replacing any earlier journal. The entries
+   * must include all those written to the journal before.
+   *
+   * @param text The Tellico XML for the modified entries, in UTF-8
+   * @param hash The hash of the data file, from @ref fileHash or @ref appliedFileHash
+   * @return Whether the journal was written successfully
+   */
+  bool write(const QByteArray& text, const QByteArray& hash);
+  /**
+   * Copies the entry values from the journal to the collection, if the journal was
+   * written for the current version of the data file.
+   *
+   * @return The IDs of the modified entries
+   */
+  QList<Data::ID> apply(Data::CollPtr coll);
+  /**
+   * Returns the hash of the data file computed by @ref apply, or an empty array if
+   * there was no journal for the file.
+   */
+  const QByteArray& appliedFileHash() const { return m_fileHash; }
+
+private:
+  const QUrl m_url;
+  QByteArray m_fileHash;
+};
+
+} // end namespace
+#endif
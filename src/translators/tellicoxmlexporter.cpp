@@ -372,18 +372,23 @@ void TellicoXMLExporter::exportImageXML(QDomDocument& dom_, QDomElement& parent_
 
   QDomElement imgElem = dom_.createElement(QStringLiteral("image"));
   if(m_includeImages) {
-    const Data::Image& img = ImageFactory::imageById(id_);
-    if(img.isNull()) {
+    // the encoded data is written directly, only loading the image if the size is not known
+    const Data::ImageInfo& info = ImageFactory::imageInfo(id_);
+    if(info.isNull()) {
+      return;
+    }
+    const QByteArray data = ImageFactory::imageData(id_);
+    if(data.isEmpty()) {
       return;
     }
-    imgElem.setAttribute(QStringLiteral("format"), QLatin1String(img.format()));
-    imgElem.setAttribute(QStringLiteral("id"),     QString(img.id()));
-    imgElem.setAttribute(QStringLiteral("width"),  img.width());
-    imgElem.setAttribute(QStringLiteral("height"), img.height());
-    if(img.linkOnly()) {
+    imgElem.setAttribute(QStringLiteral("format"), QLatin1String(info.format));
+    imgElem.setAttribute(QStringLiteral("id"),     QString(info.id));
+    imgElem.setAttribute(QStringLiteral("width"),  info.width());
+    imgElem.setAttribute(QStringLiteral("height"), info.height());
+    if(info.linkOnly) {
       imgElem.setAttribute(QStringLiteral("link"), QStringLiteral("true"));
     }
-    QByteArray imgText = img.byteArray().toBase64();
+    QByteArray imgText = data.toBase64();
     imgElem.appendChild(dom_.createTextNode(QLatin1String(imgText)));
   } else {
     const Data::ImageInfo& info = ImageFactory::imageInfo(id_);
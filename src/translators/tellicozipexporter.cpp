@@ -119,14 +119,14 @@ bool TellicoZipExporter::exec() {
           myLog() << "not copying linked image: " << id;
           continue;
         }
-        const Data::Image& img = ImageFactory::imageById(id);
+        // the encoded data gets copied directly, without loading the image
+        const QByteArray ba = ImageFactory::imageData(id);
         // if no image, continue
-        if(img.isNull()) {
+        if(ba.isEmpty()) {
           myWarning() << "no image found for " << imageField->title() << " field";
           myWarning() << "...for the entry titled " << entry->title();
           continue;
         }
-        QByteArray ba = img.byteArray();
 //        myDebug() << "adding image id = " << it->field(fIt);
         zip.writeFile(imagesDir + id, ba);
         imageSet.add(id);
@@ -26,7 +26,6 @@
 #include "xslthandler.h"
 #include "tellicoxmlexporter.h"
 #include "../collection.h"
-#include "../core/filehandler.h"
 
 #include <KLocalizedString>
 #include <KUrlRequester>
@@ -55,7 +54,15 @@ QString XSLTExporter::fileFilter() const {
 }
 
 bool XSLTExporter::exec() {
-  QUrl u = m_URLRequester->url();
+  QUrl u = m_URLRequester ? m_URLRequester->url() : m_xsltFile;
+  if(u.isEmpty() || !u.isValid()) {
+    return false;
+  }
+  return writeTextURL();
+}
+
+bool XSLTExporter::writeText(QTextStream& ts_) {
+  QUrl u = m_URLRequester ? m_URLRequester->url() : m_xsltFile;
   if(u.isEmpty() || !u.isValid()) {
     return false;
   }
@@ -68,10 +75,11 @@ bool XSLTExporter::exec() {
   TellicoXMLExporter exporter(collection());
   exporter.setEntries(entries());
   exporter.setFields(fields());
-  exporter.setOptions(options());
+  // the intermediate document is always utf-8, the output encoding is set by the stream
+  exporter.setOptions(options() | Export::ExportUTF8);
   QDomDocument dom = exporter.exportXML();
-  return FileHandler::writeTextURL(url(), handler.applyStylesheet(dom.toString()),
-                                   options() & ExportUTF8, options() & Export::ExportForce);
+  // the stylesheet needs the whole document, but the result goes straight to the stream
+  return handler.applyStylesheet(dom.toByteArray(), ts_);
 }
 
 QWidget* XSLTExporter::widget(QWidget* parent_) {
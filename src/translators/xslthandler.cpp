@@ -25,11 +25,14 @@
 #include "xslthandler.h"
 #include "../tellico_debug.h"
 #include "../utils/string_utils.h"
+#include "../utils/tracer.h"
 
 #include <QUrl>
 
 #include <QDomDocument>
 #include <QTextCodec>
+#include <QScopedPointer>
+#include <QTextStream>
 #include <QVector>
 
 extern "C" {
@@ -58,6 +61,26 @@ static int closeQString(void* context) {
   return 0;
 }
 
+namespace {
+  // the decoder keeps any multi-byte character split between two buffers
+  struct TextStreamContext {
+    QTextStream* stream;
+    QTextDecoder* decoder;
+  };
+}
+
+static int writeToTextStream(void* context, const char* buffer, int len) {
+  TextStreamContext* c = static_cast<TextStreamContext*>(context);
+  *c->stream << c->decoder->toUnicode(buffer, len);
+  return len;
+}
+
+static int closeTextStream(void* context) {
+  TextStreamContext* c = static_cast<TextStreamContext*>(context);
+  *c->stream << QLatin1Char('\n');
+  return 0;
+}
+
 using Tellico::XSLTHandler;
 
 XSLTHandler::XMLOutputBuffer::XMLOutputBuffer() {
@@ -234,12 +257,96 @@ QString XSLTHandler::applyStylesheet(const QString& text_) {
   return process(docIn);
 }
 
+bool XSLTHandler::applyStylesheet(const QByteArray& data_, QTextStream& ts_) {
+  xmlDocPtr docOut = transform(data_);
+  if(!docOut) {
+    return false;
+  }
+
+  QScopedPointer<QTextDecoder> decoder(QTextCodec::codecForName("UTF-8")->makeDecoder());
+  TextStreamContext context;
+  context.stream = &ts_;
+  context.decoder = decoder.data();
+  xmlOutputBufferPtr output = xmlOutputBufferCreateIO((xmlOutputWriteCallback)writeToTextStream,
+                                                      (xmlOutputCloseCallback)closeTextStream,
+                                                      &context, nullptr);
+  bool success = false;
+  if(output) {
+    success = xsltSaveResultTo(output, docOut, m_stylesheet) > -1;
+    if(!success) {
+      myDebug() << "error saving output buffer!";
+    }
+    xmlOutputBufferClose(output); // also flushes
+  } else {
+    myWarning() << "error writing output buffer!";
+  }
+
+  xmlFreeDoc(docOut);
+  return success;
+}
+
+xmlDocPtr XSLTHandler::transform(const QByteArray& data_) {
+  if(!m_stylesheet) {
+    myDebug() << "null stylesheet pointer!";
+    return nullptr;
+  }
+  if(data_.isEmpty()) {
+    myDebug() << "XSLTHandler::transform() - empty input";
+    return nullptr;
+  }
+
+  xmlDocPtr docIn = xmlReadMemory(data_.constData(), data_.size(), nullptr, nullptr, xml_options);
+  if(!docIn) {
+    myDebug() << "XSLTHandler::transform() - error parsing input data!";
+    return nullptr;
+  }
+  xmlDocPtr docOut = applyStylesheetToDoc(docIn);
+  xmlFreeDoc(docIn);
+  return docOut;
+}
+
+xmlDocPtr XSLTHandler::transform(xmlDocPtr docIn_) {
+  if(!m_stylesheet) {
+    myDebug() << "null stylesheet pointer!";
+    return nullptr;
+  }
+  if(!docIn_) {
+    myDebug() << "XSLTHandler::transform() - null input document";
+    return nullptr;
+  }
+  return applyStylesheetToDoc(docIn_);
+}
+
 QString XSLTHandler::process(xmlDocPtr docIn) {
   if(!docIn) {
     myDebug() << "XSLTHandler::applyStylesheet() - error parsing input string!";
     return QString();
   }
 
+  xmlDocPtr docOut = applyStylesheetToDoc(docIn);
+  xmlFreeDoc(docIn);
+  docIn = nullptr;
+
+  if(!docOut) {
+    return QString();
+  }
+
+  XMLOutputBuffer output;
+  if(output.isValid()) {
+    int num_bytes = xsltSaveResultTo(output.buffer(), docOut, m_stylesheet);
+    if(num_bytes == -1) {
+      myDebug() << "error saving output buffer!";
+    }
+  }
+
+  xmlFreeDoc(docOut);
+  docOut = nullptr;
+
+  return output.result();
+}
+
+xmlDocPtr XSLTHandler::applyStylesheetToDoc(xmlDocPtr docIn) {
+  TRACE_SCOPE("xslt", "applyStylesheet");
   QVector<const char*> params(2*m_params.count() + 1);
   params[0] = nullptr;
   QHash<QByteArray, QByteArray>::ConstIterator it = m_params.constBegin();
@@ -257,26 +364,10 @@ QString XSLTHandler::process(xmlDocPtr docIn) {
     delete[] params[i];
   }
 
-  xmlFreeDoc(docIn);
-  docIn = nullptr;
-
   if(!docOut) {
     myDebug() << "error applying stylesheet!";
-    return QString();
-  }
-
-  XMLOutputBuffer output;
-  if(output.isValid()) {
-    int num_bytes = xsltSaveResultTo(output.buffer(), docOut, m_stylesheet);
-    if(num_bytes == -1) {
-      myDebug() << "error saving output buffer!";
-    }
   }
-
-  xmlFreeDoc(docOut);
-  docOut = nullptr;
-
-  return output.result();
+  return docOut;
 }
 
 //static
@@ -39,6 +39,7 @@ extern "C" {
 
 class QUrl;
 class QDomDocument;
+class QTextStream;
 
 namespace Tellico {
 
@@ -106,12 +107,36 @@ public:
    * @return The transformed text
    */
   QString applyStylesheet(const QString& text);
+  /**
+   * Processes raw XML data through the XSLT transformation, writing the result to
+   * a text stream as it is serialized instead of collecting it in a string.
+   *
+   * @param data The XML data to be transformed
+   * @param ts The stream for the transformed text
+   * @return Whether the transformation succeeded
+   */
+  bool applyStylesheet(const QByteArray& data, QTextStream& ts);
+  /**
+   * Processes raw XML data through the XSLT transformation, letting libxml2 detect the
+   * encoding. The result document is returned without being serialized, and the caller
+   * is responsible for freeing it with xmlFreeDoc().
+   *
+   * @param data The XML data to be transformed
+   * @return The transformed document, or null on error
+   */
+  xmlDocPtr transform(const QByteArray& data);
+  /**
+   * Processes a document through the XSLT transformation, for chaining stylesheets.
+   * The input document is not freed.
+   */
+  xmlDocPtr transform(xmlDocPtr doc);
 
   static QDomDocument& setLocaleEncoding(QDomDocument& dom);
 
 private:
   void init();
   QString process(xmlDocPtr docIn);
+  xmlDocPtr applyStylesheetToDoc(xmlDocPtr docIn);
 
   xsltStylesheetPtr m_stylesheet;
 
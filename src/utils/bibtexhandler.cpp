@@ -31,6 +31,7 @@
 #include "../tellico_debug.h"
 
 #include <QUrl>
+#include <QMutexLocker>
 
 #include <QDomDocument>
 
@@ -39,7 +40,10 @@
 
 using Tellico::BibtexHandler;
 
-BibtexHandler::StringListHash BibtexHandler::s_utf8LatexMap;
+Tellico::StringReplacer BibtexHandler::s_latexToUtf8;
+Tellico::StringReplacer BibtexHandler::s_utf8ToLatex;
+QAtomicInt BibtexHandler::s_mapsLoaded;
+QMutex BibtexHandler::s_mapsMutex;
 BibtexHandler::QuoteStyle BibtexHandler::s_quoteStyle = BibtexHandler::BRACES;
 const QRegExp BibtexHandler::s_badKeyChars(QLatin1String("[^0-9a-zA-Z-]"));
 
@@ -145,41 +149,47 @@ void BibtexHandler::loadTranslationMaps() {
     // to represent a character in LaTex.
     QString s = keyList.item(i).toElement().attribute(QStringLiteral("char"));
     for(int j = 0; j < strList.count(); ++j) {
-      s_utf8LatexMap[s].append(strList.item(j).toElement().text());
+      const QString latex = strList.item(j).toElement().text();
+      s_latexToUtf8.add(latex, s);
+      // the first string is the correct representation, used when exporting
+      if(j == 0) {
+        s_utf8ToLatex.add(s, latex);
+      }
 //      myDebug() << s << " = " << strList.item(j).toElement().text();
     }
   }
 }
 
 QString BibtexHandler::importText(char* text_) {
-  QString str = QString::fromUtf8(text_);
+  initTranslationMaps();
 
-  if(s_utf8LatexMap.isEmpty()) {
-    loadTranslationMaps();
-  }
-
-  for(StringListHash::ConstIterator it = s_utf8LatexMap.constBegin(); it != s_utf8LatexMap.constEnd(); ++it) {
-    foreach(const QString& word, it.value()) {
-      str.replace(word, it.key());
-    }
-  }
+  // every translation is made in a single pass through the string
+  QString str = s_latexToUtf8.replace(QString::fromUtf8(text_));
 
   // now replace capitalized letters, such as {X}
   // but since we don't want to turn "... X" into "... {X}" later when exporting
   // we need to lower-case any capitalized text after the first letter that is
   // NOT contained in braces
+  return removeCapitalBraces(str);
+}
 
-  QRegExp rx(QStringLiteral("\\{([A-Z]+)\\}"));
-  rx.setMinimal(true);
-  str.replace(rx, QStringLiteral("\\1"));
-
-  return str;
+bool BibtexHandler::initTranslationMaps() {
+  // values are cleaned on background threads too, so the maps are loaded under a lock
+  // and only read after that. Loading is tried again until the map file is found
+  if(!s_mapsLoaded.loadAcquire()) {
+    QMutexLocker locker(&s_mapsMutex);
+    if(!s_mapsLoaded.load()) {
+      loadTranslationMaps();
+      if(!s_latexToUtf8.isEmpty()) {
+        s_mapsLoaded.storeRelease(1);
+      }
+    }
+  }
+  return !s_latexToUtf8.isEmpty();
 }
 
 QString BibtexHandler::exportText(const QString& text_, const QStringList& macros_) {
-  if(s_utf8LatexMap.isEmpty()) {
-    loadTranslationMaps();
-  }
+  initTranslationMaps();
 
   QChar lquote, rquote;
   switch(s_quoteStyle) {
@@ -193,11 +203,7 @@ QString BibtexHandler::exportText(const QString& text_, const QStringList& macro
       break;
   }
 
-  QString text = text_;
-
-  for(StringListHash::ConstIterator it = s_utf8LatexMap.constBegin(); it != s_utf8LatexMap.constEnd(); ++it) {
-    text.replace(it.key(), it.value()[0]);
-  }
+  QString text = s_utf8ToLatex.replace(text_);
 
   if(macros_.isEmpty()) {
     return lquote + addBraces(text) + rquote;
@@ -230,15 +236,64 @@ QString BibtexHandler::exportText(const QString& text_, const QStringList& macro
 }
 
 QString& BibtexHandler::cleanText(QString& text_) {
+  initTranslationMaps();
+  // first translate the LaTeX characters, then strip whatever commands are left
+  text_ = s_latexToUtf8.replace(text_);
+  if(text_.indexOf(QLatin1Char('\\')) == -1 &&
+     text_.indexOf(QLatin1Char('{')) == -1 &&
+     text_.indexOf(QLatin1Char('}')) == -1) {
+    return text_;
+  }
+
   // FIXME: need to improve this for removing all Latex entities
-//  QRegExp rx(QLatin1String("(?=[^\\\\])\\\\.+\\{"));
-  QRegExp rx(QLatin1String("\\\\.+\\{"));
-  rx.setMinimal(true);
-  text_.remove(rx);
-  text_.remove(QRegExp(QLatin1String("[{}]")));
+  // remove a backslash and everything up to the next opening brace, along with all braces
+  QString text;
+  text.reserve(text_.length());
+  const int length = text_.length();
+  for(int i = 0; i < length; ++i) {
+    const QChar c = text_.at(i);
+    if(c == QLatin1Char('\\')) {
+      // the command has at least one character, which could even be a brace
+      const int pos = text_.indexOf(QLatin1Char('{'), i+2);
+      if(pos > -1) {
+        i = pos;
+        continue;
+      }
+    }
+    if(c != QLatin1Char('{') && c != QLatin1Char('}')) {
+      text += c;
+    }
+  }
+  text_ = text;
   return text_;
 }
 
+// remove the braces around runs of capital letters, such as {X}
+QString BibtexHandler::removeCapitalBraces(const QString& text_) {
+  int pos = text_.indexOf(QLatin1Char('{'));
+  if(pos == -1) {
+    return text_;
+  }
+  QString text;
+  text.reserve(text_.length());
+  const int length = text_.length();
+  int copied = 0;
+  for( ; pos > -1 && pos < length; pos = text_.indexOf(QLatin1Char('{'), pos+1)) {
+    int end = pos + 1;
+    while(end < length && text_.at(end) >= QLatin1Char('A') && text_.at(end) <= QLatin1Char('Z')) {
+      ++end;
+    }
+    if(end > pos + 1 && end < length && text_.at(end) == QLatin1Char('}')) {
+      text += text_.midRef(copied, pos - copied);
+      text += text_.midRef(pos + 1, end - pos - 1);
+      copied = end + 1;
+      pos = end;
+    }
+  }
+  text += text_.midRef(copied);
+  return text;
+}
+
 // add braces around capital letters
 QString BibtexHandler::addBraces(const QString& text_) {
   QString text = text_;
@@ -26,10 +26,13 @@
 #define TELLICO_BIBTEXHANDLER_H
 
 #include "../datavectors.h"
+#include "stringreplacer.h"
 
 #include <QStringList>
 #include <QHash>
 #include <QRegExp>
+#include <QAtomicInt>
+#include <QMutex>
 
 namespace Tellico {
 
@@ -42,6 +45,14 @@ public:
   static QStringList bibtexKeys(const Data::EntryList& entries);
   static QString bibtexKey(Data::EntryPtr entry);
   static QString importText(char* text);
+  /**
+   * Loads the LaTeX translation maps, unless they are already loaded. The maps are
+   * only loaded once, so importText() and cleanText() may be called from more than one
+   * thread at a time.
+   *
+   * @return Whether the maps are available
+   */
+  static bool initTranslationMaps();
   static QString exportText(const QString& text, const QStringList& macros);
   /**
    * Strips the text of all vestiges of LaTeX.
@@ -54,13 +65,17 @@ public:
   static QuoteStyle s_quoteStyle;
 
 private:
-  typedef QHash<QString, QStringList> StringListHash;
-
   static QString bibtexKey(const QString& author, const QString& title, const QString& year);
   static void loadTranslationMaps();
   static QString addBraces(const QString& string);
+  static QString removeCapitalBraces(const QString& text);
 
-  static StringListHash s_utf8LatexMap;
+  // LaTeX to UTF-8, with every representation of each character
+  static StringReplacer s_latexToUtf8;
+  // UTF-8 to LaTeX, using the preferred representation
+  static StringReplacer s_utf8ToLatex;
+  static QAtomicInt s_mapsLoaded;
+  static QMutex s_mapsMutex;
   static const QRegExp s_badKeyChars;
 };
 
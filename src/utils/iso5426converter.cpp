@@ -33,7 +33,7 @@
 // code, and including a large portion of it here
 
 #include "iso5426converter.h"
-#include "../tellico_debug.h"
+#include "isocharsetdecoder.h"
 
 #include <QString>
 #include <QByteArray>
@@ -41,49 +41,21 @@
 using Tellico::Iso5426Converter;
 
 QString Iso5426Converter::toUtf8(const QByteArray& text_) {
-  const uint len = text_.length();
-  QString result;
-  result.reserve(len);
-  uint pos = 0;
-  for(uint i = 0; i < len; ++i) {
-    uchar c = text_[i];
-    if(isAscii(c)) {
-      result[pos++] = c;
-    } else if(isCombining(c) && hasNext(i, len)) {
-      // this is a hack
-      // use the diaeresis instead of umlaut
-      // works for SUDOC
-      if(c == 0xC9) {
-        c = 0xC8;
-      }
-      QChar d = getCombiningChar(c * 256 + text_[i + 1]);
-      if(!d.isNull()) {
-        result[pos++] = d;
-        ++i;
-      } else {
-        result[pos++] = getChar(c);
-      }
-    } else {
-      result[pos++] = getChar(c);
-    }
-  }
-  result.squeeze();
-  return result;
-}
-
-inline
-bool Iso5426Converter::hasNext(uint pos, uint len) {
-  return pos < (len - 1);
+  return decoder().decode(text_);
 }
 
-inline
-bool Iso5426Converter::isAscii(uchar c) {
-  return c <= 0x7F;
+const Tellico::IsoCharsetDecoder& Iso5426Converter::decoder() {
+  static const IsoCharsetDecoder iso5426 = makeDecoder();
+  return iso5426;
 }
 
-inline
-bool Iso5426Converter::isCombining(uchar c) {
-  return c >= 0xC0 && c <= 0xDF;
+Tellico::IsoCharsetDecoder Iso5426Converter::makeDecoder() {
+  IsoCharsetDecoder decoder(&getChar, &getCombiningChar);
+  // this is a hack
+  // use the diaeresis instead of umlaut
+  // works for SUDOC
+  decoder.setCombiningAlias(0xC9, 0xC8);
+  return decoder;
 }
 
 // Source : http://www.itscj.ipsj.or.jp/ISO-IR/053.pdf
@@ -889,7 +861,6 @@ QChar Iso5426Converter::getCombiningChar(uint c) {
   // 5/15 right half of double tilde
 
   default:
-    myDebug() << "no match for " << c;
     return QChar();
   }
 }
@@ -32,6 +32,7 @@ class QChar;
 #include <qglobal.h>
 
 namespace Tellico {
+  class IsoCharsetDecoder;
 
 /**
  * @author Robby Stephenson
@@ -41,10 +42,8 @@ public:
   static QString toUtf8(const QByteArray& text);
 
 private:
-  static bool hasNext(uint pos, uint len);
-  static bool isAscii(uchar c);
-  static bool isCombining(uchar c);
-
+  static const IsoCharsetDecoder& decoder();
+  static IsoCharsetDecoder makeDecoder();
   static QChar getChar(uchar c);
   static QChar getCombiningChar(uint i);
 };
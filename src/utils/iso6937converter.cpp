@@ -33,7 +33,7 @@
 // code, and including a large portion of it here
 
 #include "iso6937converter.h"
-#include "../tellico_debug.h"
+#include "isocharsetdecoder.h"
 
 #include <QString>
 #include <QByteArray>
@@ -41,43 +41,12 @@
 using Tellico::Iso6937Converter;
 
 QString Iso6937Converter::toUtf8(const QByteArray& text_) {
-  const uint len = text_.length();
-  QString result;
-  result.reserve(len);
-  uint pos = 0;
-  for(uint i = 0; i < len; ++i) {
-    uchar c = text_[i];
-    if(isAscii(c)) {
-      result[pos++] = c;
-    } else if(isCombining(c) && hasNext(i, len)) {
-      QChar d = getCombiningChar(c * 256 + text_[i + 1]);
-      if(!d.isNull()) {
-        result[pos++] = d;
-        ++i;
-      } else {
-        result[pos++] = getChar(c);
-      }
-    } else {
-      result[pos++] = getChar(c);
-    }
-  }
-  result.squeeze();
-  return result;
-}
-
-inline
-bool Iso6937Converter::hasNext(uint pos, uint len) {
-  return pos < (len - 1);
-}
-
-inline
-bool Iso6937Converter::isAscii(uchar c) {
-  return c <= 0x7F;
+  return decoder().decode(text_);
 }
 
-inline
-bool Iso6937Converter::isCombining(uchar c) {
-  return c >= 0xC0 && c <= 0xDF;
+const Tellico::IsoCharsetDecoder& Iso6937Converter::decoder() {
+  static const IsoCharsetDecoder iso6937(&getChar, &getCombiningChar);
+  return iso6937;
 }
 
 // Source : http://anubis.dkuug.dk/JTC1/SC2/WG3/docs/6937cd.pdf
@@ -604,7 +573,6 @@ QChar Iso6937Converter::getCombiningChar(uint c) {
     return 0x017E; // LATIN SMALL LETTER Z WITH CARON
 
   default:
-    myDebug() << "no match for " << c;
     return QChar();
   }
 }
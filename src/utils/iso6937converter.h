@@ -30,6 +30,7 @@ class QString;
 class QChar;
 
 namespace Tellico {
+  class IsoCharsetDecoder;
 
 /**
  * @author Robby Stephenson
@@ -39,10 +40,7 @@ public:
   static QString toUtf8(const QByteArray& text);
 
 private:
-  static bool hasNext(unsigned int pos, unsigned int len);
-  static bool isAscii(unsigned char c);
-  static bool isCombining(unsigned char c);
-
+  static const IsoCharsetDecoder& decoder();
   static QChar getChar(unsigned char c);
   static QChar getCombiningChar(unsigned int c);
 };
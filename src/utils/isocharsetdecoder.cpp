@@ -0,0 +1,109 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "isocharsetdecoder.h"
+#include "../tellico_debug.h"
+
+#include <QString>
+#include <QByteArray>
+
+#include <cstring>
+
+using Tellico::IsoCharsetDecoder;
+
+namespace {
+  static const int ASCII_BLOCK_SIZE = 16;
+
+  inline bool isAsciiBlock(const uchar* p_) {
+    quint64 a, b;
+    std::memcpy(&a, p_, sizeof(a));
+    std::memcpy(&b, p_ + sizeof(a), sizeof(b));
+    return ((a | b) & Q_UINT64_C(0x8080808080808080)) == 0;
+  }
+}
+
+IsoCharsetDecoder::IsoCharsetDecoder(CharFunction charFunction_, CombiningCharFunction combiningCharFunction_) {
+  for(int c = 0; c < 256; ++c) {
+    m_chars[c] = c < 0x80 ? c : charFunction_(c).unicode();
+  }
+  for(int c = COMBINING_FIRST; c <= COMBINING_LAST; ++c) {
+    for(int next = 0; next < 256; ++next) {
+      // the combining sequences are all diacritic + ASCII
+      m_combiningChars[c - COMBINING_FIRST][next] = next < 0x80 ? combiningCharFunction_(c * 256 + next).unicode() : 0;
+    }
+  }
+}
+
+void IsoCharsetDecoder::setCombiningAlias(uchar diacritic_, uchar alias_) {
+  Q_ASSERT(diacritic_ >= COMBINING_FIRST && diacritic_ <= COMBINING_LAST);
+  Q_ASSERT(alias_ >= COMBINING_FIRST && alias_ <= COMBINING_LAST);
+  std::memcpy(m_combiningChars[diacritic_ - COMBINING_FIRST],
+              m_combiningChars[alias_ - COMBINING_FIRST],
+              sizeof(m_combiningChars[0]));
+}
+
+QString IsoCharsetDecoder::decode(const QByteArray& text_) const {
+  const int len = text_.length();
+  // never more characters than bytes
+  QString result(len, Qt::Uninitialized);
+  ushort* const begin = reinterpret_cast<ushort*>(result.data());
+  ushort* out = begin;
+
+  const uchar* in = reinterpret_cast<const uchar*>(text_.constData());
+  const uchar* const end = in + len;
+  while(in < end) {
+    // most of the text is plain ASCII, so copy it straight across a block at a time
+    while(end - in >= ASCII_BLOCK_SIZE && isAsciiBlock(in)) {
+      for(int i = 0; i < ASCII_BLOCK_SIZE; ++i) {
+        out[i] = in[i];
+      }
+      in += ASCII_BLOCK_SIZE;
+      out += ASCII_BLOCK_SIZE;
+    }
+    if(in == end) {
+      break;
+    }
+
+    const uchar c = *in;
+    if(c < 0x80) {
+      *out++ = c;
+      ++in;
+      continue;
+    }
+    if(c >= COMBINING_FIRST && c <= COMBINING_LAST && in + 1 < end) {
+      const ushort d = m_combiningChars[c - COMBINING_FIRST][in[1]];
+      if(d) {
+        *out++ = d;
+        in += 2;
+        continue;
+      }
+      myDebug() << "no match for" << (c * 256 + in[1]);
+    }
+    *out++ = m_chars[c];
+    ++in;
+  }
+
+  result.resize(out - begin);
+  return result;
+}
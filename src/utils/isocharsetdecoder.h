@@ -0,0 +1,66 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_ISOCHARSETDECODER_H
+#define TELLICO_ISOCHARSETDECODER_H
+
+#include <QChar>
+
+class QByteArray;
+class QString;
+
+namespace Tellico {
+
+/**
+ * Decodes the ISO 5426 and ISO 6937 character sets from lookup tables, which are
+ * filled once from the character functions of the converters.
+ *
+ * Both character sets are ASCII compatible, with combining diacritics in 0xC0-0xDF
+ * preceding the base character.
+ */
+class IsoCharsetDecoder {
+public:
+  typedef QChar (*CharFunction)(uchar c);
+  typedef QChar (*CombiningCharFunction)(uint c);
+
+  IsoCharsetDecoder(CharFunction charFunction, CombiningCharFunction combiningCharFunction);
+
+  QString decode(const QByteArray& text) const;
+  /**
+   * Uses the combinations of another diacritic for the given one.
+   */
+  void setCombiningAlias(uchar diacritic, uchar alias);
+
+private:
+  static const uchar COMBINING_FIRST = 0xC0;
+  static const uchar COMBINING_LAST = 0xDF;
+
+  ushort m_chars[256];
+  // null where the diacritic does not combine with the next byte
+  ushort m_combiningChars[COMBINING_LAST - COMBINING_FIRST + 1][256];
+};
+
+} // end namespace
+
+#endif
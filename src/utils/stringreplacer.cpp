@@ -0,0 +1,111 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "stringreplacer.h"
+
+using Tellico::StringReplacer;
+
+StringReplacer::StringReplacer() {
+  clear();
+}
+
+void StringReplacer::clear() {
+  m_nodes.clear();
+  m_nodes.append(Node()); // the root node
+  m_values.clear();
+}
+
+void StringReplacer::add(const QString& from_, const QString& to_) {
+  if(from_.isEmpty()) {
+    return;
+  }
+  int node = 0;
+  foreach(const QChar c, from_) {
+    int next = m_nodes.at(node).children.value(c, -1);
+    if(next == -1) {
+      next = m_nodes.count();
+      // append before taking the reference, the vector might reallocate
+      m_nodes.append(Node());
+      m_nodes[node].children.insert(c, next);
+    }
+    node = next;
+  }
+  if(m_nodes.at(node).value == -1) {
+    m_nodes[node].value = m_values.count();
+    m_values.append(to_);
+  }
+}
+
+QString StringReplacer::replace(const QString& text_) const {
+  if(isEmpty()) {
+    return text_;
+  }
+
+  const QHash<QChar, int>& roots = m_nodes.at(0).children;
+  const int length = text_.length();
+  QString result;
+  bool replaced = false;
+  int copied = 0; // text before this position is already in the result
+  int pos = 0;
+  while(pos < length) {
+    int node = roots.value(text_.at(pos), -1);
+    if(node == -1) {
+      ++pos;
+      continue;
+    }
+    // follow the trie as far as possible, remembering the longest match
+    int matchValue = -1;
+    int matchEnd = pos;
+    for(int i = pos + 1; ; ++i) {
+      if(m_nodes.at(node).value > -1) {
+        matchValue = m_nodes.at(node).value;
+        matchEnd = i;
+      }
+      if(i == length) {
+        break;
+      }
+      node = m_nodes.at(node).children.value(text_.at(i), -1);
+      if(node == -1) {
+        break;
+      }
+    }
+    if(matchValue == -1) {
+      ++pos;
+      continue;
+    }
+    if(!replaced) {
+      result.reserve(length);
+      replaced = true;
+    }
+    result += text_.midRef(copied, pos - copied);
+    result += m_values.at(matchValue);
+    pos = copied = matchEnd;
+  }
+
+  if(!replaced) {
+    return text_;
+  }
+  result += text_.midRef(copied);
+  return result;
+}
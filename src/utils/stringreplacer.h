@@ -0,0 +1,72 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_STRINGREPLACER_H
+#define TELLICO_STRINGREPLACER_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+
+namespace Tellico {
+
+/**
+ * The StringReplacer replaces any number of strings at once. The strings are compiled
+ * into a character trie, and the text is scanned a single time from left to right,
+ * taking the longest match at each position. Replaced text is never matched again.
+ */
+class StringReplacer {
+public:
+  StringReplacer();
+
+  bool isEmpty() const { return m_values.isEmpty(); }
+  void clear();
+  /**
+   * Adds a string to be replaced. If the string was already added, the first
+   * replacement is kept.
+   *
+   * @param from The string to be replaced
+   * @param to The replacement
+   */
+  void add(const QString& from, const QString& to);
+  /**
+   * Returns the text with every match replaced. When nothing matches, the text
+   * itself is returned without a copy.
+   */
+  QString replace(const QString& text) const;
+
+private:
+  struct Node {
+    Node() : value(-1) {}
+    QHash<QChar, int> children;
+    int value; // index of the replacement, or -1 if no string ends here
+  };
+
+  QVector<Node> m_nodes;
+  QStringList m_values;
+};
+
+} // end namespace
+#endif
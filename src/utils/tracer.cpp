@@ -0,0 +1,213 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "tracer.h"
+#include "../tellico_debug.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QFile>
+#include <QScopedPointer>
+#include <QThread>
+#include <QCoreApplication>
+#include <QJsonObject>
+#include <QJsonDocument>
+
+using Tellico::Tracer;
+
+namespace {
+  struct AsyncEvent {
+    const char* category;
+    QByteArray name;
+    qint64 start;
+  };
+
+  class TraceData {
+  public:
+    TraceData() : firstEvent(true) {
+      clock.start();
+      const QByteArray fileName = qgetenv("TELLICO_TRACE_FILE");
+      if(fileName.isEmpty()) {
+        return;
+      }
+      file.reset(new QFile(QFile::decodeName(fileName)));
+      if(!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        myWarning() << "unable to write trace file" << file->fileName();
+        file.reset();
+        return;
+      }
+      // the closing bracket is optional in the trace format, in case the program crashes
+      file->write("[\n");
+    }
+    ~TraceData() {
+      if(file) {
+        file->write("\n]\n");
+      }
+    }
+
+    // must be called with the mutex locked
+    void writeEvent(QJsonObject event_, const char* phase_, qint64 time_) {
+      event_.insert(QStringLiteral("ph"), QLatin1String(phase_));
+      // the trace format uses microseconds
+      event_.insert(QStringLiteral("ts"), time_ / 1000.0);
+      event_.insert(QStringLiteral("pid"), QCoreApplication::applicationPid());
+      event_.insert(QStringLiteral("tid"), static_cast<qint64>(reinterpret_cast<quintptr>(QThread::currentThreadId())));
+      if(!firstEvent) {
+        file->write(",\n");
+      }
+      firstEvent = false;
+      file->write(QJsonDocument(event_).toJson(QJsonDocument::Compact));
+      file->flush();
+    }
+
+    QMutex mutex;
+    QElapsedTimer clock;
+    QHash<QByteArray, Tracer::Stat> stats;
+    QHash<const void*, AsyncEvent> asyncEvents;
+    QScopedPointer<QFile> file;
+    bool firstEvent;
+  };
+
+  // thread-safe initialization
+  TraceData& traceData() {
+    static TraceData data;
+    return data;
+  }
+
+  inline QJsonObject traceEvent(const char* category_, const QByteArray& name_) {
+    QJsonObject event;
+    event.insert(QStringLiteral("cat"), QLatin1String(category_));
+    event.insert(QStringLiteral("name"), QString::fromUtf8(name_));
+    return event;
+  }
+
+  inline QString asyncId(const void* id_) {
+    return QStringLiteral("0x") + QString::number(reinterpret_cast<quintptr>(id_), 16);
+  }
+
+  // must be called with the mutex locked
+  Tracer::Stat& statFor(TraceData& data_, const char* category_, const QByteArray& name_) {
+    QHash<QByteArray, Tracer::Stat>::Iterator it = data_.stats.find(name_);
+    if(it == data_.stats.end()) {
+      Tracer::Stat stat;
+      stat.category = QByteArray(category_);
+      stat.name = name_;
+      stat.count = 0;
+      stat.totalTime = 0;
+      stat.maxTime = 0;
+      it = data_.stats.insert(name_, stat);
+    }
+    return it.value();
+  }
+}
+
+Tracer::Scope::Scope(const char* category_, const char* name_) : m_category(category_), m_name(name_),
+    m_start(traceData().clock.nsecsElapsed()) {
+}
+
+Tracer::Scope::~Scope() {
+  const qint64 finish = traceData().clock.nsecsElapsed();
+  // the name is a literal, so there's no need to copy it
+  record(m_category, QByteArray::fromRawData(m_name, qstrlen(m_name)), m_start, finish - m_start);
+}
+
+bool Tracer::isTracing() {
+  return !traceData().file.isNull();
+}
+
+void Tracer::count(const char* category_, const char* name_, qint64 value_) {
+  TraceData& data = traceData();
+  QMutexLocker locker(&data.mutex);
+  Stat& stat = statFor(data, category_, QByteArray::fromRawData(name_, qstrlen(name_)));
+  stat.count += value_;
+  if(data.file) {
+    QJsonObject event = traceEvent(category_, stat.name);
+    QJsonObject args;
+    args.insert(QStringLiteral("value"), stat.count);
+    event.insert(QStringLiteral("args"), args);
+    data.writeEvent(event, "C", data.clock.nsecsElapsed());
+  }
+}
+
+void Tracer::beginAsync(const char* category_, const QByteArray& name_, const void* id_) {
+  TraceData& data = traceData();
+  QMutexLocker locker(&data.mutex);
+  AsyncEvent async;
+  async.category = category_;
+  async.name = name_;
+  async.start = data.clock.nsecsElapsed();
+  data.asyncEvents.insert(id_, async);
+  if(data.file) {
+    QJsonObject event = traceEvent(category_, name_);
+    event.insert(QStringLiteral("id"), asyncId(id_));
+    data.writeEvent(event, "b", async.start);
+  }
+}
+
+void Tracer::endAsync(const void* id_) {
+  TraceData& data = traceData();
+  QMutexLocker locker(&data.mutex);
+  if(!data.asyncEvents.contains(id_)) {
+    return;
+  }
+  const AsyncEvent async = data.asyncEvents.take(id_);
+  const qint64 finish = data.clock.nsecsElapsed();
+  Stat& stat = statFor(data, async.category, async.name);
+  ++stat.count;
+  stat.totalTime += finish - async.start;
+  stat.maxTime = qMax(stat.maxTime, finish - async.start);
+  if(data.file) {
+    QJsonObject event = traceEvent(async.category, async.name);
+    event.insert(QStringLiteral("id"), asyncId(id_));
+    data.writeEvent(event, "e", finish);
+  }
+}
+
+QList<Tracer::Stat> Tracer::stats() {
+  TraceData& data = traceData();
+  QMutexLocker locker(&data.mutex);
+  return data.stats.values();
+}
+
+void Tracer::resetStats() {
+  TraceData& data = traceData();
+  QMutexLocker locker(&data.mutex);
+  data.stats.clear();
+}
+
+void Tracer::record(const char* category_, const QByteArray& name_, qint64 start_, qint64 duration_) {
+  TraceData& data = traceData();
+  QMutexLocker locker(&data.mutex);
+  Stat& stat = statFor(data, category_, name_);
+  ++stat.count;
+  stat.totalTime += duration_;
+  stat.maxTime = qMax(stat.maxTime, duration_);
+  if(data.file) {
+    QJsonObject event = traceEvent(category_, name_);
+    event.insert(QStringLiteral("dur"), duration_ / 1000.0);
+    data.writeEvent(event, "X", start_);
+  }
+}
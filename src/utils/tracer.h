@@ -0,0 +1,108 @@
+/***************************************************************************
+    Copyright (C) 2019 Robby Stephenson <robby@periapsis.org>
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public License as        *
+ *   published by the Free Software Foundation; either version 2 of        *
+ *   the License or (at your option) version 3 or any later version        *
+ *   accepted by the membership of KDE e.V. (or its successor approved     *
+ *   by the membership of KDE e.V.), which shall act as a proxy            *
+ *   defined in Section 14 of version 3 of the license.                    *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TELLICO_TRACER_H
+#define TELLICO_TRACER_H
+
+#include <QByteArray>
+#include <QList>
+
+namespace Tellico {
+
+/**
+ * The Tracer keeps timing statistics for the slower operations, such as loading and saving
+ * files, grouping and sorting entries, and fetching from a data source. The statistics are
+ * always collected, and shown in the Performance Statistics panel.
+ *
+ * When the TELLICO_TRACE_FILE environment variable names a file, every timed operation is
+ * also written to it as a trace event, in the JSON format read by chrome://tracing and
+ * similar viewers. The events are written as they happen, so the trace is useful even if
+ * the program does not exit cleanly.
+ *
+ * All the functions may be called from any thread.
+ *
+ * @author Robby Stephenson
+ */
+class Tracer {
+public:
+  struct Stat {
+    QByteArray category;
+    QByteArray name;
+    qint64 count;
+    // all times are in nanoseconds
+    qint64 totalTime;
+    qint64 maxTime;
+  };
+
+  /**
+   * Times the operation until the scope is left. The category and name must be
+   * string literals, or otherwise outlive the program.
+   */
+  class Scope {
+  public:
+    Scope(const char* category, const char* name);
+    ~Scope();
+
+  private:
+    Q_DISABLE_COPY(Scope)
+    const char* m_category;
+    const char* m_name;
+    qint64 m_start;
+  };
+
+  /**
+   * Returns true if the trace events are written to a file
+   */
+  static bool isTracing();
+  /**
+   * Adds to a counter, which has no duration
+   */
+  static void count(const char* category, const char* name, qint64 value = 1);
+  /**
+   * Starts timing an operation which continues in the event loop, such as a network request.
+   * The id must be unique among the operations running at the same time.
+   */
+  static void beginAsync(const char* category, const QByteArray& name, const void* id);
+  /**
+   * Finishes timing an operation started with @ref beginAsync. Nothing is recorded if the
+   * operation was not started.
+   */
+  static void endAsync(const void* id);
+
+  static QList<Stat> stats();
+  static void resetStats();
+
+private:
+  static void record(const char* category, const QByteArray& name, qint64 start, qint64 duration);
+};
+
+} // end namespace
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+/// Times the rest of the enclosing scope
+#define TRACE_SCOPE(category, name) \
+  Tellico::Tracer::Scope TRACE_CONCAT(uniquelyNamedTraceScope, __LINE__)(category, name)
+
+#endif